@@ -0,0 +1,196 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//
+// A small harness for benchmarks that report the spread
+// of their samples. Each result prints as a table row and
+// can be written to a JSON file for tracking over time
+//
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchmarkResult
+{
+    std::string m_Name;
+    std::string m_Unit;
+    size_t m_Samples;
+    double m_Min;
+    double m_Mean;
+    double m_P50;
+    double m_P90;
+    double m_P99;
+    double m_Max;
+};
+
+class BenchmarkHarness
+/*++
+  Takes --json PATH to write results to, --filter TEXT to
+  run only benchmarks whose name contains TEXT and --quick
+  to take fewer samples
+--*/
+{
+public:
+    BenchmarkHarness(
+        int argc,
+        char** argv
+    )
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            {
+                m_JsonPath = argv[++i];
+            }
+            else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            {
+                m_Filter = argv[++i];
+            }
+            else if (strcmp(argv[i], "--quick") == 0)
+            {
+                m_Quick = true;
+            }
+            else
+            {
+                std::cerr << "usage: " << argv[0] << " [--json PATH] [--filter TEXT] [--quick]" << std::endl;
+                m_Valid = false;
+            }
+        }
+        if (!m_Valid)
+        {
+            return;
+        }
+        std::cout << std::left << std::setw(44) << "benchmark" << std::right
+                  << std::setw(8) << "unit"
+                  << std::setw(14) << "p50"
+                  << std::setw(14) << "p90"
+                  << std::setw(14) << "p99"
+                  << std::setw(14) << "max" << std::endl;
+    }
+
+    bool Valid(void) const { return m_Valid; };
+    bool Quick(void) const { return m_Quick; };
+    size_t Samples(const size_t Full) const { return m_Quick ? std::max<size_t>(Full / 10, 3) : Full; };
+
+    bool
+    Enabled(
+        const std::string& Name
+    ) const
+    {
+        return m_Filter.empty() || Name.find(m_Filter) != std::string::npos;
+    }
+
+    void
+    Report(
+        const std::string& Name,
+        const std::string& Unit,
+        std::vector<double> Samples
+    )
+    /*++
+      Summarize Samples. Percentiles are nearest rank, so
+      each is a value that was actually measured
+    --*/
+    {
+        if (Samples.empty())
+        {
+            return;
+        }
+        std::sort(Samples.begin(), Samples.end());
+        double total = 0;
+        for (auto sample : Samples)
+        {
+            total += sample;
+        }
+        auto rank = [&](const double Fraction) {
+            auto index = (size_t)(Fraction * (double)Samples.size() + 0.5);
+            return Samples[std::min(index == 0 ? 0 : index - 1, Samples.size() - 1)];
+        };
+
+        BenchmarkResult result{ Name, Unit, Samples.size(), Samples.front(), total / Samples.size(),
+                                rank(0.5), rank(0.9), rank(0.99), Samples.back() };
+        std::cout << std::left << std::setw(44) << result.m_Name << std::right
+                  << std::setw(8) << result.m_Unit << std::fixed << std::setprecision(1)
+                  << std::setw(14) << result.m_P50
+                  << std::setw(14) << result.m_P90
+                  << std::setw(14) << result.m_P99
+                  << std::setw(14) << result.m_Max << std::endl;
+        m_Results.push_back(std::move(result));
+    }
+
+    int
+    Finish(
+        void
+    )
+    /*++
+      Write the JSON file if one was asked for. The exit
+      code for main
+    --*/
+    {
+        if (m_JsonPath.empty())
+        {
+            return 0;
+        }
+        auto file = fopen(m_JsonPath.c_str(), "w");
+        if (file == nullptr)
+        {
+            std::cerr << "cannot write " << m_JsonPath << std::endl;
+            return 1;
+        }
+        fprintf(file, "{\n  \"context\": {\"cpus\": %u, \"quick\": %s},\n  \"benchmarks\": [",
+                std::thread::hardware_concurrency(), m_Quick ? "true" : "false");
+        for (size_t i = 0; i < m_Results.size(); i++)
+        {
+            auto& result = m_Results[i];
+            fprintf(file, "%s\n    {\"name\": \"%s\", \"unit\": \"%s\", \"samples\": %zu, \"min\": %.3f, \"mean\": %.3f, "
+                          "\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}",
+                    i == 0 ? "" : ",", result.m_Name.c_str(), result.m_Unit.c_str(), result.m_Samples, result.m_Min,
+                    result.m_Mean, result.m_P50, result.m_P90, result.m_P99, result.m_Max);
+        }
+        fputs("\n  ]\n}\n", file);
+        return fclose(file) == 0 ? 0 : 1;
+    }
+
+private:
+    std::string m_JsonPath;
+    std::string m_Filter;
+    bool m_Quick = false;
+    bool m_Valid = true;
+    std::vector<BenchmarkResult> m_Results;
+};
+
+template <typename Body>
+double
+NanosecondsPer(
+    const size_t Operations,
+    Body&& Measured
+)
+/*++
+  Time one call of Measured, averaged over the number of
+  operations it performs
+--*/
+{
+    auto start = Clock::now();
+    Measured();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / Operations;
+}
+
+template <typename T>
+inline void
+DoNotOptimize(
+    T& Value
+)
+/*++
+  Keep the compiler from eliding work on Value
+--*/
+{
+    asm volatile("" : : "r"(&Value) : "memory");
+}
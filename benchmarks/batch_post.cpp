@@ -0,0 +1,87 @@
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "DispatchQueue.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t BATCH_SIZES[] = { 1, 16, 256, 4096 };
+const size_t TOTAL_POSTS = 256 * 1024;
+const size_t POOL_SIZE = 4;
+
+std::atomic<size_t> g_Received;
+
+void
+Receive(
+    void
+)
+{
+    g_Received.fetch_add(1, std::memory_order_relaxed);
+}
+
+double
+Throughput(
+    dispatch::DispatcherBase* Target,
+    const size_t BatchSize
+)
+/*++
+  Tasks per second posted from this foreign thread, one
+  at a time when BatchSize is 1 and with PostTasks
+  otherwise, until every task has run
+--*/
+{
+    g_Received = 0;
+    auto start = Clock::now();
+    for (size_t posted = 0; posted < TOTAL_POSTS; posted += BatchSize)
+    {
+        if (BatchSize == 1)
+        {
+            Target->PostTask(dispatch::bind(&Receive));
+            continue;
+        }
+        dispatch::TaskBatch batch;
+        batch.reserve(BatchSize);
+        for (size_t i = 0; i < BatchSize; i++)
+        {
+            batch.push_back(dispatch::bind(&Receive));
+        }
+        Target->PostTasks(std::move(batch));
+    }
+    while (g_Received.load(std::memory_order_relaxed) < TOTAL_POSTS)
+    {
+        std::this_thread::yield();
+    }
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    return TOTAL_POSTS / elapsed;
+}
+
+int main()
+{
+    auto dispatcher = dispatch::CreateDispatcher("consumer");
+    auto pool = dispatch::CreateDispatchPool("pool", POOL_SIZE);
+    auto stealingPool = dispatch::CreateDispatchPool("stealing pool", POOL_SIZE, dispatch::PoolMode::WORK_STEALING);
+
+    std::cout << std::setw(10) << "batch"
+              << std::setw(22) << "dispatcher tasks/s"
+              << std::setw(22) << "pool tasks/s"
+              << std::setw(22) << "stealing tasks/s" << std::endl;
+
+    for (auto batchSize : BATCH_SIZES)
+    {
+        auto single = Throughput(dispatcher.get(), batchSize);
+        auto roundRobin = Throughput(pool.get(), batchSize);
+        auto stealing = Throughput(stealingPool.get(), batchSize);
+        std::cout << std::setw(10) << batchSize << std::fixed << std::setprecision(0)
+                  << std::setw(22) << single
+                  << std::setw(22) << roundRobin
+                  << std::setw(22) << stealing << std::endl;
+    }
+
+    dispatcher->Stop();
+    pool->Stop();
+    stealingPool->Stop();
+    dispatch::GlobalDispatcherWait();
+}
@@ -0,0 +1,431 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+#include "Harness.hpp"
+
+//
+// The core costs of the library in one run. Pass --json
+// to keep the results, see BenchmarkHarness
+//
+
+const size_t BATCH = 1000;
+const size_t POST_SAMPLES = 200;
+const size_t ROUND_TRIPS = 10000;
+const size_t FANOUT_TASKS = 200000;
+const size_t FANOUT_SAMPLES = 5;
+const size_t DELAYED_SAMPLES = 50;
+const auto DELAY = std::chrono::milliseconds(1);
+const size_t COPY_SAMPLES = 200;
+
+struct Payload
+{
+    size_t m_Value = 0;
+};
+
+//
+// State of the benchmark running right now, only ever
+// touched by one dispatcher at a time
+//
+std::vector<double> g_Samples;
+std::vector<double> g_Expiry;
+size_t g_Wanted;
+size_t g_Ran;
+Clock::time_point g_Started;
+Clock::time_point g_FirstRun;
+std::atomic<size_t> g_Received;
+std::atomic<bool> g_Done;
+dispatch::DispatcherBasePtr g_Peer;
+
+void
+Noop(
+    void
+)
+{
+}
+
+void
+Receive(
+    void
+)
+{
+    g_Received.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+WaitDone(
+    void
+)
+{
+    while (!g_Done.load(std::memory_order_acquire))
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    g_Done = false;
+}
+
+void
+Finished(
+    void
+)
+{
+    g_Done.store(true, std::memory_order_release);
+}
+
+void
+SameThreadSample(
+    void
+)
+/*++
+  Post a batch to ourselves. The next sample is queued
+  behind the batch, so every sample starts on an empty
+  queue
+--*/
+{
+    if (g_Samples.size() == g_Wanted)
+    {
+        Finished();
+        return;
+    }
+    g_Samples.push_back(NanosecondsPer(BATCH, [] {
+        for (size_t i = 0; i < BATCH; i++)
+        {
+            dispatch::PostTaskFast(dispatch::bind(&Noop));
+        }
+    }));
+    dispatch::PostTaskFast(dispatch::bind(&SameThreadSample));
+}
+
+void
+SameThreadPost(
+    BenchmarkHarness& Harness,
+    dispatch::DispatcherBase* Target
+)
+{
+    g_Samples.clear();
+    g_Wanted = Harness.Samples(POST_SAMPLES);
+    Target->PostTask(dispatch::bind(&SameThreadSample));
+    WaitDone();
+    Harness.Report("post/same_thread", "ns/op", g_Samples);
+}
+
+void
+CrossThreadPost(
+    BenchmarkHarness& Harness,
+    dispatch::DispatcherBase* Target
+)
+/*++
+  Time posting a batch from this thread, then let the
+  target drain it before the next
+--*/
+{
+    std::vector<double> samples;
+    g_Received = 0;
+    for (size_t sample = 0; sample < Harness.Samples(POST_SAMPLES); sample++)
+    {
+        samples.push_back(NanosecondsPer(BATCH, [&] {
+            for (size_t i = 0; i < BATCH; i++)
+            {
+                Target->PostTask(dispatch::bind(&Receive));
+            }
+        }));
+        while (g_Received.load(std::memory_order_relaxed) < (sample + 1) * BATCH)
+        {
+            std::this_thread::yield();
+        }
+    }
+    Harness.Report("post/cross_thread", "ns/op", samples);
+}
+
+void Ping(void);
+
+void
+Pong(
+    dispatch::DispatcherBase* Origin
+)
+{
+    Origin->PostTask(dispatch::bind(&Ping));
+}
+
+void
+Ping(
+    void
+)
+{
+    auto now = Clock::now();
+    if (g_Started != Clock::time_point())
+    {
+        g_Samples.push_back(std::chrono::duration<double, std::nano>(now - g_Started).count());
+    }
+    if (g_Samples.size() == g_Wanted)
+    {
+        Finished();
+        return;
+    }
+    g_Started = Clock::now();
+    g_Peer->PostTask(dispatch::bind(&Pong, dispatch::CurrentQueue()));
+}
+
+void
+Replied(
+    void
+)
+{
+    g_Samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - g_Started).count());
+    if (g_Samples.size() == g_Wanted)
+    {
+        Finished();
+        return;
+    }
+    g_Started = Clock::now();
+    g_Peer->PostTaskAndReply(dispatch::bind(&Noop), dispatch::bind(&Replied));
+}
+
+void
+StartRequests(
+    void
+)
+{
+    g_Started = Clock::now();
+    g_Peer->PostTaskAndReply(dispatch::bind(&Noop), dispatch::bind(&Replied));
+}
+
+void
+RoundTrips(
+    BenchmarkHarness& Harness,
+    dispatch::DispatcherBase* Origin,
+    dispatch::DispatcherBasePtr Peer
+)
+{
+    g_Peer = Peer;
+    g_Wanted = Harness.Samples(ROUND_TRIPS);
+    if (Harness.Enabled("roundtrip/ping_pong"))
+    {
+        g_Samples.clear();
+        g_Started = Clock::time_point();
+        Origin->PostTask(dispatch::bind(&Ping));
+        WaitDone();
+        Harness.Report("roundtrip/ping_pong", "ns", g_Samples);
+    }
+    if (Harness.Enabled("roundtrip/task_and_reply"))
+    {
+        g_Samples.clear();
+        Origin->PostTask(dispatch::bind(&StartRequests));
+        WaitDone();
+        Harness.Report("roundtrip/task_and_reply", "ns", g_Samples);
+    }
+    g_Peer = nullptr;
+}
+
+void
+Fanout(
+    BenchmarkHarness& Harness,
+    const char* ModeName,
+    const dispatch::PoolMode Mode,
+    const size_t Producers
+)
+/*++
+  Producers threads post their share of FANOUT_TASKS to
+  a pool at once. Reports tasks per second until all ran
+--*/
+{
+    auto name = std::string("pool/fanout/") + ModeName + "/producers:" + std::to_string(Producers);
+    if (!Harness.Enabled(name))
+    {
+        return;
+    }
+    auto pool = dispatch::CreateDispatchPool("fanout", 0, Mode);
+    std::vector<double> samples;
+    for (size_t sample = 0; sample < Harness.Samples(FANOUT_SAMPLES); sample++)
+    {
+        g_Received = 0;
+        std::atomic<bool> go = false;
+        std::vector<std::thread> threads;
+        for (size_t producer = 0; producer < Producers; producer++)
+        {
+            threads.emplace_back([&, producer] {
+                while (!go.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+                auto share = FANOUT_TASKS / Producers + (producer < FANOUT_TASKS % Producers ? 1 : 0);
+                for (size_t i = 0; i < share; i++)
+                {
+                    pool->PostTask(dispatch::bind(&Receive));
+                }
+            });
+        }
+        auto start = Clock::now();
+        go.store(true, std::memory_order_release);
+        while (g_Received.load(std::memory_order_relaxed) < FANOUT_TASKS)
+        {
+            std::this_thread::yield();
+        }
+        samples.push_back(FANOUT_TASKS / std::chrono::duration<double>(Clock::now() - start).count());
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+    Harness.Report(name, "task/s", samples);
+    pool->Stop();
+    pool->Wait();
+}
+
+void DelayedSample(void);
+
+void
+Expired(
+    void
+)
+/*++
+  All of a batch is due by the time the first one runs,
+  so the spread from first to last is the cost of
+  expiring and running them
+--*/
+{
+    auto now = Clock::now();
+    if (g_Ran++ == 0)
+    {
+        g_FirstRun = now;
+    }
+    if (g_Ran == BATCH)
+    {
+        g_Expiry.push_back(std::chrono::duration<double, std::nano>(now - g_FirstRun).count() / BATCH);
+        DelayedSample();
+    }
+}
+
+void
+DelayedSample(
+    void
+)
+{
+    if (g_Samples.size() == g_Wanted)
+    {
+        Finished();
+        return;
+    }
+    g_Ran = 0;
+    g_Samples.push_back(NanosecondsPer(BATCH, [] {
+        for (size_t i = 0; i < BATCH; i++)
+        {
+            dispatch::PostDelayedTask(dispatch::bind(&Expired), DELAY);
+        }
+    }));
+
+    //
+    // Hold the dispatcher past every deadline so they all
+    // expire together
+    //
+    std::this_thread::sleep_for(DELAY * 2);
+}
+
+void
+Delayed(
+    BenchmarkHarness& Harness,
+    dispatch::DispatcherBase* Target
+)
+{
+    g_Samples.clear();
+    g_Expiry.clear();
+    g_Wanted = Harness.Samples(DELAYED_SAMPLES);
+    Target->PostTask(dispatch::bind(&DelayedSample));
+    WaitDone();
+    Harness.Report("delayed/insert", "ns/op", g_Samples);
+    Harness.Report("delayed/expire", "ns/op", g_Expiry);
+}
+
+template <typename Pointer>
+void
+CopyCost(
+    BenchmarkHarness& Harness,
+    const std::string& Name,
+    Pointer Source
+)
+/*++
+  Copy and release Source BATCH times per sample
+--*/
+{
+    std::vector<double> samples;
+    for (size_t sample = 0; sample < Harness.Samples(COPY_SAMPLES); sample++)
+    {
+        samples.push_back(NanosecondsPer(BATCH, [&] {
+            for (size_t i = 0; i < BATCH; i++)
+            {
+                Pointer copy(Source);
+                DoNotOptimize(copy);
+            }
+        }));
+    }
+    Harness.Report(Name, "ns/op", samples);
+}
+
+void
+Copies(
+    BenchmarkHarness* Harness
+)
+/*++
+  Runs on a dispatcher, where a biased pointer made
+  here is owned
+--*/
+{
+    if (Harness->Enabled("refptr/copy/shared"))
+    {
+        CopyCost(*Harness, "refptr/copy/shared", dispatch::MakeSharedRefPtr<Payload>());
+    }
+    if (Harness->Enabled("refptr/copy/biased"))
+    {
+        CopyCost(*Harness, "refptr/copy/biased", dispatch::MakeBiasedRefPtr<Payload>());
+    }
+    if (Harness->Enabled("refptr/copy/std_shared"))
+    {
+        CopyCost(*Harness, "refptr/copy/std_shared", std::make_shared<Payload>());
+    }
+    Finished();
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkHarness harness(argc, argv);
+    if (!harness.Valid())
+    {
+        return 1;
+    }
+
+    auto dispatcher = dispatch::CreateDispatcher("bench");
+    auto peer = dispatch::CreateDispatcher("bench peer");
+
+    if (harness.Enabled("post/same_thread"))
+    {
+        SameThreadPost(harness, dispatcher.get());
+    }
+    if (harness.Enabled("post/cross_thread"))
+    {
+        CrossThreadPost(harness, dispatcher.get());
+    }
+    RoundTrips(harness, dispatcher.get(), peer);
+
+    auto producers = std::max<size_t>(2, std::thread::hardware_concurrency());
+    for (size_t count = 1; count <= producers; count *= 2)
+    {
+        Fanout(harness, "round_robin", dispatch::PoolMode::ROUND_ROBIN, count);
+        Fanout(harness, "work_stealing", dispatch::PoolMode::WORK_STEALING, count);
+    }
+
+    if (harness.Enabled("delayed/insert") || harness.Enabled("delayed/expire"))
+    {
+        Delayed(harness, dispatcher.get());
+    }
+    dispatcher->PostTask(dispatch::bind(&Copies, &harness));
+    WaitDone();
+
+    dispatcher->Stop();
+    peer->Stop();
+    dispatch::GlobalDispatcherWait();
+    return harness.Finish();
+}
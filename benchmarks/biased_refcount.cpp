@@ -0,0 +1,122 @@
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+#include "SharedRefptr.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t COPIES = 4 * 1000 * 1000;
+const size_t CONTENDERS = 4;
+
+struct Payload
+{
+    size_t m_Value = 1;
+};
+
+template <typename Ptr>
+double
+CopyCost(
+    const Ptr& Source
+)
+/*++
+  ns per copy and release of Source on this thread
+--*/
+{
+    size_t sum = 0;
+    auto start = Clock::now();
+    for (size_t i = 0; i < COPIES; i++)
+    {
+        Ptr copy = Source;
+        sum += copy->m_Value;
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return sum == COPIES ? elapsed / COPIES : 0;
+}
+
+template <typename Ptr>
+double
+ContendedCost(
+    const Ptr& Source
+)
+/*++
+  ns per copy while CONTENDERS foreign threads copy the
+  same pointer, as seen from this thread
+--*/
+{
+    std::atomic<bool> stop = false;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < CONTENDERS; i++)
+    {
+        threads.emplace_back([&]{
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                Ptr copy = Source;
+            }
+        });
+    }
+    auto cost = CopyCost(Source);
+    stop = true;
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    return cost;
+}
+
+std::atomic<bool> g_Done = false;
+dispatch::BiasedRefPtr<Payload> g_Biased;
+
+void
+OnOwner(
+    void
+)
+{
+    auto local = dispatch::MakeSharedRefPtr<Payload>();
+    auto biased = dispatch::MakeBiasedRefPtr<Payload>();
+    auto standard = std::make_shared<Payload>();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(30) << "owner, SharedRefPtr" << std::setw(10) << CopyCost(local) << " ns" << std::endl;
+    std::cout << std::setw(30) << "owner, BiasedRefPtr" << std::setw(10) << CopyCost(biased) << " ns" << std::endl;
+    std::cout << std::setw(30) << "owner, std::shared_ptr" << std::setw(10) << CopyCost(standard) << " ns" << std::endl;
+    std::cout << std::setw(30) << "owner contended, Biased" << std::setw(10) << ContendedCost(biased) << " ns" << std::endl;
+    std::cout << std::setw(30) << "owner contended, std" << std::setw(10) << ContendedCost(standard) << " ns" << std::endl;
+
+    g_Biased = biased;
+    g_Done = true;
+}
+
+int main()
+{
+    auto owner = dispatch::CreateDispatcher("owner");
+    owner->PostTask(dispatch::bind(&OnOwner));
+    while (!g_Done)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    //
+    // From here on this thread is not the owner
+    //
+    auto standard = std::make_shared<Payload>();
+    std::cout << std::setw(30) << "foreign, BiasedRefPtr" << std::setw(10) << CopyCost(g_Biased) << " ns" << std::endl;
+    std::cout << std::setw(30) << "foreign, std::shared_ptr" << std::setw(10) << CopyCost(standard) << " ns" << std::endl;
+
+    //
+    // The owner must outlive the last merge
+    //
+    g_Done = false;
+    owner->PostTask(dispatch::bind([]{ g_Biased = nullptr; g_Done = true; }));
+    while (!g_Done)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    owner->Stop();
+    dispatch::GlobalDispatcherWait();
+}
@@ -0,0 +1,189 @@
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#include "DispatchQueue.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t HOPS = 10;
+const size_t CHAINS = 20000;
+
+std::atomic<size_t> g_Allocations = 0;
+
+void*
+operator new(
+    size_t Size
+)
+{
+    g_Allocations.fetch_add(1, std::memory_order_relaxed);
+    void* allocation = malloc(Size);
+    if (allocation == nullptr)
+    {
+        abort();
+    }
+    return allocation;
+}
+
+void
+operator delete(
+    void* Allocation
+) noexcept
+{
+    free(Allocation);
+}
+
+void
+operator delete(
+    void* Allocation,
+    size_t Size
+) noexcept
+{
+    free(Allocation);
+}
+
+dispatch::DispatcherBasePtr g_A;
+dispatch::DispatcherBasePtr g_B;
+std::atomic<bool> g_Done;
+size_t g_Chains;
+Clock::time_point g_Start;
+size_t g_StartAllocations;
+
+struct Result
+{
+    double m_NsPerChain;
+    double m_AllocationsPerChain;
+};
+
+Result g_Result;
+
+void
+Finish(
+    void
+)
+{
+    auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - g_Start).count();
+    g_Result.m_NsPerChain = elapsed / CHAINS;
+    g_Result.m_AllocationsPerChain = (double)(g_Allocations.load() - g_StartAllocations) / CHAINS;
+    g_Done = true;
+}
+
+//
+// The chain as nested PostTaskAndReply, each call is a
+// hop to B and a hop back to A
+//
+void NestedChain(const size_t Remaining);
+
+void
+NestedChain(
+    const size_t Remaining
+)
+{
+    if (Remaining == 0)
+    {
+        if (++g_Chains == CHAINS)
+        {
+            Finish();
+            return;
+        }
+        NestedChain(HOPS);
+        return;
+    }
+    g_B->PostTaskAndReply(
+        dispatch::bind(&dispatch::DoNothing),
+        dispatch::bind(&NestedChain, Remaining - 2)
+    );
+}
+
+void
+StartNested(
+    void
+)
+{
+    g_Chains = 0;
+    g_StartAllocations = g_Allocations.load();
+    g_Start = Clock::now();
+    NestedChain(HOPS);
+}
+
+//
+// The same chain as a coroutine
+//
+dispatch::Task<void>
+CoroutineChain(
+    void
+)
+{
+    for (size_t hop = 0; hop < HOPS; hop++)
+    {
+        co_await (hop % 2 == 0 ? g_B : g_A)->Schedule();
+    }
+}
+
+dispatch::Task<void>
+CoroutineDriver(
+    void
+)
+{
+    g_StartAllocations = g_Allocations.load();
+    g_Start = Clock::now();
+    for (size_t chain = 0; chain < CHAINS; chain++)
+    {
+        co_await CoroutineChain();
+    }
+    Finish();
+}
+
+Result
+Run(
+    const bool Coroutines
+)
+{
+    g_Done = false;
+    g_A = dispatch::CreateDispatcher("a");
+    g_B = dispatch::CreateDispatcher("b");
+    if (Coroutines)
+    {
+        dispatch::Spawn(g_A.get(), CoroutineDriver());
+    }
+    else
+    {
+        g_A->PostTask(dispatch::bind(&StartNested));
+    }
+    while (!g_Done)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    g_A->Stop();
+    g_B->Stop();
+    dispatch::GlobalDispatcherWait();
+    g_A.reset();
+    g_B.reset();
+    return g_Result;
+}
+
+void
+Print(
+    const char* Name,
+    const Result& Measured
+)
+{
+    std::cout << std::setw(26) << std::left << Name << std::right << std::fixed
+              << std::setw(14) << std::setprecision(0) << Measured.m_NsPerChain
+              << std::setw(18) << std::setprecision(2) << Measured.m_AllocationsPerChain << std::endl;
+}
+
+int main()
+{
+    std::cout << HOPS << " hop chains between two dispatchers" << std::endl;
+    std::cout << std::setw(26) << std::left << "style" << std::right
+              << std::setw(14) << "ns/chain"
+              << std::setw(18) << "allocs/chain" << std::endl;
+    Print("nested PostTaskAndReply", Run(false));
+    Print("coroutine Schedule()", Run(true));
+}
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t REQUESTS = 2000;
+const size_t GRAPH_SIZE = 2000;
+
+//
+// A request's working state: a tree of small heap
+// allocations that is slow to tear down
+//
+using Graph = std::map<size_t, std::string>;
+
+dispatch::DispatcherBasePtr g_Hot;
+dispatch::DispatcherBasePtr g_Background;
+std::vector<double> g_Latencies;
+std::atomic<bool> g_Done;
+bool g_Deferred;
+
+void
+HandleRequest(
+    const size_t Index
+)
+/*++
+  Build a graph, use it and let it go, timing how long
+  letting go holds up the hot dispatcher
+--*/
+{
+    auto graph = std::make_unique<Graph>();
+    for (size_t i = 0; i < GRAPH_SIZE; i++)
+    {
+        graph->emplace(i * 7919 % GRAPH_SIZE, "node payload that is not small");
+    }
+    auto start = Clock::now();
+    if (g_Deferred)
+    {
+        dispatch::DeleteSoon(g_Background.get(), std::move(graph));
+    }
+    else
+    {
+        graph.reset();
+    }
+    g_Latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+    if (Index + 1 == REQUESTS)
+    {
+        g_Done = true;
+    }
+}
+
+void
+Measure(
+    const bool Deferred
+)
+{
+    g_Deferred = Deferred;
+    g_Latencies.clear();
+    g_Done = false;
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < REQUESTS; i++)
+    {
+        g_Hot->PostTask(dispatch::bind(&HandleRequest, i));
+    }
+    while (!g_Done)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::sort(g_Latencies.begin(), g_Latencies.end());
+    std::cout << std::setw(12) << (Deferred ? "DeleteSoon" : "in place")
+              << std::setw(12) << std::fixed << std::setprecision(1) << g_Latencies[g_Latencies.size() / 2]
+              << std::setw(12) << g_Latencies[g_Latencies.size() * 99 / 100]
+              << std::setw(12) << elapsed << std::endl;
+}
+
+int main()
+{
+    g_Hot = dispatch::CreateDispatcher("hot");
+    g_Background = dispatch::CreateDispatcher("background");
+
+    std::cout << std::setw(12) << "teardown"
+              << std::setw(12) << "p50 us"
+              << std::setw(12) << "p99 us"
+              << std::setw(12) << "total ms" << std::endl;
+    Measure(false);
+    Measure(true);
+
+    g_Hot->Stop();
+    g_Hot->Wait();
+    g_Background->Stop();
+    dispatch::GlobalDispatcherWait();
+}
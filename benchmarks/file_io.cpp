@@ -0,0 +1,182 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t FILE_SIZE = 64 * 1024 * 1024;
+const size_t BLOCK_SIZE = 64 * 1024;
+const size_t BLOCKS = FILE_SIZE / BLOCK_SIZE;
+const size_t POOL_SIZES[] = { 1, 4, 16 };
+const size_t QUEUE_DEPTHS[] = { 1, 8, 32 };
+
+int g_Fd;
+std::atomic<size_t> g_BlocksRead;
+
+void
+BlockingRead(
+    const size_t Block
+)
+/*++
+  One pool task: read a block the old way, blocking
+  the worker until it arrives
+--*/
+{
+    thread_local std::vector<char> buffer(BLOCK_SIZE);
+    auto count = pread(g_Fd, buffer.data(), BLOCK_SIZE, Block * BLOCK_SIZE);
+    assert(count == (ssize_t)BLOCK_SIZE);
+    (void)count;
+    g_BlocksRead++;
+}
+
+double
+PoolThroughput(
+    const size_t PoolSize
+)
+/*++
+  MiB/s reading the whole file as one blocking task per
+  block, spread over a pool
+--*/
+{
+    auto pool = dispatch::CreateDispatchPool("blocking", PoolSize);
+    g_BlocksRead = 0;
+    auto start = Clock::now();
+    dispatch::TaskBatch batch;
+    for (size_t block = 0; block < BLOCKS; block++)
+    {
+        batch.push_back(dispatch::bind(&BlockingRead, block));
+    }
+    pool->PostTasks(std::move(batch));
+    while (g_BlocksRead < BLOCKS)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    pool->Stop();
+    dispatch::GlobalDispatcherWait();
+    return FILE_SIZE / elapsed / (1024 * 1024);
+}
+
+struct RingState
+{
+    std::vector<std::vector<char>> m_Buffers;
+    size_t m_Next;
+    size_t m_Completed;
+    Clock::time_point m_Start;
+    double m_Throughput;
+};
+
+RingState g_Ring;
+
+void
+IssueRead(
+    const size_t Slot
+);
+
+void
+OnRead(
+    const size_t Slot,
+    const int64_t Result
+)
+{
+    assert(Result == (int64_t)BLOCK_SIZE);
+    if (++g_Ring.m_Completed == BLOCKS)
+    {
+        auto elapsed = std::chrono::duration<double>(Clock::now() - g_Ring.m_Start).count();
+        g_Ring.m_Throughput = FILE_SIZE / elapsed / (1024 * 1024);
+        dispatch::End();
+        return;
+    }
+    IssueRead(Slot);
+}
+
+void
+IssueRead(
+    const size_t Slot
+)
+{
+    if (g_Ring.m_Next == BLOCKS)
+    {
+        return;
+    }
+    auto block = g_Ring.m_Next++;
+    dispatch::AsyncRead(
+        g_Fd,
+        g_Ring.m_Buffers[Slot].data(),
+        BLOCK_SIZE,
+        block * BLOCK_SIZE,
+        std::bind(&OnRead, Slot, std::placeholders::_1)
+    );
+}
+
+void
+StartRing(
+    const size_t QueueDepth
+)
+{
+    g_Ring.m_Start = Clock::now();
+    for (size_t slot = 0; slot < QueueDepth; slot++)
+    {
+        IssueRead(slot);
+    }
+}
+
+double
+RingThroughput(
+    const size_t QueueDepth
+)
+/*++
+  MiB/s reading the whole file from a single dispatcher
+  with QueueDepth asynchronous reads in flight
+--*/
+{
+    g_Ring.m_Buffers.assign(QueueDepth, std::vector<char>(BLOCK_SIZE));
+    g_Ring.m_Next = 0;
+    g_Ring.m_Completed = 0;
+    dispatch::CreateAndEnterDispatcher("ring", dispatch::bind(&StartRing, QueueDepth));
+    return g_Ring.m_Throughput;
+}
+
+int main()
+{
+    char path[] = "/tmp/dispatchqueue_file_io_XXXXXX";
+    g_Fd = mkstemp(path);
+    assert(g_Fd != -1);
+    unlink(path);
+    std::vector<char> fill(BLOCK_SIZE, 'x');
+    for (size_t block = 0; block < BLOCKS; block++)
+    {
+        auto count = write(g_Fd, fill.data(), BLOCK_SIZE);
+        assert(count == (ssize_t)BLOCK_SIZE);
+        (void)count;
+    }
+
+    //
+    // The file is hot in the page cache, so this measures
+    // the dispatch and syscall overhead per block rather
+    // than the device
+    //
+    std::cout << "Reading " << FILE_SIZE / (1024 * 1024) << " MiB in " << BLOCK_SIZE / 1024 << " KiB blocks" << std::endl;
+    for (auto poolSize : POOL_SIZES)
+    {
+        std::cout << std::setw(28) << std::left << ("blocking pool x" + std::to_string(poolSize)) << std::right
+                  << std::fixed << std::setprecision(0) << std::setw(10) << PoolThroughput(poolSize) << " MiB/s" << std::endl;
+    }
+    for (auto queueDepth : QUEUE_DEPTHS)
+    {
+        std::cout << std::setw(28) << std::left << ("io ring depth " + std::to_string(queueDepth)) << std::right
+                  << std::fixed << std::setprecision(0) << std::setw(10) << RingThroughput(queueDepth) << " MiB/s" << std::endl;
+    }
+
+    close(g_Fd);
+}
@@ -0,0 +1,195 @@
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#include "DispatchQueue.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t ROUND_TRIPS = 100000;
+
+std::atomic<size_t> g_Allocations = 0;
+
+void*
+operator new(
+    size_t Size
+)
+{
+    g_Allocations.fetch_add(1, std::memory_order_relaxed);
+    void* allocation = malloc(Size);
+    if (allocation == nullptr)
+    {
+        abort();
+    }
+    return allocation;
+}
+
+void
+operator delete(
+    void* Allocation
+) noexcept
+{
+    free(Allocation);
+}
+
+void
+operator delete(
+    void* Allocation,
+    size_t Size
+) noexcept
+{
+    free(Allocation);
+}
+
+struct Result
+{
+    double m_NsPerTrip;
+    double m_AllocationsPerTrip;
+};
+
+dispatch::DispatcherBasePtr g_Worker;
+std::atomic<bool> g_Done;
+size_t g_Trips;
+Clock::time_point g_Start;
+size_t g_StartAllocations;
+Result g_Result;
+dispatch::Future<size_t> g_Future;
+
+size_t
+Compute(
+    const size_t Value
+)
+{
+    return Value + 1;
+}
+
+void
+Begin(
+    void
+)
+{
+    g_Trips = 0;
+    g_StartAllocations = g_Allocations.load();
+    g_Start = Clock::now();
+}
+
+void
+Finish(
+    void
+)
+{
+    auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - g_Start).count();
+    g_Result.m_NsPerTrip = elapsed / ROUND_TRIPS;
+    g_Result.m_AllocationsPerTrip = (double)(g_Allocations.load() - g_StartAllocations) / ROUND_TRIPS;
+    g_Done = true;
+}
+
+//
+// Each round trip asks the worker for the next value and
+// starts the following trip from the reply
+//
+void
+ReplyTrip(
+    const size_t Value
+)
+{
+    if (++g_Trips == ROUND_TRIPS)
+    {
+        Finish();
+        return;
+    }
+    dispatch::PostTaskWithResult(
+        g_Worker.get(),
+        [Value]{ return Compute(Value); },
+        &ReplyTrip
+    );
+}
+
+void
+FutureTrip(
+    const size_t Value
+)
+{
+    if (++g_Trips == ROUND_TRIPS)
+    {
+        g_Future = {};
+        Finish();
+        return;
+    }
+    g_Future = dispatch::PostTaskWithResult(g_Worker.get(), [Value]{ return Compute(Value); });
+    g_Future.Then(&FutureTrip);
+}
+
+Result
+RunOnDispatcher(
+    void (*Trip)(const size_t)
+)
+{
+    g_Done = false;
+    g_Worker = dispatch::CreateDispatcher("worker");
+    auto caller = dispatch::CreateDispatcher("caller");
+    caller->PostTask([Trip]{ Begin(); Trip(0); });
+    while (!g_Done)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    caller->Stop();
+    g_Worker->Stop();
+    dispatch::GlobalDispatcherWait();
+    g_Worker.reset();
+    return g_Result;
+}
+
+Result
+RunPackagedTask(
+    void
+)
+/*++
+  The same trips with std::packaged_task, the caller
+  blocking on each std::future in turn
+--*/
+{
+    g_Worker = dispatch::CreateDispatcher("worker");
+    Begin();
+    size_t value = 0;
+    for (size_t trip = 1; trip < ROUND_TRIPS; trip++)
+    {
+        std::packaged_task<size_t()> task([value]{ return Compute(value); });
+        auto future = task.get_future();
+        g_Worker->PostTask(std::move(task));
+        value = future.get();
+    }
+    Finish();
+    g_Worker->Stop();
+    dispatch::GlobalDispatcherWait();
+    g_Worker.reset();
+    return g_Result;
+}
+
+void
+Print(
+    const char* Name,
+    const Result& Measured
+)
+{
+    std::cout << std::setw(30) << std::left << Name << std::right << std::fixed
+              << std::setw(12) << std::setprecision(0) << Measured.m_NsPerTrip
+              << std::setw(16) << std::setprecision(2) << Measured.m_AllocationsPerTrip << std::endl;
+}
+
+int main()
+{
+    std::cout << ROUND_TRIPS << " result round trips to another dispatcher" << std::endl;
+    std::cout << std::setw(30) << std::left << "style" << std::right
+              << std::setw(12) << "ns/trip"
+              << std::setw(16) << "allocs/trip" << std::endl;
+    Print("std::packaged_task + get()", RunPackagedTask());
+    Print("PostTaskWithResult reply", RunOnDispatcher(&ReplyTrip));
+    Print("PostTaskWithResult Future", RunOnDispatcher(&FutureTrip));
+}
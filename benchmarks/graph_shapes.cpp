@@ -0,0 +1,180 @@
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "DispatchQueue.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t NODES = 1024;
+const size_t LAYERS = 32;
+const size_t RUNS = 200;
+const size_t WORK = 200;
+
+std::atomic<size_t> g_Allocations = 0;
+
+void*
+operator new(
+    size_t Size
+)
+{
+    g_Allocations.fetch_add(1, std::memory_order_relaxed);
+    void* allocation = malloc(Size);
+    if (allocation == nullptr)
+    {
+        abort();
+    }
+    return allocation;
+}
+
+void
+operator delete(
+    void* Allocation
+) noexcept
+{
+    free(Allocation);
+}
+
+void
+operator delete(
+    void* Allocation,
+    size_t Size
+) noexcept
+{
+    free(Allocation);
+}
+
+void
+Work(
+    void
+)
+/*++
+  A small amount of work per node, enough that the
+  graph is not purely scheduling overhead
+--*/
+{
+    volatile size_t sink = 0;
+    for (size_t i = 0; i < WORK; i++)
+    {
+        sink = sink + i;
+    }
+}
+
+void
+BuildWide(
+    dispatch::TaskGraph& Graph
+)
+/*++
+  One source fanning out to NODES - 2 independent nodes
+  that all feed one sink
+--*/
+{
+    auto source = Graph.AddNode(&Work);
+    auto sink = Graph.AddNode(&Work);
+    for (size_t i = 2; i < NODES; i++)
+    {
+        auto node = Graph.AddNode(&Work);
+        Graph.AddEdge(source, node);
+        Graph.AddEdge(node, sink);
+    }
+}
+
+void
+BuildDeep(
+    dispatch::TaskGraph& Graph
+)
+/*++
+  A single chain of NODES nodes
+--*/
+{
+    auto previous = Graph.AddNode(&Work);
+    for (size_t i = 1; i < NODES; i++)
+    {
+        auto node = Graph.AddNode(&Work);
+        Graph.AddEdge(previous, node);
+        previous = node;
+    }
+}
+
+void
+BuildLayered(
+    dispatch::TaskGraph& Graph
+)
+/*++
+  LAYERS layers of NODES / LAYERS nodes, each depending
+  on two nodes of the layer above
+--*/
+{
+    auto width = NODES / LAYERS;
+    for (size_t layer = 0; layer < LAYERS; layer++)
+    {
+        for (size_t i = 0; i < width; i++)
+        {
+            auto node = Graph.AddNode(&Work);
+            if (layer > 0)
+            {
+                auto above = node - width;
+                Graph.AddEdge(above, node);
+                Graph.AddEdge(above - i + (i + 1) % width, node);
+            }
+        }
+    }
+}
+
+void
+Measure(
+    const std::string& Name,
+    void (*Build)(dispatch::TaskGraph&),
+    dispatch::DispatchPool* Pool
+)
+{
+    dispatch::TaskGraph graph;
+    Build(graph);
+
+    //
+    // Warm up the pool's job allocators before counting
+    //
+    graph.Run(Pool);
+    graph.Wait();
+
+    auto allocations = g_Allocations.load();
+    auto start = Clock::now();
+    for (size_t run = 0; run < RUNS; run++)
+    {
+        graph.Run(Pool);
+        graph.Wait();
+    }
+    auto elapsed = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    std::cout << std::setw(30) << std::left << Name << std::right << std::fixed
+              << std::setw(12) << std::setprecision(1) << elapsed / RUNS
+              << std::setw(12) << std::setprecision(0) << elapsed * 1000 / (RUNS * graph.Size())
+              << std::setw(14) << std::setprecision(2) << (double)(g_Allocations.load() - allocations) / RUNS << std::endl;
+}
+
+int main()
+{
+    auto pool = dispatch::CreateDispatchPool("pool", 0);
+    auto stealingPool = dispatch::CreateDispatchPool("stealing pool", 0, dispatch::PoolMode::WORK_STEALING);
+
+    std::cout << NODES << " node graphs, " << RUNS << " runs each" << std::endl;
+    std::cout << std::setw(30) << std::left << "graph" << std::right
+              << std::setw(12) << "us/run"
+              << std::setw(12) << "ns/node"
+              << std::setw(14) << "allocs/run" << std::endl;
+    for (auto target : { pool.get(), stealingPool.get() })
+    {
+        auto suffix = target->GetMode() == dispatch::PoolMode::WORK_STEALING ? " (stealing)" : " (round robin)";
+        Measure(std::string("wide") + suffix, &BuildWide, target);
+        Measure(std::string("deep") + suffix, &BuildDeep, target);
+        Measure(std::string("layered") + suffix, &BuildLayered, target);
+    }
+
+    pool->Stop();
+    stealingPool->Stop();
+    dispatch::GlobalDispatcherWait();
+}
@@ -0,0 +1,111 @@
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "DispatchQueue.hpp"
+
+//
+// Run once as built and once configured with
+// -DDISPATCH_METRICS=OFF to see what collection costs
+//
+
+using Clock = std::chrono::steady_clock;
+
+const size_t TOTAL_TASKS = 1024 * 1024;
+const size_t ROUNDS = 5;
+
+std::atomic<size_t> g_Received;
+
+void
+Receive(
+    void
+)
+{
+    g_Received.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+Chain(
+    const size_t Remaining
+)
+/*++
+  Posts its successor to our own dispatcher, the native
+  path every counter sits on
+--*/
+{
+    if (Remaining > 0)
+    {
+        dispatch::PostTask(dispatch::bind(&Chain, Remaining - 1));
+        return;
+    }
+    g_Received = 1;
+}
+
+double
+CrossThread(
+    dispatch::DispatcherBase* Target
+)
+{
+    g_Received = 0;
+    auto start = Clock::now();
+    for (size_t i = 0; i < TOTAL_TASKS; i++)
+    {
+        Target->PostTask(dispatch::bind(&Receive));
+    }
+    while (g_Received.load(std::memory_order_relaxed) < TOTAL_TASKS)
+    {
+        std::this_thread::yield();
+    }
+    return TOTAL_TASKS / std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+double
+SameThread(
+    dispatch::DispatcherBase* Target
+)
+{
+    g_Received = 0;
+    auto start = Clock::now();
+    Target->PostTask(dispatch::bind(&Chain, TOTAL_TASKS));
+    while (g_Received.load(std::memory_order_relaxed) == 0)
+    {
+        std::this_thread::yield();
+    }
+    return TOTAL_TASKS / std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main()
+{
+#ifdef DISPATCH_NO_METRICS
+    std::cout << "metrics compiled out" << std::endl;
+#else
+    std::cout << "metrics on, sampling 1 in " << dispatch::METRICS_SAMPLE_INTERVAL << std::endl;
+#endif
+    auto dispatcher = dispatch::CreateDispatcher("consumer");
+
+    double bestCross = 0;
+    double bestSame = 0;
+    for (size_t round = 0; round < ROUNDS; round++)
+    {
+        bestCross = std::max(bestCross, CrossThread(dispatcher.get()));
+        bestSame = std::max(bestSame, SameThread(dispatcher.get()));
+    }
+    std::cout << std::fixed << std::setprecision(0)
+              << std::setw(24) << "cross-thread tasks/s" << std::setw(16) << bestCross << std::endl
+              << std::setw(24) << "same-thread tasks/s" << std::setw(16) << bestSame << std::endl;
+
+    for (auto& metrics : dispatch::SnapshotMetrics())
+    {
+        std::cout << metrics.m_Name << ": posted " << metrics.m_Posted
+                  << ", run " << metrics.m_Run
+                  << ", wait p50/p99 " << metrics.m_QueueWait.Percentile(0.5) << "/" << metrics.m_QueueWait.Percentile(0.99) << "ns"
+                  << ", run p50/p99 " << metrics.m_RunTime.Percentile(0.5) << "/" << metrics.m_RunTime.Percentile(0.99) << "ns"
+                  << ", busy " << std::chrono::duration_cast<std::chrono::milliseconds>(metrics.m_BusyTime).count() << "ms"
+                  << ", idle " << std::chrono::duration_cast<std::chrono::milliseconds>(metrics.m_IdleTime).count() << "ms" << std::endl;
+    }
+
+    dispatcher->Stop();
+    dispatch::GlobalDispatcherWait();
+}
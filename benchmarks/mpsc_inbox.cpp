@@ -0,0 +1,175 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+#include "MpscQueue.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t PRODUCERS[] = { 1, 2, 4, 8, 16, 32, 64 };
+const size_t TOTAL_POSTS = 256 * 1024;
+
+size_t g_Received;
+size_t g_Expected;
+
+void
+Receive(
+    void
+)
+{
+    if (++g_Received == g_Expected)
+    {
+        dispatch::End();
+    }
+}
+
+double
+DispatcherThroughput(
+    const size_t Producers
+)
+/*++
+  Posts per second from Producers foreign threads
+  into a single dispatcher
+--*/
+{
+    g_Received = 0;
+    g_Expected = TOTAL_POSTS;
+    auto dispatcher = dispatch::CreateDispatcher("consumer");
+    auto perProducer = TOTAL_POSTS / Producers;
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < Producers; i++)
+    {
+        threads.emplace_back([&]{
+            for (size_t j = 0; j < perProducer; j++)
+            {
+                dispatcher->PostTask(dispatch::bind(&Receive));
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    dispatcher->Wait();
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    dispatch::RemoveDispatcher(dispatcher.get());
+    return TOTAL_POSTS / elapsed;
+}
+
+struct Node
+{
+    size_t m_Value;
+    Node* m_Next = nullptr;
+};
+
+double
+MpscThroughput(
+    const size_t Producers
+)
+/*++
+  Raw inbox throughput: push nodes from Producers
+  threads while one consumer drains in batches
+--*/
+{
+    dispatch::MpscQueue<Node> queue;
+    std::vector<Node> nodes(TOTAL_POSTS);
+    auto perProducer = TOTAL_POSTS / Producers;
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < Producers; i++)
+    {
+        threads.emplace_back([&, i]{
+            for (size_t j = 0; j < perProducer; j++)
+            {
+                queue.Push(&nodes[i * perProducer + j]);
+            }
+        });
+    }
+    size_t received = 0;
+    while (received < TOTAL_POSTS)
+    {
+        for (auto node = queue.Drain(); node != nullptr; node = node->m_Next)
+        {
+            received++;
+        }
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    return TOTAL_POSTS / elapsed;
+}
+
+double
+MutexThroughput(
+    const size_t Producers
+)
+/*++
+  The previous inbox: a mutex protected deque with a
+  notify_one on every push
+--*/
+{
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<size_t> queue;
+    auto perProducer = TOTAL_POSTS / Producers;
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < Producers; i++)
+    {
+        threads.emplace_back([&]{
+            for (size_t j = 0; j < perProducer; j++)
+            {
+                {
+                    std::lock_guard<std::mutex> guard(mutex);
+                    queue.push_back(j);
+                }
+                available.notify_one();
+            }
+        });
+    }
+    size_t received = 0;
+    while (received < TOTAL_POSTS)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        received += queue.size();
+        queue.clear();
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    return TOTAL_POSTS / elapsed;
+}
+
+int main()
+{
+    std::cout << std::setw(10) << "producers"
+              << std::setw(20) << "dispatcher posts/s"
+              << std::setw(20) << "mpsc posts/s"
+              << std::setw(20) << "mutex posts/s" << std::endl;
+
+    for (auto producers : PRODUCERS)
+    {
+        auto dispatcher = DispatcherThroughput(producers);
+        auto mpsc = MpscThroughput(producers);
+        auto mutex = MutexThroughput(producers);
+        std::cout << std::setw(10) << producers << std::fixed << std::setprecision(0)
+                  << std::setw(20) << dispatcher
+                  << std::setw(20) << mpsc
+                  << std::setw(20) << mutex << std::endl;
+    }
+}
@@ -0,0 +1,118 @@
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t PRODUCERS[] = { 1, 2, 4, 8 };
+const size_t TOTAL_POSTS = 256 * 1024;
+
+#define CONSUMER "consumer"
+
+std::atomic<size_t> g_Received;
+
+void
+Receive(
+    void
+)
+{
+    g_Received.fetch_add(1, std::memory_order_relaxed);
+}
+
+//
+// What a name based post used to cost: a global mutex,
+// a map lookup and a shared_ptr copy on every call
+//
+std::mutex g_MapLock;
+std::map<std::string, dispatch::DispatcherBasePtr> g_Map;
+
+enum class PostMode
+{
+    MAP,
+    NAME,
+    HANDLE
+};
+
+double
+Throughput(
+    const PostMode Mode,
+    const size_t Producers
+)
+/*++
+  Posts per second from Producers foreign threads into
+  one dispatcher, addressed in the given way
+--*/
+{
+    g_Received = 0;
+    auto dispatcher = dispatch::CreateDispatcher(CONSUMER);
+    g_Map[CONSUMER] = dispatcher;
+    auto perProducer = TOTAL_POSTS / Producers;
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < Producers; i++)
+    {
+        threads.emplace_back([&]{
+            auto handle = dispatch::GetDispatcherHandle(CONSUMER);
+            for (size_t j = 0; j < perProducer; j++)
+            {
+                if (Mode == PostMode::MAP)
+                {
+                    dispatch::DispatcherBasePtr target;
+                    {
+                        std::lock_guard<std::mutex> guard(g_MapLock);
+                        target = g_Map.at(CONSUMER);
+                    }
+                    target->PostTask(dispatch::bind(&Receive));
+                }
+                else if (Mode == PostMode::NAME)
+                {
+                    dispatch::PostTaskToDispatcher(CONSUMER, dispatch::bind(&Receive));
+                }
+                else
+                {
+                    handle.PostTask(dispatch::bind(&Receive));
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    while (g_Received < perProducer * Producers)
+    {
+        std::this_thread::yield();
+    }
+    g_Map.clear();
+    dispatcher->Stop();
+    dispatcher->Wait();
+    dispatch::RemoveDispatcher(dispatcher.get());
+    return perProducer * Producers / elapsed;
+}
+
+int main()
+{
+    std::cout << std::setw(10) << "producers"
+              << std::setw(16) << "map posts/s"
+              << std::setw(16) << "name posts/s"
+              << std::setw(16) << "handle posts/s" << std::endl;
+    for (auto producers : PRODUCERS)
+    {
+        std::cout << std::setw(10) << producers
+                  << std::setw(16) << std::fixed << std::setprecision(0) << Throughput(PostMode::MAP, producers)
+                  << std::setw(16) << Throughput(PostMode::NAME, producers)
+                  << std::setw(16) << Throughput(PostMode::HANDLE, producers) << std::endl;
+    }
+    dispatch::GlobalDispatcherWait();
+}
@@ -0,0 +1,115 @@
+#include <math.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t MEMORY_ELEMENTS = 16 * 1024 * 1024;
+const size_t COMPUTE_ELEMENTS = 1024 * 1024;
+const size_t REPEATS = 5;
+
+std::vector<float> g_Input(MEMORY_ELEMENTS, 1.0f);
+std::vector<float> g_Output(MEMORY_ELEMENTS);
+
+double
+MemoryBound(
+    dispatch::DispatchPool* Pool
+)
+/*++
+  Stream one array into another, limited by memory
+  bandwidth rather than the arithmetic
+--*/
+{
+    dispatch::ParallelTransform(
+        Pool, g_Input.begin(), g_Input.end(), g_Output.begin(), 0,
+        [](float Value) { return Value * 2.0f + 1.0f; }
+    );
+    return g_Output[MEMORY_ELEMENTS / 2];
+}
+
+double
+ComputeBound(
+    dispatch::DispatchPool* Pool
+)
+/*++
+  A reduction over a few transcendental functions per
+  element with no memory traffic to speak of
+--*/
+{
+    return dispatch::ParallelReduce(
+        Pool, 0, COMPUTE_ELEMENTS, 0, 0.0,
+        [](size_t i) {
+            double x = (double)i;
+            return sin(x) * cos(x) + sqrt(x) + log1p(x);
+        },
+        [](double Lhs, double Rhs) { return Lhs + Rhs; }
+    );
+}
+
+double
+Best(
+    double (*Kernel)(dispatch::DispatchPool*),
+    dispatch::DispatchPool* Pool
+)
+/*++
+  Best of REPEATS runs, in milliseconds
+--*/
+{
+    double best = 0;
+    for (size_t repeat = 0; repeat < REPEATS; repeat++)
+    {
+        auto start = Clock::now();
+        volatile double sink = Kernel(Pool);
+        (void)sink;
+        auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        best = repeat == 0 ? elapsed : std::min(best, elapsed);
+    }
+    return best;
+}
+
+int main()
+{
+    std::vector<size_t> workerCounts;
+    auto cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+    for (size_t workers = 1; workers < cores; workers *= 2)
+    {
+        workerCounts.push_back(workers);
+    }
+    workerCounts.push_back(cores);
+
+    //
+    // The calling thread also takes part, so there is one
+    // more participant than there are workers
+    //
+    std::cout << "Scaling on " << cores << " cores, best of " << REPEATS << std::endl;
+    std::cout << std::setw(10) << "workers"
+              << std::setw(14) << "memory ms" << std::setw(10) << "speedup"
+              << std::setw(14) << "compute ms" << std::setw(10) << "speedup" << std::endl;
+    double memoryBase = 0;
+    double computeBase = 0;
+    for (auto workers : workerCounts)
+    {
+        auto pool = dispatch::CreateDispatchPool("pool", workers, dispatch::PoolMode::WORK_STEALING);
+        auto memory = Best(&MemoryBound, pool.get());
+        auto compute = Best(&ComputeBound, pool.get());
+        if (workers == workerCounts.front())
+        {
+            memoryBase = memory;
+            computeBase = compute;
+        }
+        std::cout << std::setw(10) << workers << std::fixed
+                  << std::setw(14) << std::setprecision(2) << memory
+                  << std::setw(10) << std::setprecision(2) << memoryBase / memory
+                  << std::setw(14) << std::setprecision(2) << compute
+                  << std::setw(10) << std::setprecision(2) << computeBase / compute << std::endl;
+        pool->Stop();
+        dispatch::GlobalDispatcherWait();
+    }
+}
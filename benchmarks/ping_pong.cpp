@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t ROUND_TRIPS = 20000;
+
+struct Policy
+{
+    const char* m_Name;
+    dispatch::IdlePolicy m_Policy;
+};
+
+const Policy POLICIES[] = {
+    { "block", dispatch::IdlePolicy::BLOCK },
+    { "yield", dispatch::IdlePolicy::YIELD },
+    { "spin", dispatch::IdlePolicy::SPIN },
+    { "adaptive", dispatch::IdlePolicy::ADAPTIVE }
+};
+
+dispatch::DispatcherBasePtr g_Ping;
+dispatch::DispatcherBasePtr g_Pong;
+std::vector<double> g_Latencies;
+Clock::time_point g_Sent;
+
+void Ping(void);
+
+void
+Pong(
+    void
+)
+{
+    g_Ping->PostTask(dispatch::bind(&Ping));
+}
+
+void
+Ping(
+    void
+)
+/*++
+  Record the round trip that just completed and
+  start the next, until we have enough samples
+--*/
+{
+    auto now = Clock::now();
+    if (g_Latencies.size() < ROUND_TRIPS)
+    {
+        if (g_Sent != Clock::time_point())
+        {
+            g_Latencies.push_back(std::chrono::duration<double, std::nano>(now - g_Sent).count());
+        }
+        g_Sent = Clock::now();
+        g_Pong->PostTask(dispatch::bind(&Pong));
+        return;
+    }
+    g_Pong->Stop();
+    dispatch::End();
+}
+
+void
+Measure(
+    const Policy& Measured
+)
+{
+    g_Latencies.clear();
+    g_Latencies.reserve(ROUND_TRIPS);
+    g_Sent = Clock::time_point();
+
+    g_Pong = dispatch::CreateDispatcher("pong");
+    g_Pong->SetIdlePolicy(Measured.m_Policy);
+    g_Ping = dispatch::CreateDispatcher("ping");
+    g_Ping->SetIdlePolicy(Measured.m_Policy);
+    g_Ping->PostTask(dispatch::bind(&Ping));
+    dispatch::GlobalDispatcherWait();
+    g_Ping.reset();
+    g_Pong.reset();
+
+    std::sort(g_Latencies.begin(), g_Latencies.end());
+    double total = 0;
+    for (auto latency : g_Latencies)
+    {
+        total += latency;
+    }
+    std::cout << std::setw(10) << Measured.m_Name << std::fixed << std::setprecision(0)
+              << std::setw(14) << total / g_Latencies.size()
+              << std::setw(14) << g_Latencies[g_Latencies.size() / 2]
+              << std::setw(14) << g_Latencies[g_Latencies.size() * 99 / 100] << std::endl;
+}
+
+int main()
+{
+    std::cout << std::setw(10) << "policy"
+              << std::setw(14) << "mean ns"
+              << std::setw(14) << "p50 ns"
+              << std::setw(14) << "p99 ns" << std::endl;
+
+    for (auto& policy : POLICIES)
+    {
+        //
+        // Two spinning dispatchers on one core only make
+        // progress when the scheduler preempts them
+        //
+        if (policy.m_Policy == dispatch::IdlePolicy::SPIN && std::thread::hardware_concurrency() < 2)
+        {
+            std::cout << std::setw(10) << policy.m_Name << "  skipped, needs at least two cores" << std::endl;
+            continue;
+        }
+        Measure(policy);
+    }
+}
@@ -0,0 +1,120 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+#include "Harness.hpp"
+
+//
+// Recursive fan-out on a pool, the pattern of the pool
+// sub tasks in tests/dispatcher.cpp taken a few levels
+// deep. Every task but the leaves posts its children
+// back to the pool from the worker it runs on
+//
+
+const size_t FANOUT = 8;
+const size_t LEVELS = 6;
+const size_t SAMPLES = 10;
+const size_t POOL_SIZE = 4;
+
+struct Variant
+{
+    const char* m_Name;
+    dispatch::PoolRouting m_Routing;
+    size_t m_LocalDepth;
+};
+
+const Variant VARIANTS[] = {
+    { "round_robin/remote", dispatch::PoolRouting::ROUND_ROBIN, 0 },
+    { "round_robin/local_first", dispatch::PoolRouting::ROUND_ROBIN, dispatch::POOL_LOCAL_DEPTH },
+    { "least_loaded/remote", dispatch::PoolRouting::LEAST_LOADED, 0 },
+    { "least_loaded/local_first", dispatch::PoolRouting::LEAST_LOADED, dispatch::POOL_LOCAL_DEPTH }
+};
+
+std::atomic<size_t> g_Finished;
+
+void
+Spawn(
+    const size_t Level
+)
+{
+    if (Level > 0)
+    {
+        for (size_t i = 0; i < FANOUT; i++)
+        {
+            dispatch::PostTask(dispatch::bind(&Spawn, Level - 1));
+        }
+    }
+    g_Finished.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t
+TreeSize(
+    void
+)
+{
+    size_t total = 0;
+    size_t level = 1;
+    for (size_t i = 0; i <= LEVELS; i++)
+    {
+        total += level;
+        level *= FANOUT;
+    }
+    return total;
+}
+
+void
+Measure(
+    BenchmarkHarness& Harness,
+    const Variant& Measured
+)
+/*++
+  Tasks per second from posting the root until the
+  whole tree has run
+--*/
+{
+    auto name = std::string("pool/fanout_tree/") + Measured.m_Name;
+    if (!Harness.Enabled(name))
+    {
+        return;
+    }
+    dispatch::PoolConfig config;
+    config.m_Size = POOL_SIZE;
+    config.m_Routing = Measured.m_Routing;
+    config.m_LocalDepth = Measured.m_LocalDepth;
+    auto pool = dispatch::CreateDispatchPool(Measured.m_Name, config);
+
+    auto tasks = TreeSize();
+    std::vector<double> samples;
+    for (size_t sample = 0; sample < Harness.Samples(SAMPLES); sample++)
+    {
+        g_Finished = 0;
+        auto start = Clock::now();
+        pool->PostTask(dispatch::bind(&Spawn, LEVELS));
+        while (g_Finished.load(std::memory_order_relaxed) < tasks)
+        {
+            std::this_thread::yield();
+        }
+        samples.push_back(tasks / std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    Harness.Report(name, "task/s", samples);
+    pool->Stop();
+    pool->Wait();
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkHarness harness(argc, argv);
+    if (!harness.Valid())
+    {
+        return 1;
+    }
+    for (auto& variant : VARIANTS)
+    {
+        Measure(harness, variant);
+    }
+    dispatch::GlobalDispatcherWait();
+    return harness.Finish();
+}
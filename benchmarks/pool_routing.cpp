@@ -0,0 +1,115 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+#include "Harness.hpp"
+
+//
+// Post-to-finish latency of a pool under skewed task
+// durations, for each routing policy. Most tasks are
+// short and a few are long enough to back a worker up
+//
+
+const size_t TASKS = 4000;
+const size_t LONG_EVERY = 25;
+const auto SHORT_TASK = std::chrono::microseconds(5);
+const auto LONG_TASK = std::chrono::microseconds(1000);
+const auto POST_INTERVAL = std::chrono::microseconds(60);
+const size_t POOL_SIZE = 4;
+
+struct Routing
+{
+    const char* m_Name;
+    dispatch::PoolRouting m_Routing;
+};
+
+const Routing ROUTINGS[] = {
+    { "round_robin", dispatch::PoolRouting::ROUND_ROBIN },
+    { "two_choices", dispatch::PoolRouting::TWO_CHOICES },
+    { "least_loaded", dispatch::PoolRouting::LEAST_LOADED }
+};
+
+std::vector<double> g_Latencies;
+std::atomic<size_t> g_Finished;
+
+void
+Spin(
+    const Clock::duration Duration
+)
+{
+    auto end = Clock::now() + Duration;
+    while (Clock::now() < end)
+    {
+    }
+}
+
+void
+Task(
+    const size_t Index,
+    const Clock::time_point Posted
+)
+{
+    Spin(Index % LONG_EVERY == 0 ? Clock::duration(LONG_TASK) : Clock::duration(SHORT_TASK));
+    g_Latencies[Index] = std::chrono::duration<double, std::micro>(Clock::now() - Posted).count();
+    g_Finished.fetch_add(1, std::memory_order_release);
+}
+
+void
+Measure(
+    BenchmarkHarness& Harness,
+    const Routing& Measured
+)
+/*++
+  Post at a steady rate from this thread, every task
+  recording how long it took from post to finish
+--*/
+{
+    auto name = std::string("pool/routing/") + Measured.m_Name;
+    if (!Harness.Enabled(name))
+    {
+        return;
+    }
+    dispatch::PoolConfig config;
+    config.m_Size = POOL_SIZE;
+    config.m_Routing = Measured.m_Routing;
+    auto pool = dispatch::CreateDispatchPool(Measured.m_Name, config);
+
+    auto tasks = Harness.Samples(TASKS);
+    g_Latencies.assign(tasks, 0);
+    g_Finished = 0;
+    auto next = Clock::now();
+    for (size_t i = 0; i < tasks; i++)
+    {
+        while (Clock::now() < next)
+        {
+            std::this_thread::yield();
+        }
+        pool->PostTask(dispatch::bind(&Task, i, Clock::now()));
+        next += POST_INTERVAL;
+    }
+    while (g_Finished.load(std::memory_order_acquire) < tasks)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    Harness.Report(name, "us", g_Latencies);
+    pool->Stop();
+    pool->Wait();
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkHarness harness(argc, argv);
+    if (!harness.Valid())
+    {
+        return 1;
+    }
+    for (auto& routing : ROUTINGS)
+    {
+        Measure(harness, routing);
+    }
+    dispatch::GlobalDispatcherWait();
+    return harness.Finish();
+}
@@ -0,0 +1,152 @@
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "SharedRefptr.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t OBJECTS = 1 << 20;
+const size_t PASSES = 8;
+
+std::atomic<size_t> g_Allocations = 0;
+
+void*
+operator new(
+    size_t Size
+)
+{
+    g_Allocations.fetch_add(1, std::memory_order_relaxed);
+    void* allocation = malloc(Size);
+    if (allocation == nullptr)
+    {
+        abort();
+    }
+    return allocation;
+}
+
+void
+operator delete(
+    void* Allocation
+) noexcept
+{
+    free(Allocation);
+}
+
+void
+operator delete(
+    void* Allocation,
+    size_t Size
+) noexcept
+{
+    free(Allocation);
+}
+
+struct Payload
+{
+    Payload(size_t Value) : m_Value(Value) {};
+    size_t m_Value;
+    size_t m_Padding[3] = {};
+};
+
+//
+// The three layouts under test: the object handed over
+// as a raw pointer (a separate control block, as every
+// SharedRefPtr used to be), the co-located block from
+// MakeSharedRefPtr, and what the STDPTR macros select
+//
+struct Separate
+{
+    using Ptr = dispatch::SharedRefPtr<Payload>;
+    static Ptr Make(size_t Value) { return Ptr(new Payload(Value)); };
+    static const char* Name(void) { return "separate"; };
+};
+
+struct Colocated
+{
+    using Ptr = dispatch::SharedRefPtr<Payload>;
+    static Ptr Make(size_t Value) { return dispatch::MakeSharedRefPtr<Payload>(Value); };
+    static const char* Name(void) { return "co-located"; };
+};
+
+struct Standard
+{
+    using Ptr = std::shared_ptr<Payload>;
+    static Ptr Make(size_t Value) { return std::make_shared<Payload>(Value); };
+    static const char* Name(void) { return "std::make_shared"; };
+};
+
+template <typename Layout>
+void
+Measure(
+    void
+)
+/*++
+  Create, copy, walk in random order and release a
+  large set of pointers, reporting ns per object for
+  each phase and allocations per object
+--*/
+{
+    std::vector<typename Layout::Ptr> ptrs;
+    ptrs.reserve(OBJECTS);
+
+    auto allocations = g_Allocations.load();
+    auto start = Clock::now();
+    for (size_t i = 0; i < OBJECTS; i++)
+    {
+        ptrs.push_back(Layout::Make(i));
+    }
+    auto created = Clock::now();
+    auto perObject = (double)(g_Allocations.load() - allocations) / OBJECTS;
+
+    std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937_64(42));
+    auto walkStart = Clock::now();
+    size_t sum = 0;
+    for (size_t pass = 0; pass < PASSES; pass++)
+    {
+        for (auto& ptr : ptrs)
+        {
+            sum += ptr->m_Value;
+        }
+    }
+    auto walked = Clock::now();
+
+    {
+        auto copies = ptrs;
+    }
+    auto copied = Clock::now();
+    ptrs.clear();
+    auto released = Clock::now();
+
+    auto ns = [](Clock::time_point From, Clock::time_point To, size_t Count) {
+        return std::chrono::duration<double, std::nano>(To - From).count() / Count;
+    };
+    std::cout << std::setw(18) << Layout::Name()
+              << std::setw(10) << std::fixed << std::setprecision(1) << perObject
+              << std::setw(12) << ns(start, created, OBJECTS)
+              << std::setw(12) << ns(walkStart, walked, OBJECTS * PASSES)
+              << std::setw(12) << ns(walked, copied, OBJECTS)
+              << std::setw(12) << ns(copied, released, OBJECTS)
+              << (sum == 0 ? " " : "") << std::endl;
+}
+
+int main()
+{
+    std::cout << std::setw(18) << "layout"
+              << std::setw(10) << "allocs"
+              << std::setw(12) << "create ns"
+              << std::setw(12) << "deref ns"
+              << std::setw(12) << "copy ns"
+              << std::setw(12) << "release ns" << std::endl;
+    Measure<Separate>();
+    Measure<Colocated>();
+    Measure<Standard>();
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+
+#include "DispatchQueue.hpp"
+#include "RunQueue.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t BACKLOGS[] = { 0, 1000, 10000, 100000 };
+const size_t POSTS = 10000;
+const size_t LEGACY_POSTS = 100;
+
+void
+Nothing(
+    void
+)
+{
+    return;
+}
+
+dispatch::TaskPriority
+PriorityFor(
+    const size_t Index
+)
+{
+    return (dispatch::TaskPriority)(1 + (Index % dispatch::PRIORITY_LEVELS));
+}
+
+double
+RunQueuePostCost(
+    const size_t Backlog
+)
+/*++
+  Average cost in nanoseconds of pushing a job onto
+  a RunQueue already holding Backlog jobs
+--*/
+{
+    dispatch::RunQueue queue;
+    for (size_t i = 0; i < Backlog; i++)
+    {
+        queue.Push(dispatch::Job(dispatch::bind(&Nothing), PriorityFor(i), nullptr));
+    }
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < POSTS; i++)
+    {
+        queue.Push(dispatch::Job(dispatch::bind(&Nothing), PriorityFor(i), nullptr));
+    }
+    auto elapsed = Clock::now() - start;
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / POSTS;
+}
+
+double
+LegacyPostCost(
+    const size_t Backlog
+)
+/*++
+  Average cost in nanoseconds of the previous
+  push_back and std::sort approach
+--*/
+{
+    std::deque<dispatch::Job> queue;
+    for (size_t i = 0; i < Backlog; i++)
+    {
+        queue.push_back(dispatch::Job(dispatch::bind(&Nothing), PriorityFor(i), nullptr));
+    }
+    std::sort(queue.begin(), queue.end());
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < LEGACY_POSTS; i++)
+    {
+        queue.push_back(dispatch::Job(dispatch::bind(&Nothing), PriorityFor(i), nullptr));
+        std::sort(queue.begin(), queue.end());
+    }
+    auto elapsed = Clock::now() - start;
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / LEGACY_POSTS;
+}
+
+double g_DispatcherCost;
+
+void
+MeasureDispatcherPost(
+    const size_t Backlog
+)
+/*++
+  Runs on a dispatcher. Fill the native queue with
+  Backlog jobs and time PostTaskFast on top of it
+--*/
+{
+    for (size_t i = 0; i < Backlog; i++)
+    {
+        dispatch::PostTaskFast(dispatch::bind(&Nothing));
+    }
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < POSTS; i++)
+    {
+        dispatch::PostTaskFast(dispatch::bind(&Nothing));
+    }
+    auto elapsed = Clock::now() - start;
+
+    g_DispatcherCost = std::chrono::duration<double, std::nano>(elapsed).count() / POSTS;
+    dispatch::End();
+}
+
+int main()
+{
+    std::cout << std::setw(10) << "backlog"
+              << std::setw(16) << "runqueue ns"
+              << std::setw(16) << "dispatcher ns"
+              << std::setw(16) << "sort ns" << std::endl;
+
+    for (auto backlog : BACKLOGS)
+    {
+        auto runQueue = RunQueuePostCost(backlog);
+        dispatch::CreateAndEnterDispatcher(
+            "benchmark",
+            dispatch::bind(&MeasureDispatcherPost, backlog)
+        );
+        auto legacy = LegacyPostCost(backlog);
+
+        std::cout << std::setw(10) << backlog
+                  << std::setw(16) << std::fixed << std::setprecision(1) << runQueue
+                  << std::setw(16) << g_DispatcherCost
+                  << std::setw(16) << legacy << std::endl;
+    }
+}
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+#include "TimerWheel.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t PENDING[] = { 1000, 100000, 1000000 };
+const size_t LEGACY_INSERTS = 10;
+const size_t EXPIRY_STEPS = 1000;
+const auto MAX_DELAY = std::chrono::seconds(60);
+
+void
+Nothing(
+    void
+)
+{
+    return;
+}
+
+double
+Nanoseconds(
+    const Clock::duration Elapsed,
+    const size_t Count
+)
+{
+    return std::chrono::duration<double, std::nano>(Elapsed).count() / Count;
+}
+
+std::vector<dispatch::timepoint>
+MakeDeadlines(
+    const dispatch::timepoint Base,
+    const size_t Count
+)
+{
+    std::mt19937_64 rng(Count);
+    std::uniform_int_distribution<int64_t> delay(1000, std::chrono::microseconds(MAX_DELAY).count());
+    std::vector<dispatch::timepoint> deadlines;
+    deadlines.reserve(Count);
+    for (size_t i = 0; i < Count; i++)
+    {
+        deadlines.push_back(Base + std::chrono::microseconds(delay(rng)));
+    }
+    return deadlines;
+}
+
+void
+BenchmarkWheel(
+    const size_t Pending,
+    double& InsertCost,
+    double& ExpireCost
+)
+/*++
+  Insert Pending timers then step a synthetic clock
+  across the whole range, expiring everything
+--*/
+{
+    auto base = std::chrono::system_clock::now();
+    auto deadlines = MakeDeadlines(base, Pending);
+    dispatch::TimerWheel wheel;
+    dispatch::RunQueue queue;
+
+    auto start = Clock::now();
+    for (auto deadline : deadlines)
+    {
+        wheel.Insert(dispatch::Job(dispatch::bind(&Nothing), nullptr, deadline));
+    }
+    InsertCost = Nanoseconds(Clock::now() - start, Pending);
+
+    Clock::duration elapsed{};
+    for (size_t step = 1; step <= EXPIRY_STEPS + 1; step++)
+    {
+        auto now = base + (MAX_DELAY * step) / EXPIRY_STEPS;
+        start = Clock::now();
+        wheel.Expire(now, queue);
+        elapsed += Clock::now() - start;
+        queue.Clear();
+    }
+    ExpireCost = Nanoseconds(elapsed, Pending);
+}
+
+void
+BenchmarkSortedDeque(
+    const size_t Pending,
+    double& InsertCost,
+    double& ExpireCost
+)
+/*++
+  The previous implementation: push_back followed by
+  a full std::sort on every insert and pop_front
+  of the earliest job on expiry
+--*/
+{
+    auto compare = [](const dispatch::Job& a, const dispatch::Job& b){
+        return a.GetDispatchTime() < b.GetDispatchTime();
+    };
+    auto base = std::chrono::system_clock::now();
+    auto deadlines = MakeDeadlines(base, Pending + LEGACY_INSERTS);
+    std::deque<dispatch::Job> queue;
+    for (size_t i = 0; i < Pending; i++)
+    {
+        queue.push_back(dispatch::Job(dispatch::bind(&Nothing), nullptr, deadlines[i]));
+    }
+    std::sort(queue.begin(), queue.end(), compare);
+
+    auto start = Clock::now();
+    for (size_t i = Pending; i < Pending + LEGACY_INSERTS; i++)
+    {
+        queue.push_back(dispatch::Job(dispatch::bind(&Nothing), nullptr, deadlines[i]));
+        std::sort(queue.begin(), queue.end(), compare);
+    }
+    InsertCost = Nanoseconds(Clock::now() - start, LEGACY_INSERTS);
+
+    size_t expired = queue.size();
+    dispatch::RunQueue run;
+    start = Clock::now();
+    while (!queue.empty())
+    {
+        run.PushFront(std::move(queue.front()));
+        queue.pop_front();
+    }
+    ExpireCost = Nanoseconds(Clock::now() - start, expired);
+}
+
+int main()
+{
+    std::cout << std::setw(10) << "pending"
+              << std::setw(18) << "wheel insert ns"
+              << std::setw(18) << "wheel expire ns"
+              << std::setw(18) << "deque insert ns"
+              << std::setw(18) << "deque expire ns" << std::endl;
+
+    for (auto pending : PENDING)
+    {
+        double wheelInsert, wheelExpire, dequeInsert, dequeExpire;
+        BenchmarkWheel(pending, wheelInsert, wheelExpire);
+        BenchmarkSortedDeque(pending, dequeInsert, dequeExpire);
+        std::cout << std::setw(10) << pending << std::fixed << std::setprecision(1)
+                  << std::setw(18) << wheelInsert
+                  << std::setw(18) << wheelExpire
+                  << std::setw(18) << dequeInsert
+                  << std::setw(18) << dequeExpire << std::endl;
+    }
+}
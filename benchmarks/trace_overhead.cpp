@@ -0,0 +1,74 @@
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "DispatchQueue.hpp"
+
+//
+// Tracing off against tracing on. Configure with
+// -DDISPATCH_TRACE=OFF to compare against the hooks not
+// being compiled in at all
+//
+
+using Clock = std::chrono::steady_clock;
+
+const size_t TOTAL_TASKS = 1024 * 1024;
+const size_t ROUNDS = 5;
+
+std::atomic<bool> g_Done;
+
+void
+Chain(
+    const size_t Remaining
+)
+{
+    if (Remaining > 0)
+    {
+        dispatch::PostTask(dispatch::bind(&Chain, Remaining - 1));
+        return;
+    }
+    g_Done = true;
+}
+
+double
+Throughput(
+    dispatch::DispatcherBase* Target
+)
+/*++
+  Tasks per second through a chain of self posts, the
+  path every trace hook sits on
+--*/
+{
+    double best = 0;
+    for (size_t round = 0; round < ROUNDS; round++)
+    {
+        g_Done = false;
+        auto start = Clock::now();
+        Target->PostTask(dispatch::bind(&Chain, TOTAL_TASKS));
+        while (!g_Done.load(std::memory_order_relaxed))
+        {
+            std::this_thread::yield();
+        }
+        best = std::max(best, TOTAL_TASKS / std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+int main()
+{
+    auto dispatcher = dispatch::CreateDispatcher("chain");
+
+    auto off = Throughput(dispatcher.get());
+    dispatch::StartTracing();
+    auto on = Throughput(dispatcher.get());
+    dispatch::StopTracing();
+
+    std::cout << std::fixed << std::setprecision(0)
+              << std::setw(20) << "tracing off tasks/s" << std::setw(16) << off << std::endl
+              << std::setw(20) << "tracing on tasks/s" << std::setw(16) << on << std::endl;
+
+    dispatcher->Stop();
+    dispatch::GlobalDispatcherWait();
+}
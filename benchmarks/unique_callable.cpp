@@ -0,0 +1,152 @@
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "DispatchQueue.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t TASKS = 200000;
+
+std::atomic<size_t> g_Allocations = 0;
+
+void*
+operator new(
+    size_t Size
+)
+{
+    g_Allocations.fetch_add(1, std::memory_order_relaxed);
+    void* allocation = malloc(Size);
+    if (allocation == nullptr)
+    {
+        abort();
+    }
+    return allocation;
+}
+
+void
+operator delete(
+    void* Allocation
+) noexcept
+{
+    free(Allocation);
+}
+
+void
+operator delete(
+    void* Allocation,
+    size_t Size
+) noexcept
+{
+    free(Allocation);
+}
+
+size_t g_Sum;
+
+void
+Consume(
+    const std::string& Label,
+    const size_t Value,
+    const size_t Other
+)
+{
+    g_Sum += Label.size() + Value + Other;
+}
+
+void
+ConsumeUnique(
+    std::unique_ptr<size_t>& Value
+)
+{
+    g_Sum += *Value;
+}
+
+struct Result
+{
+    double m_NsPerTask;
+    double m_AllocationsPerTask;
+};
+
+Result g_Result;
+
+template <typename Poster>
+void
+Measure(
+    Poster Post
+)
+/*++
+  Runs on a dispatcher. Post and run TASKS tasks through
+  the native queue, counting time and heap allocations
+--*/
+{
+    std::string label = "short label";
+    auto allocations = g_Allocations.load();
+    auto start = Clock::now();
+    for (size_t i = 0; i < TASKS; i++)
+    {
+        Post(label, i);
+    }
+    dispatch::PostTaskFast(
+        dispatch::bind([start, allocations]{
+            auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            g_Result.m_NsPerTask = elapsed / TASKS;
+            g_Result.m_AllocationsPerTask = (double)(g_Allocations.load() - allocations) / TASKS;
+            dispatch::End();
+        })
+    );
+}
+
+template <typename Poster>
+Result
+Run(
+    Poster Post
+)
+{
+    dispatch::CreateAndEnterDispatcher(
+        "benchmark",
+        dispatch::bind(&Measure<Poster>, Post)
+    );
+    return g_Result;
+}
+
+void
+Print(
+    const char* Name,
+    const Result& Measured
+)
+{
+    std::cout << std::setw(28) << std::left << Name << std::right << std::fixed
+              << std::setw(14) << std::setprecision(1) << Measured.m_NsPerTask
+              << std::setw(18) << std::setprecision(2) << Measured.m_AllocationsPerTask << std::endl;
+}
+
+int main()
+{
+    std::cout << std::setw(28) << std::left << "path" << std::right
+              << std::setw(14) << "ns/task"
+              << std::setw(18) << "allocs/task" << std::endl;
+
+    //
+    // The previous path: every bind result went through a
+    // std::function, which heap allocates anything larger
+    // than its small internal buffer
+    //
+    Print("std::function Callable", Run([](const std::string& Label, size_t Value){
+        dispatch::PostTaskFast(dispatch::Callable(std::bind(&Consume, std::cref(Label), Value, Value)));
+    }));
+
+    Print("UniqueCallable", Run([](const std::string& Label, size_t Value){
+        dispatch::PostTaskFast(dispatch::bind(&Consume, std::cref(Label), Value, Value));
+    }));
+
+    Print("UniqueCallable unique_ptr", Run([](const std::string& Label, size_t Value){
+        auto owned = std::make_unique<size_t>(Value);
+        dispatch::PostTaskFast([owned = std::move(owned)]() mutable { ConsumeUnique(owned); });
+    }));
+}
@@ -0,0 +1,76 @@
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "DispatchQueue.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+const size_t BURSTS = 8;
+const size_t TASKS_PER_BURST = 512;
+const size_t LONG_TASK_EVERY = 16;
+const auto SHORT_TASK = std::chrono::microseconds(20);
+const auto LONG_TASK = std::chrono::microseconds(2000);
+
+std::atomic<size_t> g_Completed;
+
+void
+Spin(
+    const std::chrono::microseconds Duration
+)
+{
+    auto end = Clock::now() + Duration;
+    while (Clock::now() < end);
+    g_Completed++;
+}
+
+void
+Burst(
+    const size_t Burst
+)
+/*++
+  Runs on a pool worker and fans out a burst of
+  tasks with heterogeneous durations
+--*/
+{
+    for (size_t i = 0; i < TASKS_PER_BURST; i++)
+    {
+        auto duration = (i + Burst) % LONG_TASK_EVERY == 0 ? LONG_TASK : SHORT_TASK;
+        dispatch::PostTask(dispatch::bind(&Spin, duration));
+    }
+}
+
+double
+Makespan(
+    const dispatch::PoolMode Mode,
+    const char* Name
+)
+{
+    g_Completed = 0;
+    auto pool = dispatch::CreateDispatchPool(Name, 0, Mode);
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < BURSTS; i++)
+    {
+        pool->PostTask(dispatch::bind(&Burst, i));
+    }
+    while (g_Completed < BURSTS * TASKS_PER_BURST)
+    {
+        std::this_thread::yield();
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    pool->Stop();
+    pool->Wait();
+    return elapsed;
+}
+
+int main()
+{
+    std::cout << "workers: " << std::thread::hardware_concurrency() << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "round-robin makespan:   " << Makespan(dispatch::PoolMode::ROUND_ROBIN, "round-robin") << " ms" << std::endl;
+    std::cout << "work-stealing makespan: " << Makespan(dispatch::PoolMode::WORK_STEALING, "work-stealing") << " ms" << std::endl;
+}
@@ -2,17 +2,20 @@
 
 #include <functional>
 
+#include "UniqueCallable.hpp"
+
 namespace dispatch{
 
     using Callable = std::function<void(void)>;
 
     template<class... Args>
-    Callable bind(Args&&... x)
+    UniqueCallable bind(Args&&... x)
     /*++
-      std::bind wrapper to return a formal Callable
+      std::bind wrapper to return a formal UniqueCallable.
+      The bound arguments are stored inline when they fit
     --*/
     { 
-        return Callable(
+        return UniqueCallable(
             std::bind(
                 std::forward<Args>(x)...
             )
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <memory>
+
+#include "DispatcherBase.hpp"
+#include "SharedRefptr.hpp"
+
+namespace dispatch
+{
+
+    //
+    // Deletes queued on one thread are posted together,
+    // one task per target dispatcher, once this many are
+    // waiting or the thread's dispatcher runs out of work
+    //
+    constexpr size_t DELETE_SOON_BATCH = 64;
+
+    void PostDeleteSoon(DispatcherBase* Dispatcher, void (*Delete)(void*), void* Object);
+    void FlushDeleteSoon(void);
+
+    template <typename T>
+    void
+    _DeleteObject(
+        void* Object
+    )
+    {
+        delete static_cast<T*>(Object);
+    }
+
+    template <typename T>
+    void
+    DeleteSoon(
+        DispatcherBase* Dispatcher,
+        T* Object
+    )
+    /*++
+      Delete Object on Dispatcher instead of here, so a big
+      teardown runs off this thread and next to the data
+      it touches
+    --*/
+    {
+        if (Object != nullptr)
+        {
+            PostDeleteSoon(Dispatcher, &_DeleteObject<T>, Object);
+        }
+    }
+
+    template <typename T>
+    void
+    DeleteSoon(
+        DispatcherBase* Dispatcher,
+        std::unique_ptr<T> Object
+    )
+    {
+        DeleteSoon(Dispatcher, Object.release());
+    }
+
+    template <typename T, RefCounting Mode>
+    void
+    ReleaseSoon(
+        DispatcherBase* Dispatcher,
+        SharedRefPtr<T,Mode> Ptr
+    )
+    /*++
+      Drop our reference on Dispatcher. If it is the last
+      one, the object is destroyed there
+    --*/
+    {
+        if (Ptr)
+        {
+            PostDeleteSoon(Dispatcher, &SharedRefPtr<T,Mode>::_ReleaseDetached, Ptr._Detach());
+        }
+    }
+
+}
@@ -1,36 +1,230 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <deque>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <vector>
 
 #include "DispatcherBase.hpp"
+#include "Topology.hpp"
+#include "WorkStealingDeque.hpp"
 
 namespace dispatch
 {
 
+    enum class PoolMode : char
+    {
+        ROUND_ROBIN,
+        WORK_STEALING
+    };
+
+    enum class PoolRouting : char
+    {
+        ROUND_ROBIN,
+        TWO_CHOICES,
+        LEAST_LOADED
+    };
+
+    //
+    // A post from a pool worker stays on that worker while
+    // it has fewer than this many tasks queued
+    //
+    constexpr size_t POOL_LOCAL_DEPTH = 2;
+
+    //
+    // Defaults for elastic pools, and how often one
+    // checks whether to grow or shrink
+    //
+    constexpr auto POOL_GROW_WAIT = std::chrono::microseconds(2000);
+    constexpr auto POOL_RETIRE_IDLE = std::chrono::milliseconds(1000);
+    constexpr auto POOL_BALANCE_INTERVAL = std::chrono::milliseconds(10);
+
+    enum class PoolPlacement : char
+    {
+        NONE,
+        PIN_CORES,
+        NUMA_NODES
+    };
+
+    struct PoolConfig
+    /*++
+      How to build a DispatchPool. PIN_CORES pins each
+      worker to one core and NUMA_NODES lets each worker
+      float within one node, spreading workers across nodes
+      either way. Explicit m_CpuSets take precedence, worker
+      i getting m_CpuSets[i % m_CpuSets.size()]. A size of 0
+      means one worker per core we may run on.
+
+      m_Routing picks the worker for each post when there
+      is no stealing. TWO_CHOICES takes the less loaded of
+      two random workers and LEAST_LOADED scans them all,
+      load being the tasks routed to a worker that have not
+      finished yet.
+
+      A task posted from one of the pool's own workers goes
+      onto that worker's native queue while it has fewer
+      than m_LocalDepth tasks queued, and is routed as any
+      other post once it has more. 0 always routes.
+
+      An m_MaxSize above the pool's size makes it elastic,
+      starting with m_Size workers and adding one at a time
+      up to m_MaxSize while tasks wait in the queues longer
+      than m_GrowWait on average. A worker above m_Size
+      that has been parked for m_RetireIdle is retired
+    --*/
+    {
+        size_t m_Size = 0;
+        PoolMode m_Mode = PoolMode::ROUND_ROBIN;
+        PoolRouting m_Routing = PoolRouting::ROUND_ROBIN;
+        PoolPlacement m_Placement = PoolPlacement::NONE;
+        std::vector<CpuSet> m_CpuSets;
+        size_t m_LocalDepth = POOL_LOCAL_DEPTH;
+        size_t m_MaxSize = 0;
+        std::chrono::microseconds m_GrowWait = POOL_GROW_WAIT;
+        std::chrono::milliseconds m_RetireIdle = POOL_RETIRE_IDLE;
+    };
+
+    struct WorkerPlacement
+    {
+        std::string m_Name;
+        int m_Node;
+        CpuSet m_Cpus;
+    };
+
+    enum class WorkerState : char
+    {
+        STOPPED,
+        RUNNING,
+        RETIRING
+    };
+
+    struct QueueProbe
+    /*++
+      Measures how long tasks wait in a queue by timing
+      one through it. m_Sent is 0 when none is in flight
+    --*/
+    {
+        std::atomic<int64_t> m_Sent = 0;
+        std::atomic<int64_t> m_Wait = 0;
+    };
+
+    class DispatchPool;
+
+    class PoolWorker : public Dispatcher
+    /*++
+      A Dispatcher owned by a DispatchPool. In work-stealing
+      mode each worker owns a Chase-Lev deque; tasks posted
+      to the pool from the worker go to the bottom of it and
+      idle siblings steal from the top.
+
+      In an elastic pool the worker's thread comes and goes
+      while the worker itself lives as long as the pool
+    --*/
+    {
+    public:
+        PoolWorker(const std::string& Name, DispatchPool* Pool, const size_t Index);
+        ~PoolWorker(void);
+    protected:
+        void OnThreadStart(void) override;
+        JobNode* AcquireWork(void) override;
+        bool ExternalWorkPending(void) override;
+        void OnPark(const bool Parked) override;
+        void OnRoutedJobDone(void) override;
+        void Notify(void) override;
+    private:
+        friend class DispatchPool;
+        void Retire(void);
+        void Unretire(void);
+        JobNode* StealFromSibling(void);
+        JobNode* StealFrom(const std::vector<size_t>& Victims, const bool SkipLocal);
+        DispatchPool* m_Pool;
+        const size_t m_Index;
+        uint64_t m_Seed;
+        int m_Node = 0;
+        size_t m_NodeIndex = 0;
+        CpuSet m_Affinity;
+        WorkStealingDeque<JobNode> m_Deque;
+        std::atomic<bool> m_Parked = false;
+        std::atomic<WorkerState> m_State = WorkerState::STOPPED;
+        std::atomic<int64_t> m_IdleSince = 0;
+        QueueProbe m_Probe;
+        //
+        // Written by every poster, kept off the line the
+        // worker's own fields live on
+        //
+        alignas(64) std::atomic<size_t> m_Pending = 0;
+    };
+
+    using PoolWorkerUPtr = std::unique_ptr<PoolWorker>;
+
     class DispatchPool : public DispatcherBase
     {
     public:
         DispatchPool(void) = delete;
-        DispatchPool(const std::string& Name, const size_t Size = 0);
-        void PostTask(const Callable& Task, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) override;
-        void PostTaskAndReply(const Callable& Task, const Callable& Reply, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) override;
-        ~DispatchPool(void) = default;
+        DispatchPool(const std::string& Name, const size_t Size = 0, const PoolMode Mode = PoolMode::ROUND_ROBIN);
+        DispatchPool(const std::string& Name, const PoolConfig& Config);
+        void PostTask(UniqueCallable Task, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) override;
+        void PostTaskAndReply(UniqueCallable Task, UniqueCallable Reply, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) override;
+        void PostTasks(TaskBatch Tasks, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) override;
+        ~DispatchPool(void);
         void Run(void) override {return;};
         void Stop(void) override;
         void Start(void) override;
         bool Wait(void) override;
+        void SetIdlePolicy(const IdlePolicy Policy, const uint32_t Spins = IDLE_SPINS, const uint32_t Yields = IDLE_YIELDS) override;
+        PoolMode GetMode(void) const { return m_Mode; };
+        PoolRouting GetRouting(void) const { return m_Routing; };
+        size_t GetLocalDepth(void) const { return m_LocalDepth; };
+        std::vector<size_t> GetWorkerLoad(void);
+        size_t GetWorkerCount(void) const { return m_Live.load(std::memory_order_relaxed); };
+        size_t GetMinWorkerCount(void) const { return m_MinSize; };
+        size_t GetMaxWorkerCount(void) const { return m_Dispatchers.size(); };
+        size_t GetRunningWorkerCount(void) const { return m_Active.load(std::memory_order_relaxed); };
+        bool IsElastic(void) const { return m_Dispatchers.size() > m_MinSize; };
+        size_t GetNodeCount(void) const { return m_NodeWorkers.size(); };
+        std::vector<WorkerPlacement> GetPlacement(void);
+        DispatcherMetrics GetMetrics(void) override;
     protected:
         void OnDispatcherTerminated(DispatcherBase* Dispatacher);
     private:
-        DispatcherBase* Next(void);
-        std::vector<DispatcherUPtr> m_Dispatchers;
+        friend class PoolWorker;
+        PoolWorker* Next(const size_t Count = 1);
+        PoolWorker* Target(void);
+        void PostStealable(Job&& ToPost);
+        JobNode* PopInjected(void);
+        bool StealableWorkPending(void);
+        void WakeParkedWorker(const size_t Count = 1);
+        bool StartWorker(PoolWorker* Worker);
+        void Revive(PoolWorker* Worker);
+        void Balance(void);
+        void ArmBalance(void);
+        bool NothingQueued(void);
+        void SendProbe(QueueProbe* Probe, PoolWorker* Worker);
+        std::vector<PoolWorkerUPtr> m_Dispatchers;
+        std::vector<size_t> m_AllWorkers;
+        std::vector<std::vector<size_t>> m_NodeWorkers;
         std::atomic<size_t> m_Active;
         std::atomic<size_t> m_Dispatched;
+        const PoolMode m_Mode;
+        const PoolRouting m_Routing;
+        const size_t m_LocalDepth;
+        size_t m_MinSize;
+        std::atomic<size_t> m_Live;
+        const std::chrono::microseconds m_GrowWait;
+        const std::chrono::milliseconds m_RetireIdle;
+        std::mutex m_ElasticMutex;
+        std::atomic<bool> m_Stopping = false;
+        std::atomic<bool> m_Balancing = false;
+        QueueProbe m_InjectorProbe;
+        std::mutex m_InjectorMutex;
+        std::deque<JobNode*> m_Injector;
+        std::atomic<size_t> m_Injected = 0;
+        std::atomic<size_t> m_Parked = 0;
     };
 
     using DispatchPoolPtr = std::shared_ptr<DispatchPool>;
     using DispatcherPoolPtr = DispatchPoolPtr;
-}
\ No newline at end of file
+}
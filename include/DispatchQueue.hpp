@@ -7,8 +7,14 @@
 #include <string>
 
 #include "Job.hpp"
+#include "DeleteSoon.hpp"
 #include "DispatcherBase.hpp"
 #include "DispatchPool.hpp"
+#include "Future.hpp"
+#include "Parallel.hpp"
+#include "ReactorDispatcher.hpp"
+#include "TaskGraph.hpp"
+#include "Task.hpp"
 
 namespace dispatch
 {
@@ -19,26 +25,44 @@ namespace dispatch
     DispatcherBase* CurrentDispatcher(void);
 
     DispatcherBasePtr CreateDispatcher(void);
-    DispatcherBasePtr CreateDispatcher(const Callable& EntryPoint);
+    DispatcherBasePtr CreateDispatcher(UniqueCallable EntryPoint);
     DispatcherBasePtr CreateDispatcher(const std::string& Name);
-    DispatcherBasePtr CreateDispatcher(const std::string& Name, const Callable& EntryPoint);
-    DispatcherBasePtr CreateAndEnterDispatcher(const std::string& Name, const Callable& EntryPoint);
-    DispatcherPoolPtr CreateDispatchPool(const std::string& Name, const size_t Size = 0);
+    DispatcherBasePtr CreateDispatcher(const std::string& Name, UniqueCallable EntryPoint);
+    DispatcherBasePtr CreateAndEnterDispatcher(const std::string& Name, UniqueCallable EntryPoint);
+#ifdef __linux__
+    ReactorDispatcherPtr CreateReactorDispatcher(const std::string& Name);
+#endif
+    DispatcherPoolPtr CreateDispatchPool(const std::string& Name, const size_t Size = 0, const PoolMode Mode = PoolMode::ROUND_ROBIN);
+    DispatcherPoolPtr CreateDispatchPool(const std::string& Name, const PoolConfig& Config);
     DispatcherBasePtr GetDispatcher(std::string Name);
+    DispatcherHandle GetDispatcherHandle(const std::string& Name);
+    std::vector<DispatcherMetrics> SnapshotMetrics(void);
     void RemoveDispatcher(DispatcherBase* Dispatcher);
-    void PostTaskToDispatcher(DispatcherBase* Dispatcher, const Callable& Job);
-    void PostTaskToDispatcher(DispatcherBasePtr Dispatcher, const Callable& Job);
-    void PostTaskToDispatcher(const std::string& Name, const Callable& Job);
-    void PostDelayedTaskToDispatcher(DispatcherBase* Dispatcher, const Callable& Job, const std::chrono::microseconds Delay);
-    void PostDelayedTaskToDispatcher(DispatcherBasePtr Dispatcher, const Callable& Job, const std::chrono::microseconds Delay);
-    void PostDelayedTaskToDispatcher(const std::string& Name, const Callable& Job, const std::chrono::microseconds Delay);
-    void PostTaskAndReply(DispatcherBasePtr Dispatcher, const Callable& Job, const Callable& Reply);
-    void PostTaskAndReply(const std::string& Name, const Callable& Job, const Callable& Reply);
-    void PostDelayedTask(const Callable& Job, const std::chrono::microseconds Delay);
-    void PostDelayedTaskStrict(const Callable& Job, const std::chrono::microseconds Delay);
-    void PostTask(const Callable& Job);
-    void PostTaskStrict(const Callable& Job);
-    void PostTaskFast(const Callable& Job);
+    void PostTaskToDispatcher(DispatcherBase* Dispatcher, UniqueCallable Job);
+    void PostTaskToDispatcher(DispatcherBasePtr Dispatcher, UniqueCallable Job);
+    void PostTaskToDispatcher(const std::string& Name, UniqueCallable Job);
+    bool PostTaskToDispatcher(const DispatcherHandle& Dispatcher, UniqueCallable Job);
+    void PostTasksToDispatcher(DispatcherBase* Dispatcher, TaskBatch Jobs);
+    void PostTasksToDispatcher(DispatcherBasePtr Dispatcher, TaskBatch Jobs);
+    void PostTasksToDispatcher(const std::string& Name, TaskBatch Jobs);
+    bool PostTasksToDispatcher(const DispatcherHandle& Dispatcher, TaskBatch Jobs);
+    void PostDelayedTaskToDispatcher(DispatcherBase* Dispatcher, UniqueCallable Job, const std::chrono::microseconds Delay);
+    void PostDelayedTaskToDispatcher(DispatcherBasePtr Dispatcher, UniqueCallable Job, const std::chrono::microseconds Delay);
+    void PostDelayedTaskToDispatcher(const std::string& Name, UniqueCallable Job, const std::chrono::microseconds Delay);
+    bool PostDelayedTaskToDispatcher(const DispatcherHandle& Dispatcher, UniqueCallable Job, const std::chrono::microseconds Delay);
+    void PostTaskAndReply(DispatcherBasePtr Dispatcher, UniqueCallable Job, UniqueCallable Reply);
+    void PostTaskAndReply(const std::string& Name, UniqueCallable Job, UniqueCallable Reply);
+    bool PostTaskAndReply(const DispatcherHandle& Dispatcher, UniqueCallable Job, UniqueCallable Reply);
+    void PostDelayedTask(UniqueCallable Job, const std::chrono::microseconds Delay);
+    void PostDelayedTaskStrict(UniqueCallable Job, const std::chrono::microseconds Delay);
+    void PostTask(UniqueCallable Job);
+    void PostTasks(TaskBatch Jobs);
+    void PostTaskStrict(UniqueCallable Job);
+    void PostTaskFast(UniqueCallable Job);
+
+    void AsyncRead(const int Fd, void* Buffer, const size_t Length, const uint64_t Offset, IoCompletion Completion);
+    void AsyncWrite(const int Fd, const void* Buffer, const size_t Length, const uint64_t Offset, IoCompletion Completion);
+    void AsyncFsync(const int Fd, IoCompletion Completion);
 
     bool OnDispatcher(const std::string& Name);
     void KeepAlive(const bool KeepAlive);
@@ -1,55 +1,112 @@
 #pragma once
 
+#include <stdint.h>
+
 #include <atomic>
 #include <chrono>
-#include <deque>
 #include <mutex>
 #include <condition_variable>
+#include <span>
 #include <string>
 #include <thread>
+#include <vector>
 #include "Callable.hpp"
+#include "DispatcherHandle.hpp"
+#include "FutureTable.hpp"
+#include "IoRing.hpp"
 #include "Job.hpp"
+#include "JobAllocator.hpp"
+#include "Metrics.hpp"
+#include "MpscQueue.hpp"
+#include "RunQueue.hpp"
+#include "TimerWheel.hpp"
+#include "Trace.hpp"
 
 namespace dispatch{
 
+    enum class IdlePolicy : char
+    {
+        ADAPTIVE,
+        SPIN,
+        YIELD,
+        BLOCK
+    };
+
+    //
+    // Default number of polls in each phase of the
+    // ADAPTIVE idle policy before moving to the next.
+    // The spin phase is skipped on single core machines
+    //
+    constexpr uint32_t IDLE_SPINS = 256;
+    constexpr uint32_t IDLE_YIELDS = 16;
+
     class DispatcherBase;
+    struct ScheduleAwaiter;
     using DestructionHandler = std::function<void(DispatcherBase*)>;
     using CompletionHandler = std::function<void(DispatcherBase*)>;
-
-    extern const dispatch::timepoint MAXTIME;
+    using TaskBatch = std::vector<UniqueCallable>;
 
     class DispatcherBase
     {
     public:
         DispatcherBase(void) = delete;
-        DispatcherBase(const std::string& Name) : m_Name(Name) {};
+        DispatcherBase(const std::string& Name) :
+            m_Name(Name),
+            m_Allocator(new JobAllocator(this)),
+            m_FrameAllocator(new JobAllocator(this, FRAME_SLOT_SIZE)) {};
         virtual ~DispatcherBase(void);
         virtual void Run(void);
         void Enter(void);
-        virtual void PostTask(const Callable& Task, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) = 0;
-        void PostDelayedTask(const Callable& Task, const std::chrono::microseconds Delay);
-        virtual void PostTaskAndReply(const Callable& Task, const Callable& Reply, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) = 0;
+        virtual void PostTask(UniqueCallable Task, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) = 0;
+        virtual void PostTasks(TaskBatch Tasks, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL);
+        void PostDelayedTask(UniqueCallable Task, const std::chrono::microseconds Delay);
+        ScheduleAwaiter Schedule(const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL);
+        virtual void PostTaskAndReply(UniqueCallable Task, UniqueCallable Reply, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) = 0;
         virtual bool Wait(void);
         virtual void Stop(void);
         virtual void Start(void) { Run(); };
         void KeepAlive(const bool KeepAlive) { m_KeepAlive = KeepAlive; };
+        virtual void SetIdlePolicy(const IdlePolicy Policy, const uint32_t Spins = IDLE_SPINS, const uint32_t Yields = IDLE_YIELDS);
+        IdlePolicy GetIdlePolicy(void) const { return m_IdlePolicy.load(std::memory_order_relaxed); };
         bool Stopped(void) { return m_Completed; };
         bool Completed(void) { return m_Completed; };
         std::string GetName(void) { return m_Name; };
-        size_t Size(void) { return m_Queue.size() + m_DelayedQueue.size(); };
+        size_t Size(void) { return m_Queue.Size() + m_DelayedQueue.Size(); };
         bool Empty(void) { return Size() == 0; };
         void SetDestructionHandler(DestructionHandler Handler) { m_DestructionHandler = Handler; };
         void SetCompletionHandler(CompletionHandler Handler) { m_CompletionHandler = Handler; };
         void SetThreadDispatcher(DispatcherBase* Dispatcher);
+        void SetHandle(const DispatcherHandle Handle) { m_Handle = Handle; };
+        DispatcherHandle GetHandle(void) const { return m_Handle; };
+        void Wake(void);
+        JobAllocator* GetAllocator(void) { return m_Allocator; };
+        JobAllocatorStatistics GetAllocatorStatistics(void) const { return m_Allocator->GetStatistics(); };
+        JobAllocator* GetFrameAllocator(void) { return m_FrameAllocator; };
+        JobAllocatorStatistics GetFrameAllocatorStatistics(void) const { return m_FrameAllocator->GetStatistics(); };
+        IoRing* GetIoRing(void);
+        FutureTable& GetFutureTable(void) { return m_Futures; };
+        virtual DispatcherMetrics GetMetrics(void);
     protected:
         void PostTaskInternal(Job TaskJob);
+        void PostJobNode(JobNode* Node);
+        void PostJobChain(JobNode* First, JobNode* Last);
+        void PostTaskSpan(std::span<UniqueCallable> Tasks, const TaskPriority Priority, const bool Routed = false);
+        virtual void OnThreadStart(void) { return; };
+        virtual JobNode* AcquireWork(void) { return nullptr; };
+        virtual bool ExternalWorkPending(void) { return false; };
+        virtual void OnPark(const bool Parked) { return; };
+        virtual void Block(void);
+        virtual void Notify(void);
+        virtual bool PollEvents(void) { return false; };
+        virtual void OnRoutedJobDone(void) { return; };
+        void Handled(const size_t Count, const int64_t Nanoseconds);
         void NotifyCompletion(void) { if (m_CompletionHandler) m_CompletionHandler(this); };
         void NotifyDestruction(void) { if (m_DestructionHandler) m_DestructionHandler(this); };
         bool OnNativeThread(void) { return m_ThreadId == std::this_thread::get_id(); };
-        std::deque<Job> m_Queue;
-        std::deque<Job> m_DelayedQueue;
+        RunQueue m_Queue;
+        TimerWheel m_DelayedQueue;
         std::mutex m_CrossThreadMutex;
-        std::deque<Job> m_CrossThread;
+        MpscQueue<JobNode> m_CrossThread;
         std::condition_variable m_TaskAvailable;
         std::thread m_Thread;
         std::thread::id m_ThreadId;
@@ -59,18 +116,33 @@ namespace dispatch{
         bool m_Stop = false;
         bool m_Completed = false;
         size_t m_TasksCompleted = 0;
-        size_t m_Keepalives = 0;
         std::atomic<bool> m_Waiting;
         dispatch::timepoint m_NextDelayedTask = dispatch::MAXTIME;
+        std::atomic<IoRing*> m_IoRing = nullptr;
     private:
         void StopTask(void);
-        void KeepAliveInternal(void);
+        bool WorkArrived(void);
+        void Idle(void);
+        void Park(void);
         void DispatchLoop(void);
         void DispatchJob(Job ToRun);
+        void DrainCrossThread(void);
+        void Enqueue(Job&& ToQueue);
 
         CompletionHandler m_CompletionHandler;
         DestructionHandler m_DestructionHandler;
         DispatcherBase* m_ThreadDispatcher = nullptr;
+        DispatcherHandle m_Handle;
+        JobAllocator* const m_Allocator;
+        JobAllocator* const m_FrameAllocator;
+        std::atomic<IdlePolicy> m_IdlePolicy = IdlePolicy::ADAPTIVE;
+        std::atomic<uint32_t> m_IdleSpins = IDLE_SPINS;
+        std::atomic<uint32_t> m_IdleYields = IDLE_YIELDS;
+        std::atomic<bool> m_Sleeping = false;
+        FutureTable m_Futures;
+#ifndef DISPATCH_NO_METRICS
+        MetricsBlock m_Metrics;
+#endif
     };
 
     class Dispatcher : public DispatcherBase
@@ -78,8 +150,8 @@ namespace dispatch{
     public:
         Dispatcher(const std::string& Name):DispatcherBase::DispatcherBase(Name){};
         // ~Dispatcher(void) { DispatcherBase::~DispatcherBase(); } override;
-        void PostTask(const Callable& Task, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) override;
-        void PostTaskAndReply(const Callable& Task, const Callable& Reply, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) override;
+        void PostTask(UniqueCallable Task, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) override;
+        void PostTaskAndReply(UniqueCallable Task, UniqueCallable Reply, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) override;
         ~Dispatcher(void) = default;
         using DispatcherBase::Run;
         using DispatcherBase::Start;
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Job.hpp"
+#include "UniqueCallable.hpp"
+
+namespace dispatch
+{
+
+    class DispatcherBase;
+    using TaskBatch = std::vector<UniqueCallable>;
+
+    class DispatcherHandle
+    /*++
+      A small copyable token for a tracked dispatcher,
+      resolved once from its name. Posting through it
+      takes no global lock and copies no shared_ptr. Once
+      the dispatcher is removed, or its name reused, posts
+      through old handles fail and return false, even when
+      the removal races with the post
+    --*/
+    {
+    public:
+        static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+        DispatcherHandle(void) = default;
+        DispatcherHandle(const uint32_t Index, const uint32_t Generation) : m_Index(Index), m_Generation(Generation) {};
+        bool PostTask(UniqueCallable Task, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) const;
+        bool PostTasks(TaskBatch Tasks, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) const;
+        bool PostDelayedTask(UniqueCallable Task, const std::chrono::microseconds Delay) const;
+        bool PostTaskAndReply(UniqueCallable Task, UniqueCallable Reply, const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL) const;
+        std::shared_ptr<DispatcherBase> Lock(void) const;
+        bool Valid(void) const;
+        uint64_t GetId(void) const { return ((uint64_t)m_Generation << 32) | m_Index; };
+        uint32_t GetIndex(void) const { return m_Index; };
+        uint32_t GetGeneration(void) const { return m_Generation; };
+        explicit operator bool(void) const { return m_Index != INVALID_INDEX; };
+        bool operator==(const DispatcherHandle& Other) const { return GetId() == Other.GetId(); };
+    private:
+        DispatcherBase* Acquire(void) const;
+        void Release(void) const;
+        uint32_t m_Index = INVALID_INDEX;
+        uint32_t m_Generation = 0;
+    };
+
+    //
+    // The registry behind named dispatchers, used by
+    // DispatchQueue.cpp
+    //
+    DispatcherHandle RegisterDispatcher(const std::string& Name, std::shared_ptr<DispatcherBase> Dispatcher);
+    void UnregisterDispatcher(const std::string& Name, const DispatcherHandle Handle);
+    DispatcherHandle LookupDispatcher(const std::string& Name);
+    std::vector<std::shared_ptr<DispatcherBase>> ListDispatchers(void);
+
+}
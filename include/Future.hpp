@@ -0,0 +1,265 @@
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "DispatcherBase.hpp"
+#include "FutureTable.hpp"
+#include "Job.hpp"
+
+namespace dispatch
+{
+    extern thread_local DispatcherBase* ThreadQueue;
+
+    //
+    // The reply of the job currently running on this
+    // thread, if it has one
+    //
+    extern thread_local JobNode* ThreadReply;
+
+    template <typename R>
+    class Future
+    /*++
+      The result of PostTaskWithResult. It belongs to the
+      dispatcher that posted the task and must only be used
+      there, which is also where the continuation runs.
+      Then on a future that is already complete calls the
+      continuation straight away
+    --*/
+    {
+    public:
+        Future(void) = default;
+        explicit Future(const uint32_t Slot) : m_Slot(Slot) { FutureTable::Update(Slot, this); };
+        Future(const Future& Other) = delete;
+        Future& operator=(const Future& Other) = delete;
+
+        Future(
+            Future&& Other
+        ) noexcept
+        {
+            *this = std::move(Other);
+        }
+
+        Future&
+        operator=(
+            Future&& Other
+        ) noexcept
+        {
+            if (this != &Other)
+            {
+                Abandon();
+                m_Value = std::move(Other.m_Value);
+                m_Continuation = std::move(Other.m_Continuation);
+                m_Deliver = std::exchange(Other.m_Deliver, nullptr);
+                m_Slot = std::exchange(Other.m_Slot, FutureTable::NO_SLOT);
+                if (m_Slot != FutureTable::NO_SLOT)
+                {
+                    FutureTable::Update(m_Slot, this);
+                }
+                Other.m_Value.reset();
+            }
+            return *this;
+        }
+
+        ~Future(
+            void
+        )
+        {
+            Abandon();
+        }
+
+        bool Ready(void) const { return m_Value.has_value(); };
+        bool Pending(void) const { return m_Slot != FutureTable::NO_SLOT; };
+        R& Get(void) { assert(Ready()); return *m_Value; };
+
+        template <typename Fn>
+        void
+        Then(
+            Fn&& Continuation
+        )
+        /*++
+          Call Continuation with the result on this
+          dispatcher. Only one continuation may be set, and
+          it consumes the result
+        --*/
+        {
+            assert(!m_Continuation);
+            if (m_Value)
+            {
+                auto value = std::move(*m_Value);
+                m_Value.reset();
+                Continuation(std::move(value));
+                return;
+            }
+            assert(Pending());
+            m_Continuation = Deferred<std::decay_t<Fn>>{ std::forward<Fn>(Continuation) };
+            m_Deliver = &Deliver<std::decay_t<Fn>>;
+        }
+
+        void
+        Complete(
+            R&& Value
+        )
+        /*++
+          Called by the reply. The continuation may destroy
+          this future, so it is moved out first
+        --*/
+        {
+            FutureTable::Release(std::exchange(m_Slot, FutureTable::NO_SLOT));
+            if (!m_Continuation)
+            {
+                m_Value.emplace(std::move(Value));
+                return;
+            }
+            auto continuation = std::move(m_Continuation);
+            std::exchange(m_Deliver, nullptr)(continuation, std::move(Value));
+            continuation();
+        }
+
+    private:
+        template <typename Fn>
+        struct Deferred
+        {
+            Fn m_Continuation;
+            std::optional<R> m_Value;
+            void operator()(void) { m_Continuation(std::move(*m_Value)); };
+        };
+
+        template <typename Fn>
+        static void
+        Deliver(
+            UniqueCallable& Continuation,
+            R&& Value
+        )
+        {
+            Continuation.target<Deferred<Fn>>()->m_Value.emplace(std::move(Value));
+        }
+
+        void
+        Abandon(
+            void
+        )
+        {
+            if (m_Slot != FutureTable::NO_SLOT)
+            {
+                FutureTable::Release(std::exchange(m_Slot, FutureTable::NO_SLOT));
+            }
+        }
+
+        std::optional<R> m_Value;
+        UniqueCallable m_Continuation;
+        void (*m_Deliver)(UniqueCallable&, R&&) = nullptr;
+        uint32_t m_Slot = FutureTable::NO_SLOT;
+    };
+
+    template <typename R, typename Fn>
+    struct ResultReply
+    /*++
+      Reply holding the result of its task inline, so it
+      travels back in the reply node with no extra
+      allocation
+    --*/
+    {
+        std::optional<R> m_Result;
+        Fn m_Reply;
+        void operator()(void) { m_Reply(std::move(*m_Result)); };
+    };
+
+    template <typename R>
+    struct FutureReply
+    {
+        std::optional<R> m_Result;
+        uint32_t m_Slot;
+        uint32_t m_Generation;
+
+        void
+        operator()(
+            void
+        )
+        {
+            auto future = (Future<R>*)FutureTable::Lookup(m_Slot, m_Generation);
+            if (future != nullptr)
+            {
+                future->Complete(std::move(*m_Result));
+            }
+        }
+    };
+
+    template <typename Reply, typename Fn>
+    UniqueCallable
+    StoreResultInReply(
+        Fn&& Task
+    )
+    /*++
+      Wrap Task so that its result is written into the
+      Reply it was posted with
+    --*/
+    {
+        return [Task = std::forward<Fn>(Task)]() mutable {
+            assert(ThreadReply != nullptr);
+            auto reply = ThreadReply->m_Job.template Target<Reply>();
+            assert(reply != nullptr);
+            reply->m_Result.emplace(Task());
+        };
+    }
+
+    template <
+        typename Fn,
+        typename OnResult,
+        typename R = std::invoke_result_t<std::decay_t<Fn>&>,
+        typename = std::enable_if_t<std::is_invocable_v<std::decay_t<OnResult>&, R&&>>
+    >
+    void
+    PostTaskWithResult(
+        DispatcherBase* Dispatcher,
+        Fn&& Task,
+        OnResult&& Reply,
+        const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL
+    )
+    /*++
+      Run Task on Dispatcher and call Reply with its result
+      on the current dispatcher
+    --*/
+    {
+        static_assert(!std::is_void_v<R>, "use PostTaskAndReply for tasks without a result");
+        using Stored = ResultReply<R, std::decay_t<OnResult>>;
+        Dispatcher->PostTaskAndReply(
+            StoreResultInReply<Stored>(std::forward<Fn>(Task)),
+            Stored{ std::nullopt, std::forward<OnResult>(Reply) },
+            Priority
+        );
+    }
+
+    template <
+        typename Fn,
+        typename R = std::invoke_result_t<std::decay_t<Fn>&>
+    >
+    Future<R>
+    PostTaskWithResult(
+        DispatcherBase* Dispatcher,
+        Fn&& Task,
+        const TaskPriority Priority = TaskPriority::PRIORITY_NORMAL
+    )
+    /*++
+      Run Task on Dispatcher, returning a Future for its
+      result on the current dispatcher
+    --*/
+    {
+        static_assert(!std::is_void_v<R>, "use PostTaskAndReply for tasks without a result");
+        assert(ThreadQueue != nullptr);
+        uint32_t generation;
+        auto slot = FutureTable::Acquire(generation);
+        Future<R> future(slot);
+        Dispatcher->PostTaskAndReply(
+            StoreResultInReply<FutureReply<R>>(std::forward<Fn>(Task)),
+            FutureReply<R>{ std::nullopt, slot, generation },
+            Priority
+        );
+        return future;
+    }
+
+}
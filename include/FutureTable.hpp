@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace dispatch
+{
+
+    struct FutureSlot
+    {
+        void* m_Future;
+        uint32_t m_Generation;
+        uint32_t m_NextFree;
+    };
+
+    class FutureTable
+    /*++
+      Slots linking a pending Future to the reply that will
+      complete it. The reply only carries a slot index and
+      generation, so a Future can move or go away while its
+      task is in flight, and a reply that is dropped unrun
+      never touches it.
+
+      Each dispatcher owns a table, which outlives any one
+      thread it runs on. The static calls work on the table
+      of the dispatcher running on this thread, the only one
+      that ever touches it, so none of this needs locking
+    --*/
+    {
+    public:
+        static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+        static uint32_t Acquire(uint32_t& Generation);
+        static void Update(const uint32_t Slot, void* Future);
+        static void Release(const uint32_t Slot);
+        static void* Lookup(const uint32_t Slot, const uint32_t Generation);
+    private:
+        static FutureTable* Current(void);
+        std::vector<FutureSlot> m_Slots;
+        uint32_t m_FreeSlot = NO_SLOT;
+    };
+
+}
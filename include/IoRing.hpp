@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Job.hpp"
+#include "RunQueue.hpp"
+
+namespace dispatch
+{
+
+    //
+    // Called on the posting dispatcher with the number of
+    // bytes transferred, or -errno on failure
+    //
+    using IoCompletion = std::function<void(int64_t)>;
+
+    class IoRing
+    /*++
+      Asynchronous file I/O for a single dispatcher, backed
+      by an io_uring driven through raw syscalls. Requests
+      are queued on the submission ring while tasks run and
+      flushed with one io_uring_enter per loop iteration;
+      completions are reaped from the completion ring in
+      batches by the dispatch loop and run as jobs on the
+      dispatcher, like expired delayed tasks.
+
+      Where io_uring is not available, e.g. not on Linux or
+      blocked by seccomp, each request is carried out
+      synchronously when it is queued and its completion is
+      still delivered as a job.
+
+      Owner thread only, except Wake()
+    --*/
+    {
+    public:
+        static constexpr unsigned ENTRIES = 256;
+
+        IoRing(void* Dispatcher);
+        IoRing(const IoRing& Other) = delete;
+        IoRing& operator=(const IoRing& Other) = delete;
+        ~IoRing(void);
+        void Read(const int Fd, void* Buffer, const size_t Length, const uint64_t Offset, IoCompletion Completion);
+        void Write(const int Fd, const void* Buffer, const size_t Length, const uint64_t Offset, IoCompletion Completion);
+        void Fsync(const int Fd, IoCompletion Completion);
+        bool Submit(void);
+        size_t Reap(RunQueue& Queue);
+        bool Ready(void);
+        void Wait(const timepoint Deadline);
+        void Wake(void);
+        bool Available(void) const { return m_Fd != -1; };
+        bool Busy(void) const { return m_InFlight != 0 || !m_Completed.empty(); };
+        size_t InFlight(void) const { return m_InFlight; };
+        int GetFd(void) const { return m_Fd; };
+    private:
+        struct Request
+        {
+            IoCompletion m_Completion;
+            int64_t m_Result;
+            Request* m_Next;
+        };
+
+        Request* NewRequest(IoCompletion&& Completion);
+        void FreeRequest(Request* ToFree);
+        void Queue(const uint8_t Opcode, const int Fd, const void* Buffer, const size_t Length, const uint64_t Offset, IoCompletion&& Completion);
+        void Complete(Request* Completed, const int64_t Result);
+
+        void* m_Dispatcher;
+        int m_Fd = -1;
+        int m_WakeEvent = -1;
+        void* m_SqRing = nullptr;
+        size_t m_SqRingSize = 0;
+        void* m_CqRing = nullptr;
+        size_t m_CqRingSize = 0;
+        void* m_Sqes = nullptr;
+        size_t m_SqesSize = 0;
+        unsigned* m_SqHead = nullptr;
+        unsigned* m_SqTail = nullptr;
+        unsigned* m_SqArray = nullptr;
+        unsigned m_SqMask = 0;
+        unsigned m_SqEntries = 0;
+        unsigned* m_CqHead = nullptr;
+        unsigned* m_CqTail = nullptr;
+        unsigned m_CqMask = 0;
+        void* m_Cqes = nullptr;
+        unsigned m_Unsubmitted = 0;
+        size_t m_InFlight = 0;
+        Request* m_FreeRequests = nullptr;
+        std::vector<std::unique_ptr<Request>> m_Requests;
+        std::vector<Request*> m_Completed;
+    };
+
+}
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <stdint.h>
 #include <string.h>
 
 #include <chrono>
+#include <memory>
 
 #include "Callable.hpp"
 
@@ -18,39 +20,58 @@ namespace dispatch
 
     using timepoint = std::chrono::time_point<std::chrono::system_clock>;
 
+    extern const dispatch::timepoint MAXTIME;
+
+    class Job;
+    class JobAllocator;
+    struct JobNode;
+
+    struct JobNodeDeleter
+    {
+        void operator()(JobNode* Node) const;
+    };
+
+    using JobNodePtr = std::unique_ptr<JobNode, JobNodeDeleter>;
+
+    JobNode* AllocateJobNode(Job&& ToWrap);
+
     class Job
     {
     public:
-        Job(Callable Entrypoint, const TaskPriority Priority, void* Dispatcher) :
-            m_Entrypoint(Entrypoint),
+        Job(UniqueCallable Entrypoint, const TaskPriority Priority, void* Dispatcher) :
+            m_Entrypoint(std::move(Entrypoint)),
             m_Priority(Priority),
             m_Dispatcher(Dispatcher) {};
-        Job(Callable Entrypoint, void* Dispatcher, const timepoint Timepoint) :
-            m_Entrypoint(Entrypoint),
+        Job(UniqueCallable Entrypoint, void* Dispatcher, const timepoint Timepoint) :
+            m_Entrypoint(std::move(Entrypoint)),
             m_Priority(TaskPriority::PRIORITY_NORMAL),
             m_Dispatcher(Dispatcher),
             m_Delayed(true),
             m_DispatchTime(Timepoint) {};
-        Job(Callable Entrypoint, const TaskPriority Priority, void* Dispatcher, Job& Reply) :
-            m_Entrypoint(Entrypoint),
+        Job(UniqueCallable Entrypoint, const TaskPriority Priority, void* Dispatcher, Job& Reply) :
+            m_Entrypoint(std::move(Entrypoint)),
             m_Priority(Priority),
-            m_Dispatcher(Dispatcher) { m_Reply = std::make_unique<Job>(std::move(Reply)); };
+            m_Dispatcher(Dispatcher) { m_Reply = JobNodePtr(AllocateJobNode(std::move(Reply))); };
         Job(Job& Other) = delete;
         Job(Job&& Other) :
             m_Entrypoint(std::move(Other.m_Entrypoint)),
             m_Priority(Other.m_Priority),
             m_Dispatcher(Other.m_Dispatcher),
             m_Delayed(Other.m_Delayed),
+            m_Routed(Other.m_Routed),
             m_DispatchTime(Other.m_DispatchTime),
-            m_Reply(std::move(Other.m_Reply)) { Other.m_Dispatcher = nullptr; };
+            m_Reply(std::move(Other.m_Reply)),
+            m_TraceId(Other.m_TraceId) { Other.m_Dispatcher = nullptr; };
         Job& operator=(Job&& Other)
         {
             m_Entrypoint = std::move(Other.m_Entrypoint);
             m_Priority = Other.m_Priority;
             m_Dispatcher = Other.m_Dispatcher;
             m_Delayed = Other.m_Delayed;
+            m_Routed = Other.m_Routed;
             m_DispatchTime = Other.m_DispatchTime;
             m_Reply = std::move(Other.m_Reply);
+            m_TraceId = Other.m_TraceId;
             Other.m_Dispatcher = nullptr;
             return *this;
         };
@@ -60,17 +81,56 @@ namespace dispatch
         const bool IsDelayed(void) const { return m_Delayed; };
         const timepoint GetDispatchTime(void) const { return m_DispatchTime; };
         const bool ShouldRunNow(void) const { return !m_Delayed || std::chrono::system_clock::now() >= m_DispatchTime; };
+        //
+        // An immediate job has no dispatch time, so the slot
+        // holds when it was posted if metrics sampled it
+        //
+        void SetPostTime(const timepoint Time) { m_DispatchTime = Time; };
+        const bool HasReadyTime(void) const { return m_DispatchTime != timepoint(); };
+        const timepoint GetReadyTime(void) const { return m_DispatchTime; };
+        //
+        // Set when a pool's router counted the job as
+        // pending on the worker it picked
+        //
+        const bool IsRouted(void) const { return m_Routed; };
+        void SetRouted(const bool Routed) { m_Routed = Routed; };
+        //
+        // Zero unless the job was posted while tracing
+        //
+        uint64_t GetTraceId(void) const { return m_TraceId; };
+        void SetTraceId(const uint64_t TraceId) { m_TraceId = TraceId; };
         void operator()(void) { m_Entrypoint(); };
         bool operator<(const Job& Rhs) const { return m_Priority < Rhs.GetPriority(); };
         bool HasReply(void) const { return m_Reply != nullptr; };
-        std::unique_ptr<Job> GetReply(void) { return std::move(m_Reply); };
+        JobNodePtr GetReply(void) { return std::move(m_Reply); };
+        JobNode* PeekReply(void) const { return m_Reply.get(); };
+        template <typename T>
+        T* Target(void) { return m_Entrypoint.template target<T>(); };
     protected:
-        Callable m_Entrypoint;
+        UniqueCallable m_Entrypoint;
         TaskPriority m_Priority;
         void* m_Dispatcher = nullptr;
         bool m_Delayed = false;
+        bool m_Routed = false;
         timepoint m_DispatchTime;
-        std::unique_ptr<Job> m_Reply;
+        JobNodePtr m_Reply;
+        uint64_t m_TraceId = 0;
+    };
+
+    struct alignas(64) JobNode
+    /*++
+      A Job linked into an intrusive queue. Nodes come from
+      the posting dispatcher's JobAllocator, or the heap
+      when m_Allocator is nullptr. Always allocate with
+      AllocateJobNode and free through JobNodeDeleter
+    --*/
+    {
+        JobNode(Job&& ToWrap, JobAllocator* Allocator = nullptr) :
+            m_Job(std::move(ToWrap)),
+            m_Allocator(Allocator) {};
+        Job m_Job;
+        JobNode* m_Next = nullptr;
+        JobAllocator* const m_Allocator;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+#include "Job.hpp"
+
+namespace dispatch
+{
+
+    struct JobAllocatorStatistics
+    {
+        size_t m_Hits;
+        size_t m_Misses;
+        size_t m_RemoteFrees;
+        size_t m_Nodes;
+    };
+
+    //
+    // Slot size of the allocator each dispatcher keeps for
+    // coroutine frames, see AllocateFrame
+    //
+    constexpr size_t FRAME_SLOT_SIZE = 512;
+
+    void* AllocateFrame(const size_t Size);
+    void FreeFrame(void* Frame);
+
+    class JobAllocator
+    /*++
+      Slab allocator for JobNodes, owned by a dispatcher.
+      Slots are JobNode sized by default; an allocator with
+      larger slots hands out raw memory, e.g. for coroutine
+      frames.
+
+      Only the dispatcher's own thread allocates, taking
+      nodes from a non-atomic local free list. A node freed
+      on the owning thread goes straight back onto that list.
+      A node freed on any other thread, e.g. a job consumed
+      by a different dispatcher, is pushed onto a lock-free
+      remote list which the owner reclaims in one exchange
+      when its local list runs dry.
+
+      When the owning dispatcher is destroyed the allocator
+      is orphaned rather than deleted, and it frees itself
+      once the last outstanding node has been returned.
+    --*/
+    {
+    public:
+        static constexpr size_t SLAB_NODES = 64;
+
+        JobAllocator(const void* Owner, const size_t SlotSize = sizeof(JobNode));
+        JobAllocator(const JobAllocator& Other) = delete;
+        JobAllocator& operator=(const JobAllocator& Other) = delete;
+        JobNode* Allocate(Job&& ToWrap);
+        void* AllocateRaw(void);
+        void Release(void);
+        JobAllocatorStatistics GetStatistics(void) const;
+        size_t GetSlotSize(void) const { return m_SlotSize; };
+        static JobAllocator* Current(void);
+        static void Free(JobNode* Node);
+        static void FreeRaw(void* Memory, JobAllocator* Owner);
+    private:
+        struct FreeNode
+        {
+            FreeNode* m_Next;
+        };
+
+        ~JobAllocator(void);
+        void FreeLocal(void* Memory);
+        void FreeRemote(void* Memory);
+        void AllocateSlab(void);
+        void Bump(std::atomic<size_t>& Counter) { Counter.store(Counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); };
+
+        bool OnOwnerThread(void) const;
+
+        const void* const m_Owner;
+        const size_t m_SlotSize;
+        FreeNode* m_LocalFree = nullptr;
+        std::vector<void*> m_Slabs;
+        std::atomic<size_t> m_Hits = 0;
+        std::atomic<size_t> m_Misses = 0;
+        std::atomic<size_t> m_RemoteFrees = 0;
+        std::atomic<size_t> m_Nodes = 0;
+        alignas(64) std::atomic<FreeNode*> m_RemoteFree = nullptr;
+        std::atomic<int64_t> m_Outstanding = 0;
+    };
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <type_traits>
+
+#include "Job.hpp"
+#include "RunQueue.hpp"
+
+//
+// Build with DISPATCH_NO_METRICS defined to compile all
+// of the collection below out of the dispatch loop
+//
+
+namespace dispatch
+{
+
+    //
+    // One in this many tasks has its queue wait and run
+    // time recorded, keeping clock reads off most tasks
+    //
+    constexpr uint32_t METRICS_SAMPLE_INTERVAL = 16;
+
+    class LatencyHistogram
+    /*++
+      Log-linear buckets of nanoseconds: exact below 16,
+      then eight buckets per power of two, so any value is
+      within 12.5% of its bucket's bounds
+    --*/
+    {
+    public:
+        static constexpr size_t LINEAR = 16;
+        static constexpr size_t SUB_BITS = 3;
+        static constexpr size_t SUB_BUCKETS = 1 << SUB_BITS;
+        static constexpr size_t MAX_EXPONENT = 36;
+        static constexpr size_t BUCKETS = LINEAR + (MAX_EXPONENT - 3) * SUB_BUCKETS;
+
+        static size_t Bucket(const uint64_t Nanoseconds);
+        static uint64_t LowerBound(const size_t Bucket);
+        void Merge(const LatencyHistogram& Other);
+        uint64_t Count(void) const;
+        uint64_t Percentile(const double Fraction) const;
+
+        uint64_t m_Counts[BUCKETS] = {};
+    };
+
+    class AtomicHistogram
+    /*++
+      A LatencyHistogram recorded into by one thread and
+      read from any
+    --*/
+    {
+    public:
+        void
+        Record(
+            const uint64_t Nanoseconds
+        )
+        {
+            auto& bucket = m_Counts[LatencyHistogram::Bucket(Nanoseconds)];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        LatencyHistogram Snapshot(void) const;
+    private:
+        std::atomic<uint64_t> m_Counts[LatencyHistogram::BUCKETS] = {};
+    };
+
+    struct DispatcherMetrics
+    {
+        std::string m_Name;
+        //
+        // How many dispatchers were added together, the
+        // workers of a pool
+        //
+        size_t m_Dispatchers = 1;
+        uint64_t m_Posted = 0;
+        uint64_t m_Run = 0;
+        uint64_t m_CrossThread = 0;
+        //
+        // Per TaskPriority lane, highest priority first. An
+        // aggregate takes the deepest worker's high water
+        //
+        uint64_t m_Depth[PRIORITY_LEVELS] = {};
+        uint64_t m_HighWater[PRIORITY_LEVELS] = {};
+        uint64_t m_Delayed = 0;
+        //
+        // Posted to a pool and not yet taken by a worker
+        //
+        uint64_t m_Unclaimed = 0;
+        std::chrono::nanoseconds m_IdleTime = std::chrono::nanoseconds(0);
+        std::chrono::nanoseconds m_BusyTime = std::chrono::nanoseconds(0);
+        //
+        // Sampled, see METRICS_SAMPLE_INTERVAL
+        //
+        LatencyHistogram m_QueueWait;
+        LatencyHistogram m_RunTime;
+
+        void Merge(const DispatcherMetrics& Other);
+    };
+
+    class MetricsBlock
+    /*++
+      The live counters of one dispatcher. Only its own
+      thread writes them, so plain loads and stores of
+      relaxed atomics are enough and nothing contends
+    --*/
+    {
+    public:
+        void Posted(const uint64_t Count = 1) { Add(m_Posted, Count); };
+        void CrossThread(const uint64_t Count = 1) { Add(m_CrossThread, Count); };
+        void Ran(void) { Add(m_Run, 1); };
+        void Started(void);
+        void Stopped(void);
+        void Idled(const int64_t Nanoseconds) { Add(m_Idle, Nanoseconds); };
+        void Handled(const uint64_t Count, const int64_t Nanoseconds);
+        int64_t HandlerTime(void) const { return m_HandlerTime; };
+        void RecordQueueWait(const uint64_t Nanoseconds) { m_QueueWait.Record(Nanoseconds); };
+        void RecordRunTime(const uint64_t Nanoseconds) { m_RunTime.Record(Nanoseconds); };
+        void Fill(DispatcherMetrics& Metrics) const;
+
+        static int64_t
+        Now(
+            void
+        )
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+    private:
+        template <typename T>
+        static void
+        Add(
+            std::atomic<T>& Counter,
+            const std::type_identity_t<T> Count
+        )
+        {
+            Counter.store(Counter.load(std::memory_order_relaxed) + Count, std::memory_order_relaxed);
+        }
+
+        std::atomic<uint64_t> m_Posted = 0;
+        std::atomic<uint64_t> m_CrossThread = 0;
+        std::atomic<uint64_t> m_Run = 0;
+        //
+        // The start of the current run, 0 between runs. A
+        // pool worker may run many times, so the length of
+        // each finished run is added into m_Elapsed
+        //
+        std::atomic<int64_t> m_Started = 0;
+        std::atomic<int64_t> m_Elapsed = 0;
+        std::atomic<int64_t> m_Idle = 0;
+        //
+        // Time spent in handlers, which may run while the
+        // loop is idle. Only read by the owner
+        //
+        int64_t m_HandlerTime = 0;
+        AtomicHistogram m_QueueWait;
+        AtomicHistogram m_RunTime;
+    };
+
+    inline void
+    SamplePostTime(
+        Job& ToPost
+    )
+    /*++
+      Stamp one in METRICS_SAMPLE_INTERVAL posts from this
+      thread with the time, for the queue wait histogram
+    --*/
+    {
+#ifndef DISPATCH_NO_METRICS
+        thread_local uint32_t posts = 0;
+        if ((++posts & (METRICS_SAMPLE_INTERVAL - 1)) == 0 && !ToPost.IsDelayed())
+        {
+            ToPost.SetPostTime(std::chrono::system_clock::now());
+        }
+#endif
+    }
+
+}
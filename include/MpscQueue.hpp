@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+
+namespace dispatch
+{
+
+    template <typename Node>
+    class MpscQueue
+    /*++
+      Intrusive lock-free multi-producer single-consumer
+      queue. Node must expose a Node* m_Next member which
+      is owned by the queue while the node is enqueued.
+
+      Producers push with a single CAS onto a LIFO stack.
+      The consumer takes the whole stack in one exchange
+      and reverses it, so nodes come out in FIFO order
+      per producer.
+    --*/
+    {
+    public:
+        MpscQueue(void) = default;
+        MpscQueue(const MpscQueue& Other) = delete;
+        MpscQueue& operator=(const MpscQueue& Other) = delete;
+
+        bool
+        Push(
+            Node* ToPush
+        )
+        /*++
+          Push a single node. Returns true if the queue
+          was empty, meaning the consumer may need waking
+        --*/
+        {
+            return PushChain(ToPush, ToPush);
+        }
+
+        bool
+        PushChain(
+            Node* First,
+            Node* Last
+        )
+        /*++
+          Push a chain of nodes, linked First to Last via
+          m_Next, with a single CAS. The chain is consumed
+          in the order First to Last.
+          Returns true if the queue was empty
+        --*/
+        {
+            //
+            // The stack is LIFO so the chain is stored reversed,
+            // Drain undoes this. Reverse First..Last in place
+            // so that Last becomes the new head
+            //
+            Node* previous = nullptr;
+            Node* current = First;
+            while (previous != Last)
+            {
+                Node* next = current->m_Next;
+                current->m_Next = previous;
+                previous = current;
+                current = next;
+            }
+
+            Node* head = m_Head.load(std::memory_order_relaxed);
+            do
+            {
+                First->m_Next = head;
+            }
+            while (!m_Head.compare_exchange_weak(
+                head,
+                Last,
+                std::memory_order_release,
+                std::memory_order_relaxed
+            ));
+            return head == nullptr;
+        }
+
+        Node*
+        Drain(
+            void
+        )
+        /*++
+          Take every node currently enqueued, returning them
+          as a FIFO linked list. Must only be called by the
+          consumer
+        --*/
+        {
+            Node* head = m_Head.exchange(nullptr, std::memory_order_acquire);
+            Node* ordered = nullptr;
+            while (head != nullptr)
+            {
+                Node* next = head->m_Next;
+                head->m_Next = ordered;
+                ordered = head;
+                head = next;
+            }
+            return ordered;
+        }
+
+        bool Empty(void) const { return m_Head.load(std::memory_order_relaxed) == nullptr; };
+
+    private:
+        alignas(64) std::atomic<Node*> m_Head = nullptr;
+    };
+
+}
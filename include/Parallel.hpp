@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <iterator>
+#include <mutex>
+#include <utility>
+
+#include "DispatchPool.hpp"
+
+namespace dispatch
+{
+
+    struct RangeFunction
+    /*++
+      A non-owning reference to a void(size_t, size_t)
+      callable, called with the bounds of each chunk
+    --*/
+    {
+        void* m_Context;
+        void (*m_Invoke)(void* Context, size_t Begin, size_t End);
+
+        template <typename Fn>
+        static RangeFunction
+        From(
+            Fn& Function
+        )
+        {
+            return RangeFunction{
+                (void*)&Function,
+                [](void* Context, size_t Begin, size_t End){ (*(Fn*)Context)(Begin, End); }
+            };
+        }
+
+        void operator()(size_t Begin, size_t End) const { m_Invoke(m_Context, Begin, End); };
+    };
+
+    void ParallelForRanges(DispatchPool* Pool, const size_t Begin, const size_t End, const size_t Grain, RangeFunction Body);
+
+    template <typename Fn>
+    void
+    ParallelFor(
+        DispatchPool* Pool,
+        const size_t Begin,
+        const size_t End,
+        const size_t Grain,
+        Fn&& Body
+    )
+    /*++
+      Call Body(i) for every i in [Begin, End) across Pool
+      and the calling thread, returning once all are done.
+      The range is split in halves until chunks are at most
+      Grain long. A Grain of 0 picks one from the range and
+      pool size
+    --*/
+    {
+        auto chunk = [&Body](size_t ChunkBegin, size_t ChunkEnd) {
+            for (size_t i = ChunkBegin; i < ChunkEnd; i++)
+            {
+                Body(i);
+            }
+        };
+        ParallelForRanges(Pool, Begin, End, Grain, RangeFunction::From(chunk));
+    }
+
+    template <typename T, typename Map, typename Combine>
+    T
+    ParallelReduce(
+        DispatchPool* Pool,
+        const size_t Begin,
+        const size_t End,
+        const size_t Grain,
+        T Identity,
+        Map&& Mapper,
+        Combine&& Combiner
+    )
+    /*++
+      Combine Mapper(i) for every i in [Begin, End),
+      starting from Identity. Chunks are reduced in any
+      order, so Combiner must be associative and
+      commutative
+    --*/
+    {
+        std::mutex lock;
+        T result = Identity;
+        auto chunk = [&](size_t ChunkBegin, size_t ChunkEnd) {
+            T partial = Identity;
+            for (size_t i = ChunkBegin; i < ChunkEnd; i++)
+            {
+                partial = Combiner(std::move(partial), Mapper(i));
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            result = Combiner(std::move(result), std::move(partial));
+        };
+        ParallelForRanges(Pool, Begin, End, Grain, RangeFunction::From(chunk));
+        return result;
+    }
+
+    template <typename InputIt, typename OutputIt, typename Fn>
+    OutputIt
+    ParallelTransform(
+        DispatchPool* Pool,
+        InputIt First,
+        InputIt Last,
+        OutputIt Output,
+        const size_t Grain,
+        Fn&& Transform
+    )
+    /*++
+      Write Transform(*i) for each i in [First, Last) to
+      the same position from Output. Both must be random
+      access iterators
+    --*/
+    {
+        auto count = (size_t)std::distance(First, Last);
+        auto chunk = [&](size_t ChunkBegin, size_t ChunkEnd) {
+            auto input = First + ChunkBegin;
+            auto output = Output + ChunkBegin;
+            for (size_t i = ChunkBegin; i < ChunkEnd; i++)
+            {
+                *output++ = Transform(*input++);
+            }
+        };
+        ParallelForRanges(Pool, 0, count, Grain, RangeFunction::From(chunk));
+        return Output + count;
+    }
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#ifdef __linux__
+
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+#include "DispatcherBase.hpp"
+
+namespace dispatch
+{
+
+    //
+    // Called on the owning dispatcher with the watched
+    // descriptor and the EPOLL* events that are ready
+    //
+    using FdHandler = std::function<void(int, uint32_t)>;
+
+    class ReactorDispatcher : public Dispatcher
+    /*++
+      A Dispatcher that parks in epoll_wait instead of on a
+      condition variable, so it can also wait on file
+      descriptors. Cross-thread posts wake it through an
+      eventfd and delayed tasks through a timerfd. Handlers
+      registered with WatchFd run inline on the dispatcher
+      thread, so no extra hop through another thread is
+      needed per event.
+      Watches are level-triggered unless EPOLLET is given
+    --*/
+    {
+    public:
+        static constexpr size_t MAX_EVENTS = 64;
+
+        ReactorDispatcher(const std::string& Name);
+        ~ReactorDispatcher(void);
+        bool WatchFd(const int Fd, const uint32_t Events, FdHandler Handler);
+        void UnwatchFd(const int Fd);
+        size_t Watched(void) { return m_Watchers.size(); };
+    protected:
+        void Block(void) override;
+        void Notify(void) override;
+        bool PollEvents(void) override;
+    private:
+        struct Watcher
+        {
+            uint32_t m_Generation;
+            FdHandler m_Handler;
+        };
+
+        bool WatchFdInternal(const int Fd, const uint32_t Events, FdHandler Handler);
+        void UnwatchFdInternal(const int Fd);
+        size_t Poll(const int Timeout);
+        void ArmTimer(void);
+
+        int m_Epoll = -1;
+        int m_WakeEvent = -1;
+        int m_Timer = -1;
+        dispatch::timepoint m_TimerDeadline = dispatch::MAXTIME;
+        bool m_RingWatched = false;
+        uint32_t m_Generation = 0;
+        std::unordered_map<int, Watcher> m_Watchers;
+    };
+
+    using ReactorDispatcherPtr = std::shared_ptr<ReactorDispatcher>;
+
+}
+
+#endif
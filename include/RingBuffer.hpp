@@ -0,0 +1,140 @@
+#pragma once
+
+#include <assert.h>
+
+#include <memory>
+#include <utility>
+
+namespace dispatch
+{
+
+    template <typename T>
+    class RingBuffer
+    /*++
+      A growable circular buffer supporting O(1) push
+      at either end and O(1) pop from the front.
+      Storage is only ever grown, never shrunk, so a
+      buffer that has reached its working size stops
+      allocating entirely.
+    --*/
+    {
+    public:
+        RingBuffer(void) = default;
+        RingBuffer(const RingBuffer& Other) = delete;
+        RingBuffer& operator=(const RingBuffer& Other) = delete;
+
+        ~RingBuffer(
+            void
+        )
+        {
+            Clear();
+            if (m_Buffer != nullptr)
+            {
+                std::allocator<T>().deallocate(m_Buffer, m_Capacity);
+            }
+        }
+
+        void
+        PushBack(
+            T&& Value
+        )
+        {
+            if (m_Size == m_Capacity)
+            {
+                Grow();
+            }
+            std::construct_at(Slot(m_Size), std::move(Value));
+            m_Size++;
+        }
+
+        void
+        PushFront(
+            T&& Value
+        )
+        {
+            if (m_Size == m_Capacity)
+            {
+                Grow();
+            }
+            m_Head = (m_Head - 1) & (m_Capacity - 1);
+            std::construct_at(&m_Buffer[m_Head], std::move(Value));
+            m_Size++;
+        }
+
+        T
+        PopFront(
+            void
+        )
+        {
+            assert(m_Size > 0);
+            T* front = &m_Buffer[m_Head];
+            T value(std::move(*front));
+            std::destroy_at(front);
+            m_Head = (m_Head + 1) & (m_Capacity - 1);
+            m_Size--;
+            return value;
+        }
+
+        T&
+        Front(
+            void
+        )
+        {
+            assert(m_Size > 0);
+            return m_Buffer[m_Head];
+        }
+
+        void
+        Clear(
+            void
+        )
+        {
+            for (size_t i = 0; i < m_Size; i++)
+            {
+                std::destroy_at(Slot(i));
+            }
+            m_Head = 0;
+            m_Size = 0;
+        }
+
+        size_t Size(void) const { return m_Size; };
+        bool Empty(void) const { return m_Size == 0; };
+        size_t Capacity(void) const { return m_Capacity; };
+
+    private:
+        T* Slot(const size_t Index) { return &m_Buffer[(m_Head + Index) & (m_Capacity - 1)]; };
+
+        void
+        Grow(
+            void
+        )
+        /*++
+          Double the capacity (which is always a power of two)
+          and move the live elements to the start of the new
+          allocation, preserving their order
+        --*/
+        {
+            size_t capacity = m_Capacity == 0 ? 16 : m_Capacity * 2;
+            T* buffer = std::allocator<T>().allocate(capacity);
+            for (size_t i = 0; i < m_Size; i++)
+            {
+                T* slot = Slot(i);
+                std::construct_at(&buffer[i], std::move(*slot));
+                std::destroy_at(slot);
+            }
+            if (m_Buffer != nullptr)
+            {
+                std::allocator<T>().deallocate(m_Buffer, m_Capacity);
+            }
+            m_Buffer = buffer;
+            m_Capacity = capacity;
+            m_Head = 0;
+        }
+
+        T* m_Buffer = nullptr;
+        size_t m_Capacity = 0;
+        size_t m_Head = 0;
+        size_t m_Size = 0;
+    };
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+
+#include "Job.hpp"
+#include "RingBuffer.hpp"
+
+namespace dispatch
+{
+
+    constexpr size_t PRIORITY_LEVELS = 3;
+
+    class RunQueue
+    /*++
+      The native run queue of a dispatcher. Jobs are
+      held in one FIFO lane per TaskPriority so that
+      posting and popping are O(1) and jobs of equal
+      priority always run in the order they were posted.
+      Only ever modified from the dispatcher's own thread,
+      the sizes may be read from anywhere.
+    --*/
+    {
+    public:
+        RunQueue(void) = default;
+        RunQueue(const RunQueue& Other) = delete;
+        RunQueue& operator=(const RunQueue& Other) = delete;
+        void Push(Job&& ToPush);
+        void PushFront(Job&& ToPush);
+        Job Pop(void);
+        void Clear(void);
+        size_t Size(void) const { return m_Size.load(std::memory_order_relaxed); };
+        bool Empty(void) const { return Size() == 0; };
+#ifndef DISPATCH_NO_METRICS
+        size_t Depth(const size_t Lane) const { return m_Depth[Lane].load(std::memory_order_relaxed); };
+        size_t HighWater(const size_t Lane) const { return m_HighWater[Lane].load(std::memory_order_relaxed); };
+#endif
+    private:
+        static size_t Lane(const TaskPriority Priority);
+        void Grew(const size_t Lane);
+        void Shrank(const size_t Lane);
+        RingBuffer<Job> m_Lanes[PRIORITY_LEVELS];
+        std::atomic<size_t> m_Size = 0;
+#ifndef DISPATCH_NO_METRICS
+        std::atomic<size_t> m_Depth[PRIORITY_LEVELS] = {};
+        std::atomic<size_t> m_HighWater[PRIORITY_LEVELS] = {};
+#endif
+    };
+
+}
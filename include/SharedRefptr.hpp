@@ -1,47 +1,348 @@
 #pragma once
 
 #include <assert.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <utility>
 
 namespace dispatch
 {
-    template <typename T, bool Bound=false>
+    enum class RefCounting
+    {
+        //
+        // Plain counts, for pointers that stay on one thread
+        //
+        LOCAL,
+        //
+        // Plain counts, asserting every use is on the
+        // dispatcher that made the pointer
+        //
+        BOUND,
+        //
+        // Plain counts on the dispatcher that made the
+        // pointer, atomic counts everywhere else
+        //
+        BIASED
+    };
+
+    template <typename T, RefCounting Mode=RefCounting::LOCAL>
     class SharedRefPtr;
 
+    template <typename T, RefCounting Mode, typename Alloc, class... Args>
+    SharedRefPtr<T,Mode> _AllocateRefPtr(const Alloc& Allocator, Args&&... x);
+
     class DispatcherBase;
     extern thread_local DispatcherBase* ThreadQueue;
-
-    template <typename T, bool Bound>
+    //
+    // The dispatcher whose dropped deletes this thread is
+    // running, see DeleteSoon.cpp
+    //
+    extern thread_local DispatcherBase* DroppedQueue;
+
+    //
+    // Runs Function(Context) on Dispatcher, from
+    // DispatcherBase.cpp so this header stays standalone
+    //
+    void _PostToOwner(void* Dispatcher, void (*Function)(void*), void* Context);
+    void PostDeleteSoon(DispatcherBase* Dispatcher, void (*Delete)(void*), void* Object);
+
+    template <typename T, RefCounting Mode>
     class _ObjectManager
+    /*++
+      The count behind a SharedRefPtr.
+
+      In BIASED mode m_Refs is the owner's count, only ever
+      touched on the dispatcher that made the pointer, and
+      every other thread counts in m_Shared. The two are
+      merged once the owner lets go of its last reference,
+      or on the owner's request when another thread drops
+      a reference the owner handed it, which would take the
+      shared count below zero. After the merge everything
+      is counted in m_Shared and it frees at zero.
+
+      In BOUND mode a reference dropped off the bound
+      dispatcher is sent back to it with DeleteSoon, so
+      the count is only ever touched there and the object
+      is always destroyed there
+    --*/
     {
     protected:
-        _ObjectManager(T * const Allocation) :
+        using Destroyer = void (*)(_ObjectManager*);
+        static constexpr bool Bound = Mode == RefCounting::BOUND;
+        static constexpr bool Biased = Mode == RefCounting::BIASED;
+
+        //
+        // m_Shared holds a count in its upper bits above
+        // MERGED, set once the owner's count has been
+        // folded in, and QUEUED, set while a merge has been
+        // asked of the owner
+        //
+        static constexpr int64_t MERGED = 1;
+        static constexpr int64_t QUEUED = 2;
+        static constexpr int64_t SHARED_ONE = 4;
+
+        _ObjectManager(T * const Allocation, const Destroyer Destroy = &DeleteSeparate) :
             m_Allocation(Allocation),
-            m_BoundDispatcher((void*)ThreadQueue)
+            m_BoundDispatcher((void*)ThreadQueue),
+            m_Destroy(Destroy)
         {
             if(Bound)
             {
                 assert(ThreadQueue != nullptr);
             }
+            if (Biased && m_BoundDispatcher == nullptr)
+            {
+                //
+                // Made off any dispatcher, so there is no owner
+                // and it is shared from the start
+                //
+                m_Merged = true;
+                m_Shared.store(MERGED, std::memory_order_relaxed);
+            }
         };
 
         ~_ObjectManager(void)
         {
-            assert(!Bound || m_BoundDispatcher == ThreadQueue);
+            assert(!Bound || OnBound());
             assert(m_Refs == 0);
-            delete m_Allocation;
         }
-        inline T* const get(void) const { assert(!Bound || m_BoundDispatcher == ThreadQueue); return m_Allocation; };
-        inline void ref(void) { assert(!Bound || m_BoundDispatcher == ThreadQueue); ++m_Refs; };
-        inline const size_t deref(void) { assert(!Bound || m_BoundDispatcher == ThreadQueue); return --m_Refs; };
-        inline const size_t refs(void) const { assert(!Bound || m_BoundDispatcher == ThreadQueue); return m_Refs; };
-        friend class SharedRefPtr<T,Bound>;
+
+        inline T* const get(void) const { assert(!Bound || OnBound()); return m_Allocation; };
+
+        inline void
+        ref(
+            void
+        )
+        {
+            assert(!Bound || OnBound());
+            if (!Biased || OnOwner())
+            {
+                ++m_Refs;
+            }
+            else
+            {
+                m_Shared.fetch_add(SHARED_ONE, std::memory_order_relaxed);
+            }
+        }
+
+        inline bool
+        unref(
+            void
+        )
+        /*++
+          Drop a reference. True if it was the last one and
+          the object should be destroyed
+        --*/
+        {
+            if (Bound && !OnBound())
+            {
+                PostDeleteSoon((DispatcherBase*)m_BoundDispatcher, &Release, this);
+                return false;
+            }
+            if (!Biased)
+            {
+                return --m_Refs == 0;
+            }
+            if (OnOwner())
+            {
+                if (--m_Refs != 0)
+                {
+                    return false;
+                }
+                m_Merged = true;
+                return (m_Shared.fetch_or(MERGED, std::memory_order_acq_rel) >> 2) == 0;
+            }
+            return UnrefShared();
+        }
+
+        inline const size_t
+        refs(
+            void
+        ) const
+        {
+            assert(!Bound || OnBound());
+            if (!Biased)
+            {
+                return m_Refs;
+            }
+            auto shared = m_Shared.load(std::memory_order_acquire) >> 2;
+            return (OnOwner() ? m_Refs : 0) + (size_t)shared;
+        }
+
+        inline void destroy(void) { m_Destroy(this); };
+
+        static void
+        Release(
+            void* Context
+        )
+        /*++
+          Drop a reference that was handed over to be
+          released here
+        --*/
+        {
+            auto self = static_cast<_ObjectManager*>(Context);
+            if (self->unref())
+            {
+                self->destroy();
+            }
+        }
+
+        friend class SharedRefPtr<T,Mode>;
     private:
+        inline bool
+        OnBound(
+            void
+        ) const
+        /*++
+          Whether a BOUND count may be touched here: on its
+          dispatcher, or running the deletes it dropped as
+          it went away
+        --*/
+        {
+            return m_BoundDispatcher == (void*)ThreadQueue || m_BoundDispatcher == (void*)DroppedQueue;
+        }
+
+        inline bool
+        OnOwner(
+            void
+        ) const
+        /*++
+          Only the owner reads m_Merged, so compare the
+          dispatcher first
+        --*/
+        {
+            return m_BoundDispatcher == (void*)ThreadQueue && !m_Merged;
+        }
+
+        bool
+        UnrefShared(
+            void
+        )
+        {
+            auto state = m_Shared.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                if ((state & (MERGED | QUEUED)) == 0 && (state >> 2) <= 0)
+                {
+                    //
+                    // This reference was counted by the owner.
+                    // Rather than go negative, hand it to a merge
+                    // on the owner, which releases it after
+                    //
+                    if (m_Shared.compare_exchange_weak(state, state | QUEUED, std::memory_order_relaxed))
+                    {
+                        _PostToOwner(m_BoundDispatcher, &Merge, this);
+                        return false;
+                    }
+                    continue;
+                }
+                if (m_Shared.compare_exchange_weak(state, state - SHARED_ONE, std::memory_order_acq_rel))
+                {
+                    return (state & MERGED) != 0 && (state >> 2) == 1;
+                }
+            }
+        }
+
+        static void
+        Merge(
+            void* Context
+        )
+        /*++
+          On the owner: fold the owner's count into the shared
+          one, then drop the reference the request carried
+        --*/
+        {
+            auto self = static_cast<_ObjectManager*>(Context);
+            if (!self->m_Merged)
+            {
+                self->m_Merged = true;
+                self->m_Shared.fetch_add((int64_t)self->m_Refs * SHARED_ONE | MERGED, std::memory_order_acq_rel);
+                self->m_Refs = 0;
+            }
+            if (self->UnrefShared())
+            {
+                self->destroy();
+            }
+        }
+
+        static void
+        DeleteSeparate(
+            _ObjectManager* Manager
+        )
+        /*++
+          Teardown for an object that was handed to us as a
+          raw pointer and lives in its own allocation
+        --*/
+        {
+            delete Manager->m_Allocation;
+            delete Manager;
+        }
+
         T* const m_Allocation = nullptr;
         size_t m_Refs = 0;
         void* m_BoundDispatcher = nullptr;
+        const Destroyer m_Destroy;
+        bool m_Merged = false;
+        std::atomic<int64_t> m_Shared = 0;
     };
 
-    template <typename T, bool Bound>
+    template <typename T, RefCounting Mode, typename Alloc>
+    class _InlineObjectManager : public _ObjectManager<T,Mode>
+    /*++
+      A control block with the object stored right after
+      the count, so MakeSharedRefPtr is one allocation and
+      the count and the object share cache lines. Memory
+      comes from Alloc, rebound to this type
+    --*/
+    {
+        using Base = _ObjectManager<T,Mode>;
+        using BlockAllocator = typename std::allocator_traits<Alloc>::template rebind_alloc<_InlineObjectManager>;
+        using BlockTraits = std::allocator_traits<BlockAllocator>;
+
+        template <class... Args>
+        _InlineObjectManager(
+            const Alloc& Allocator,
+            Args&&... x
+        ) : Base(reinterpret_cast<T*>(m_Storage), &Destroy),
+            m_Allocator(Allocator)
+        {
+            ::new ((void*)m_Storage) T(std::forward<Args>(x)...);
+        }
+
+        static _InlineObjectManager*
+        Create(
+            const Alloc& Allocator,
+            auto&&... x
+        )
+        {
+            BlockAllocator blockAllocator(Allocator);
+            auto block = BlockTraits::allocate(blockAllocator, 1);
+            return ::new ((void*)block) _InlineObjectManager(Allocator, std::forward<decltype(x)>(x)...);
+        }
+
+        static void
+        Destroy(
+            Base* Manager
+        )
+        {
+            auto self = static_cast<_InlineObjectManager*>(Manager);
+            std::destroy_at(self->get());
+            BlockAllocator blockAllocator(self->m_Allocator);
+            self->~_InlineObjectManager();
+            BlockTraits::deallocate(blockAllocator, self, 1);
+        }
+
+        [[no_unique_address]] Alloc m_Allocator;
+        alignas(T) unsigned char m_Storage[sizeof(T)];
+
+        template <typename U, RefCounting M, typename A, class... Args>
+        friend SharedRefPtr<U,M> _AllocateRefPtr(const A& Allocator, Args&&... x);
+    };
+
+    template <typename T, RefCounting Mode>
     class SharedRefPtr
     {
     public:
@@ -105,7 +406,6 @@ namespace dispatch
         --*/
         {
             reset();
-            m_Manager = nullptr;
             return *this;
         }
 
@@ -120,8 +420,9 @@ namespace dispatch
         --*/
         {
             reset();
-            m_Manager = new _ObjectManager<T,Bound>(std::move(Allocation));
+            m_Manager = new _ObjectManager<T,Mode>(std::move(Allocation));
             m_Manager->ref();
+            m_Pointer = Allocation;
             return *this;
         }
 
@@ -137,7 +438,9 @@ namespace dispatch
             {
                 reset();
                 m_Manager = Other.m_Manager;
+                m_Pointer = Other.m_Pointer;
                 Other.m_Manager = nullptr;
+                Other.m_Pointer = nullptr;
             }
             return *this;
         }
@@ -150,9 +453,16 @@ namespace dispatch
           Copy assignment
         --*/
         {
-            reset();
-            m_Manager = Other.m_Manager;
-            m_Manager->ref();
+            if (this != &Other)
+            {
+                reset();
+                m_Manager = Other.m_Manager;
+                m_Pointer = Other.m_Pointer;
+                if (m_Manager != nullptr)
+                {
+                    m_Manager->ref();
+                }
+            }
             return *this;
         }
 
@@ -161,8 +471,7 @@ namespace dispatch
             const SharedRefPtr& Other
         ) const
         {
-            return (m_Manager == nullptr && Other == nullptr) ||
-                (Other == m_Manager->m_Allocation);
+            return m_Pointer == Other.m_Pointer;
         }
 
         bool
@@ -170,7 +479,7 @@ namespace dispatch
             const void* Ptr
         ) const
         {
-            return (m_Manager == nullptr && Ptr == nullptr) || (m_Manager != nullptr && m_Manager->m_Allocation == Ptr);
+            return m_Pointer == Ptr;
         }
 
         bool
@@ -194,7 +503,7 @@ namespace dispatch
             void
         ) const
         {
-            return m_Manager == nullptr || m_Manager->m_Allocation == nullptr;
+            return m_Pointer == nullptr;
         }
 
         explicit operator
@@ -216,11 +525,13 @@ namespace dispatch
         get(
             void
         ) const
+        /*++
+          The object is cached next to the manager pointer so
+          a dereference is a single load
+        --*/
         {
-            if (m_Manager != nullptr){
-                return m_Manager->get();
-            }
-            return nullptr;
+            assert(m_Manager == nullptr || m_Manager->get() == m_Pointer);
+            return m_Pointer;
         }
 
         inline void
@@ -229,11 +540,12 @@ namespace dispatch
         )
         {
             if (m_Manager != nullptr &&
-                m_Manager->deref() == 0)
+                m_Manager->unref())
             {
-                delete m_Manager;
+                m_Manager->destroy();
             }
             m_Manager = nullptr;
+            m_Pointer = nullptr;
         }
 
         inline T*
@@ -249,7 +561,7 @@ namespace dispatch
             void
         ) const noexcept
         {
-            return *m_Manager->get();
+            return *get();
         }
 
         const size_t refs(
@@ -263,8 +575,32 @@ namespace dispatch
             return 0;
         }
 
+        void*
+        _Detach(
+            void
+        )
+        /*++
+          Give up our reference without dropping it, for
+          ReleaseSoon to drop elsewhere through
+          _ReleaseDetached
+        --*/
+        {
+            auto manager = m_Manager;
+            m_Manager = nullptr;
+            m_Pointer = nullptr;
+            return manager;
+        }
+
+        static void
+        _ReleaseDetached(
+            void* Manager
+        )
+        {
+            _ObjectManager<T,Mode>::Release(Manager);
+        }
+
 #ifdef TEST
-        _ObjectManager<T,Bound>*
+        _ObjectManager<T,Mode>*
         get_manager(
             void
         )
@@ -274,10 +610,43 @@ namespace dispatch
 #endif
 
     protected:
-        _ObjectManager<T,Bound>* m_Manager = nullptr;
+        _ObjectManager<T,Mode>* m_Manager = nullptr;
+        T* m_Pointer = nullptr;
 
+    private:
+        template <typename U, RefCounting M, typename A, class... Args>
+        friend SharedRefPtr<U,M> _AllocateRefPtr(const A& Allocator, Args&&... x);
     };
 
+    template <typename T, RefCounting Mode, typename Alloc, class... Args>
+    SharedRefPtr<T,Mode>
+    _AllocateRefPtr(
+        const Alloc& Allocator,
+        Args&&... x
+    )
+    {
+        auto manager = _InlineObjectManager<T,Mode,Alloc>::Create(Allocator, std::forward<Args>(x)...);
+        manager->ref();
+        SharedRefPtr<T,Mode> ptr;
+        ptr.m_Manager = manager;
+        ptr.m_Pointer = manager->get();
+        return ptr;
+    }
+
+
+    template <typename T, typename Alloc, class... Args>
+    dispatch::SharedRefPtr<T>
+    AllocateSharedRefPtr(
+        const Alloc& Allocator,
+        Args&&... x
+    )
+    /*++
+      MakeSharedRefPtr with the control block and object
+      taken from Allocator
+    --*/
+    {
+        return _AllocateRefPtr<T,RefCounting::LOCAL>(Allocator, std::forward<Args>(x)...);
+    }
 
     template <typename T, class... Args>
     dispatch::SharedRefPtr<T>
@@ -285,12 +654,21 @@ namespace dispatch
         Args&&... x
     )
     {
-        T* allocation = new T(std::forward<Args>(x)...);
-        return SharedRefPtr<T>(allocation);
+        return AllocateSharedRefPtr<T>(std::allocator<T>(), std::forward<Args>(x)...);
     }
 
     template <typename T>
-    using BoundRefPtr = dispatch::SharedRefPtr<T,true>;
+    using BoundRefPtr = dispatch::SharedRefPtr<T,RefCounting::BOUND>;
+
+    template <typename T, typename Alloc, class... Args>
+    dispatch::BoundRefPtr<T>
+    AllocateBoundRefPtr(
+        const Alloc& Allocator,
+        Args&&... x
+    )
+    {
+        return _AllocateRefPtr<T,RefCounting::BOUND>(Allocator, std::forward<Args>(x)...);
+    }
 
     template <typename T, class... Args>
     dispatch::BoundRefPtr<T>
@@ -298,8 +676,35 @@ namespace dispatch
         Args&&... x
     )
     {
-        T* allocation = new T(std::forward<Args>(x)...);
-        return BoundRefPtr<T>(allocation);
+        return AllocateBoundRefPtr<T>(std::allocator<T>(), std::forward<Args>(x)...);
+    }
+
+    template <typename T>
+    using BiasedRefPtr = dispatch::SharedRefPtr<T,RefCounting::BIASED>;
+
+    template <typename T, typename Alloc, class... Args>
+    dispatch::BiasedRefPtr<T>
+    AllocateBiasedRefPtr(
+        const Alloc& Allocator,
+        Args&&... x
+    )
+    {
+        return _AllocateRefPtr<T,RefCounting::BIASED>(Allocator, std::forward<Args>(x)...);
+    }
+
+    template <typename T, class... Args>
+    dispatch::BiasedRefPtr<T>
+    MakeBiasedRefPtr(
+        Args&&... x
+    )
+    /*++
+      A pointer that is cheap to copy on the dispatcher
+      that makes it and safe to copy anywhere else. Until
+      the maker drops its last reference, that dispatcher
+      must be alive to merge releases from other threads
+    --*/
+    {
+        return AllocateBiasedRefPtr<T>(std::allocator<T>(), std::forward<Args>(x)...);
     }
 
 #ifdef STDPTR
@@ -307,6 +712,8 @@ namespace dispatch
 #define SharedPtr std::shared_ptr
 #define MakeBound std::make_shared
 #define BoundPtr std::shared_ptr
+#define MakeBiased std::make_shared
+#define BiasedPtr std::shared_ptr
 #define MakeUnique std::make_unique
 #define UniquePtr std::unique_ptr
 #else
@@ -314,6 +721,8 @@ namespace dispatch
 #define SharedPtr dispatch::SharedRefPtr
 #define MakeBound dispatch::MakeBoundRefPtr
 #define BoundPtr dispatch::BoundRefPtr
+#define MakeBiased dispatch::MakeBiasedRefPtr
+#define BiasedPtr dispatch::BiasedRefPtr
 #define MakeUnique std::make_unique
 #define UniquePtr std::unique_ptr
 #endif
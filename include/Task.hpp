@@ -0,0 +1,265 @@
+#pragma once
+
+#include <assert.h>
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "DispatcherBase.hpp"
+#include "JobAllocator.hpp"
+
+namespace dispatch
+{
+    extern thread_local DispatcherBase* ThreadQueue;
+
+    struct ScheduleAwaiter
+    /*++
+      Returned by DispatcherBase::Schedule. Awaiting it
+      suspends the coroutine and resumes it as a task on
+      the dispatcher. It always goes through the queue, so
+      awaiting the current dispatcher acts as a yield
+    --*/
+    {
+        DispatcherBase* m_Dispatcher;
+        TaskPriority m_Priority;
+
+        bool await_ready(void) const noexcept { return false; };
+        void await_suspend(std::coroutine_handle<> Handle) { m_Dispatcher->PostTask([Handle]{ Handle.resume(); }, m_Priority); };
+        void await_resume(void) const noexcept {};
+    };
+
+    struct SleepAwaiter
+    /*++
+      Returned by SleepFor. Resumes the coroutine on the
+      current dispatcher through its delayed queue
+    --*/
+    {
+        std::chrono::microseconds m_Delay;
+
+        bool await_ready(void) const noexcept { return m_Delay.count() <= 0; };
+        void
+        await_suspend(
+            std::coroutine_handle<> Handle
+        )
+        {
+            assert(ThreadQueue != nullptr);
+            ThreadQueue->PostDelayedTask([Handle]{ Handle.resume(); }, m_Delay);
+        }
+        void await_resume(void) const noexcept {};
+    };
+
+    inline SleepAwaiter
+    SleepFor(
+        const std::chrono::microseconds Delay
+    )
+    {
+        return SleepAwaiter{ Delay };
+    }
+
+    class TaskPromiseBase
+    /*++
+      State shared by every Task promise. Frames are
+      allocated from the creating dispatcher's frame
+      allocator where they fit
+    --*/
+    {
+    public:
+        static void* operator new(const size_t Size) { return AllocateFrame(Size); };
+        static void operator delete(void* Frame) { FreeFrame(Frame); };
+
+        std::suspend_always initial_suspend(void) noexcept { return {}; };
+        void unhandled_exception(void) noexcept { std::terminate(); };
+
+        struct FinalAwaiter
+        {
+            bool await_ready(void) noexcept { return false; };
+
+            template <typename Promise>
+            std::coroutine_handle<>
+            await_suspend(
+                std::coroutine_handle<Promise> Handle
+            ) noexcept
+            /*++
+              Hand control back to whoever awaited us, on
+              the dispatcher they awaited from. Once the
+              continuation is posted the awaiting side may
+              destroy this frame, so don't touch it after
+            --*/
+            {
+                auto& promise = Handle.promise();
+                if (promise.m_Detached)
+                {
+                    Handle.destroy();
+                    return std::noop_coroutine();
+                }
+
+                auto continuation = promise.m_Continuation;
+                auto resumeOn = promise.m_ResumeOn;
+                if (!continuation)
+                {
+                    return std::noop_coroutine();
+                }
+                if (resumeOn == nullptr || resumeOn == ThreadQueue)
+                {
+                    return continuation;
+                }
+                resumeOn->PostTask([continuation]{ continuation.resume(); });
+                return std::noop_coroutine();
+            }
+
+            void await_resume(void) noexcept {};
+        };
+
+        FinalAwaiter final_suspend(void) noexcept { return {}; };
+
+        std::coroutine_handle<> m_Continuation;
+        DispatcherBase* m_ResumeOn = nullptr;
+        bool m_Detached = false;
+    };
+
+    template <typename T>
+    class Task;
+
+    template <typename T>
+    class TaskPromise : public TaskPromiseBase
+    {
+    public:
+        Task<T> get_return_object(void);
+        template <typename U>
+        void return_value(U&& Value) { m_Value.emplace(std::forward<U>(Value)); };
+        std::optional<T> m_Value;
+    };
+
+    template <>
+    class TaskPromise<void> : public TaskPromiseBase
+    {
+    public:
+        Task<void> get_return_object(void);
+        void return_void(void) {};
+    };
+
+    template <typename T = void>
+    class Task
+    /*++
+      A lazily started coroutine returning T. It runs when
+      awaited, or when handed to Spawn. The awaiting
+      coroutine is resumed on the dispatcher it awaited
+      from, whichever dispatchers the task hopped to with
+      co_await Schedule() in between
+    --*/
+    {
+    public:
+        using promise_type = TaskPromise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        Task(void) = default;
+        explicit Task(Handle Coroutine) : m_Coroutine(Coroutine) {};
+        Task(const Task& Other) = delete;
+        Task& operator=(const Task& Other) = delete;
+        Task(Task&& Other) noexcept : m_Coroutine(std::exchange(Other.m_Coroutine, {})) {};
+
+        Task&
+        operator=(
+            Task&& Other
+        ) noexcept
+        {
+            if (this != &Other)
+            {
+                if (m_Coroutine)
+                {
+                    m_Coroutine.destroy();
+                }
+                m_Coroutine = std::exchange(Other.m_Coroutine, {});
+            }
+            return *this;
+        }
+
+        ~Task(
+            void
+        )
+        {
+            if (m_Coroutine)
+            {
+                m_Coroutine.destroy();
+            }
+        }
+
+        bool await_ready(void) const noexcept { return false; };
+
+        std::coroutine_handle<>
+        await_suspend(
+            std::coroutine_handle<> Awaiting
+        ) noexcept
+        {
+            auto& promise = m_Coroutine.promise();
+            promise.m_Continuation = Awaiting;
+            promise.m_ResumeOn = ThreadQueue;
+            return m_Coroutine;
+        }
+
+        T
+        await_resume(
+            void
+        )
+        {
+            if constexpr (!std::is_void_v<T>)
+            {
+                return std::move(*m_Coroutine.promise().m_Value);
+            }
+        }
+
+        Handle
+        Detach(
+            void
+        )
+        /*++
+          Give up ownership. The frame destroys itself
+          when the coroutine finishes
+        --*/
+        {
+            m_Coroutine.promise().m_Detached = true;
+            return std::exchange(m_Coroutine, {});
+        }
+
+        explicit operator bool(void) const noexcept { return (bool)m_Coroutine; };
+
+    private:
+        Handle m_Coroutine;
+    };
+
+    template <typename T>
+    inline Task<T>
+    TaskPromise<T>::get_return_object(
+        void
+    )
+    {
+        return Task<T>(Task<T>::Handle::from_promise(*this));
+    }
+
+    inline Task<void>
+    TaskPromise<void>::get_return_object(
+        void
+    )
+    {
+        return Task<void>(Task<void>::Handle::from_promise(*this));
+    }
+
+    template <typename T>
+    void
+    Spawn(
+        DispatcherBase* Dispatcher,
+        Task<T> ToRun
+    )
+    /*++
+      Start a task on Dispatcher without waiting for it.
+      Any result is discarded
+    --*/
+    {
+        auto coroutine = ToRun.Detach();
+        Dispatcher->PostTask([coroutine]{ coroutine.resume(); });
+    }
+
+}
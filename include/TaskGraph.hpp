@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "DispatchPool.hpp"
+#include "UniqueCallable.hpp"
+
+namespace dispatch
+{
+
+    class TaskGraph
+    /*++
+      A DAG of tasks declared up front and run on a
+      DispatchPool. Each node counts down its outstanding
+      dependencies, and the worker that finishes the last
+      dependency of a node queues it locally, running one
+      ready successor straight away without a round trip
+      through any queue. The graph keeps its nodes between
+      runs, so running it again allocates nothing beyond
+      the pooled job nodes
+    --*/
+    {
+    public:
+        using NodeId = size_t;
+
+        TaskGraph(void) = default;
+        TaskGraph(const TaskGraph& Other) = delete;
+        TaskGraph& operator=(const TaskGraph& Other) = delete;
+        ~TaskGraph(void);
+        NodeId AddNode(UniqueCallable Work);
+        void AddEdge(const NodeId Before, const NodeId After);
+        void Run(DispatchPool* Pool, UniqueCallable OnComplete = nullptr);
+        void Wait(void);
+        bool Running(void) const { return m_Running->load(std::memory_order_acquire); };
+        size_t Size(void) const { return m_Nodes.size(); };
+    private:
+        struct Node
+        {
+            Node(UniqueCallable Work) : m_Work(std::move(Work)) {};
+            UniqueCallable m_Work;
+            std::vector<NodeId> m_Successors;
+            uint32_t m_Dependencies = 0;
+            std::atomic<uint32_t> m_Pending = 0;
+        };
+
+        void Post(const NodeId Ready);
+        void Execute(NodeId Ready);
+        void Finish(void);
+
+        std::deque<Node> m_Nodes;
+        DispatchPool* m_Pool = nullptr;
+        UniqueCallable m_OnComplete;
+        DispatcherBase* m_ReplyTo = nullptr;
+        std::atomic<size_t> m_Remaining = 0;
+        //
+        // Owned apart from the graph so the last worker can
+        // still wake waiters on it once the graph is gone
+        //
+        std::shared_ptr<std::atomic<bool>> m_Running = std::make_shared<std::atomic<bool>>(false);
+    };
+
+}
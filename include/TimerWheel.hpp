@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "Job.hpp"
+#include "RunQueue.hpp"
+
+namespace dispatch
+{
+
+    class TimerWheel
+    /*++
+      Hierarchical timing wheel holding the delayed jobs
+      of a dispatcher. Each level has 64 slots, each slot
+      at level L spanning 64^L ticks. Insertion is O(1)
+      and expiry only touches the slots that are due or
+      need cascading to a lower level, so the cost is
+      independent of the number of pending timers.
+      Only ever modified from the dispatcher's own thread,
+      the size may be read from anywhere.
+    --*/
+    {
+    public:
+        static constexpr size_t LEVELS = 8;
+        static constexpr size_t SLOT_BITS = 6;
+        static constexpr size_t SLOTS = 1 << SLOT_BITS;
+        static constexpr std::chrono::microseconds RESOLUTION = std::chrono::microseconds(100);
+
+        TimerWheel(void);
+        TimerWheel(const TimerWheel& Other) = delete;
+        TimerWheel& operator=(const TimerWheel& Other) = delete;
+        void Insert(Job&& ToInsert);
+        size_t Expire(const timepoint Now, RunQueue& Queue);
+        timepoint NextExpiry(void) const;
+        size_t Size(void) const { return m_Size.load(std::memory_order_relaxed); };
+        bool Empty(void) const { return Size() == 0; };
+    private:
+        uint64_t FloorTick(const timepoint Time) const;
+        uint64_t CeilTick(const timepoint Time) const;
+        timepoint TickTime(const uint64_t Tick) const;
+        void Place(Job&& ToPlace);
+        void Advance(const uint64_t Tick);
+        void DrainSlot(const size_t Level, const size_t Slot, std::vector<Job>& Destination);
+
+        timepoint m_Start;
+        uint64_t m_Current = 0;
+        std::atomic<size_t> m_Size = 0;
+        uint64_t m_Occupied[LEVELS] = {};
+        std::vector<Job> m_Slots[LEVELS][SLOTS];
+        std::vector<Job> m_Due;
+        std::vector<Job> m_Cascade;
+    };
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace dispatch
+{
+
+    //
+    // A set of logical CPU numbers, kept sorted
+    //
+    using CpuSet = std::vector<int>;
+
+    struct NumaNode
+    {
+        int m_Id;
+        CpuSet m_Cpus;
+    };
+
+    CpuSet ParseCpuList(const std::string& List);
+    std::string FormatCpuList(const CpuSet& Cpus);
+    CpuSet OnlineCpus(void);
+    std::vector<NumaNode> NumaNodes(void);
+    CpuSet GetThreadAffinity(void);
+    bool SetThreadAffinity(const CpuSet& Cpus);
+
+}
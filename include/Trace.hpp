@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+#include "Job.hpp"
+
+//
+// Build with DISPATCH_NO_TRACE defined to compile the
+// hooks below out of the post and dispatch paths
+//
+
+namespace dispatch
+{
+
+    //
+    // Events kept per thread. Once a thread's buffer is
+    // full its oldest events are overwritten
+    //
+    constexpr size_t TRACE_BUFFER_EVENTS = 1 << 15;
+
+    extern std::atomic<bool> g_Tracing;
+
+    void StartTracing(void);
+    void StopTracing(void);
+    bool DumpTrace(const std::string& Path);
+
+    void TraceJobPosted(Job& Posted);
+    void TraceJobStarted(const uint64_t TraceId);
+    void TraceJobEnded(const uint64_t TraceId);
+    void TraceJobReplied(const uint64_t TraceId, const uint64_t ReplyId);
+
+    inline void
+    TracePost(
+        Job& ToPost
+    )
+    /*++
+      Give ToPost, and its reply if any, trace ids. Jobs
+      posted with tracing off keep an id of zero and are
+      never traced, whenever they run
+    --*/
+    {
+#ifndef DISPATCH_NO_TRACE
+        if (g_Tracing.load(std::memory_order_relaxed)) [[unlikely]]
+        {
+            TraceJobPosted(ToPost);
+        }
+#endif
+    }
+
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifndef DISPATCH_INLINE_CALLABLE_SIZE
+#define DISPATCH_INLINE_CALLABLE_SIZE 48
+#endif
+
+namespace dispatch
+{
+
+    template <size_t InlineSize>
+    class BasicUniqueCallable
+    /*++
+      A move-only void(void) callable with an inline buffer
+      of InlineSize bytes. Functors that fit, and that can
+      be moved without throwing, are stored inline and never
+      touch the heap. Larger functors fall back to a single
+      heap allocation. Unlike std::function the target does
+      not need to be copyable, so it may capture move-only
+      state such as a std::unique_ptr.
+    --*/
+    {
+    public:
+        BasicUniqueCallable(void) noexcept = default;
+        BasicUniqueCallable(std::nullptr_t) noexcept {};
+
+        template <
+            typename Fn,
+            typename = std::enable_if_t<
+                !std::is_same_v<std::decay_t<Fn>, BasicUniqueCallable> &&
+                std::is_invocable_v<std::decay_t<Fn>&>
+            >
+        >
+        BasicUniqueCallable(
+            Fn&& Function
+        )
+        {
+            using Target = std::decay_t<Fn>;
+            if constexpr (FitsInline<Target>())
+            {
+                ::new ((void*)m_Storage) Target(std::forward<Fn>(Function));
+                m_Operations = &INLINE_OPERATIONS<Target>;
+            }
+            else
+            {
+                *(Target**)m_Storage = new Target(std::forward<Fn>(Function));
+                m_Operations = &HEAP_OPERATIONS<Target>;
+            }
+        }
+
+        BasicUniqueCallable(const BasicUniqueCallable& Other) = delete;
+        BasicUniqueCallable& operator=(const BasicUniqueCallable& Other) = delete;
+
+        BasicUniqueCallable(
+            BasicUniqueCallable&& Other
+        ) noexcept
+        {
+            *this = std::move(Other);
+        }
+
+        BasicUniqueCallable&
+        operator=(
+            BasicUniqueCallable&& Other
+        ) noexcept
+        {
+            if (this != &Other)
+            {
+                reset();
+                if (Other.m_Operations != nullptr)
+                {
+                    Other.m_Operations->m_Relocate(m_Storage, Other.m_Storage);
+                    m_Operations = Other.m_Operations;
+                    Other.m_Operations = nullptr;
+                }
+            }
+            return *this;
+        }
+
+        BasicUniqueCallable&
+        operator=(
+            std::nullptr_t
+        ) noexcept
+        {
+            reset();
+            return *this;
+        }
+
+        ~BasicUniqueCallable(
+            void
+        )
+        {
+            reset();
+        }
+
+        void
+        operator()(
+            void
+        )
+        {
+            m_Operations->m_Invoke(m_Storage);
+        }
+
+        explicit operator bool(void) const noexcept { return m_Operations != nullptr; };
+
+        template <typename Target>
+        Target*
+        target(
+            void
+        ) noexcept
+        /*++
+          Returns the stored functor if it is a Target,
+          otherwise nullptr
+        --*/
+        {
+            if constexpr (FitsInline<Target>())
+            {
+                return m_Operations == &INLINE_OPERATIONS<Target> ? (Target*)m_Storage : nullptr;
+            }
+            else
+            {
+                return m_Operations == &HEAP_OPERATIONS<Target> ? *(Target**)m_Storage : nullptr;
+            }
+        }
+
+        void
+        reset(
+            void
+        ) noexcept
+        {
+            if (m_Operations != nullptr)
+            {
+                m_Operations->m_Destroy(m_Storage);
+                m_Operations = nullptr;
+            }
+        }
+
+        template <typename Target>
+        static constexpr bool
+        FitsInline(
+            void
+        )
+        {
+            return sizeof(Target) <= InlineSize &&
+                alignof(Target) <= alignof(std::max_align_t) &&
+                std::is_nothrow_move_constructible_v<Target>;
+        }
+
+    private:
+        struct Operations
+        {
+            void (*m_Invoke)(void* Storage);
+            void (*m_Relocate)(void* Destination, void* Source);
+            void (*m_Destroy)(void* Storage);
+        };
+
+        template <typename Target>
+        static constexpr Operations INLINE_OPERATIONS = {
+            [](void* Storage) { (*(Target*)Storage)(); },
+            [](void* Destination, void* Source) {
+                ::new (Destination) Target(std::move(*(Target*)Source));
+                ((Target*)Source)->~Target();
+            },
+            [](void* Storage) { ((Target*)Storage)->~Target(); }
+        };
+
+        template <typename Target>
+        static constexpr Operations HEAP_OPERATIONS = {
+            [](void* Storage) { (**(Target**)Storage)(); },
+            [](void* Destination, void* Source) { *(Target**)Destination = *(Target**)Source; },
+            [](void* Storage) { delete *(Target**)Storage; }
+        };
+
+        alignas(std::max_align_t) unsigned char m_Storage[InlineSize < sizeof(void*) ? sizeof(void*) : InlineSize];
+        const Operations* m_Operations = nullptr;
+    };
+
+    using UniqueCallable = BasicUniqueCallable<DISPATCH_INLINE_CALLABLE_SIZE>;
+
+}
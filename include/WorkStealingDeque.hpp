@@ -0,0 +1,188 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+namespace dispatch
+{
+
+    template <typename T>
+    class WorkStealingDeque
+    /*++
+      Chase-Lev work-stealing deque of T pointers, using
+      the C11 memory orderings from Le et al. (PPoPP 2013).
+
+      The owning thread pushes and pops at the bottom
+      (LIFO) while any other thread may steal from the
+      top (FIFO). The backing array grows on demand;
+      retired arrays are kept until destruction as a
+      concurrent thief may still be reading them.
+    --*/
+    {
+    public:
+        WorkStealingDeque(
+            const size_t Capacity = 256
+        )
+        {
+            m_Array = new Array(Capacity);
+            m_Retired.push_back(m_Array.load(std::memory_order_relaxed));
+        }
+
+        WorkStealingDeque(const WorkStealingDeque& Other) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque& Other) = delete;
+
+        ~WorkStealingDeque(
+            void
+        )
+        {
+            for (auto array : m_Retired)
+            {
+                delete array;
+            }
+        }
+
+        void
+        Push(
+            T* Item
+        )
+        /*++
+          Owner only
+        --*/
+        {
+            int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+            int64_t top = m_Top.load(std::memory_order_acquire);
+            Array* array = m_Array.load(std::memory_order_relaxed);
+            if (bottom - top > (int64_t)array->m_Capacity - 1)
+            {
+                array = Grow(array, top, bottom);
+            }
+            array->Put(bottom, Item);
+            m_Bottom.store(bottom + 1, std::memory_order_release);
+        }
+
+        T*
+        Pop(
+            void
+        )
+        /*++
+          Owner only. Returns the most recently pushed
+          item or nullptr if the deque is empty
+        --*/
+        {
+            int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+            Array* array = m_Array.load(std::memory_order_relaxed);
+            m_Bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t top = m_Top.load(std::memory_order_relaxed);
+
+            T* item = nullptr;
+            if (top <= bottom)
+            {
+                item = array->Get(bottom);
+                if (top == bottom)
+                {
+                    //
+                    // Last item, race any thieves for it
+                    //
+                    if (!m_Top.compare_exchange_strong(
+                        top,
+                        top + 1,
+                        std::memory_order_seq_cst,
+                        std::memory_order_relaxed))
+                    {
+                        item = nullptr;
+                    }
+                    m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+                }
+            }
+            else
+            {
+                m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        T*
+        Steal(
+            void
+        )
+        /*++
+          Any thread. Returns the oldest item or nullptr
+          if the deque is empty or the steal lost a race
+        --*/
+        {
+            int64_t top = m_Top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+
+            if (top < bottom)
+            {
+                Array* array = m_Array.load(std::memory_order_acquire);
+                T* item = array->Get(top);
+                if (!m_Top.compare_exchange_strong(
+                    top,
+                    top + 1,
+                    std::memory_order_seq_cst,
+                    std::memory_order_relaxed))
+                {
+                    return nullptr;
+                }
+                return item;
+            }
+            return nullptr;
+        }
+
+        size_t
+        Size(
+            void
+        ) const
+        /*++
+          Approximate when called concurrently
+        --*/
+        {
+            int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+            int64_t top = m_Top.load(std::memory_order_relaxed);
+            return bottom > top ? (size_t)(bottom - top) : 0;
+        }
+
+        bool Empty(void) const { return Size() == 0; };
+
+    private:
+        struct Array
+        {
+            Array(const size_t Capacity) :
+                m_Capacity(Capacity),
+                m_Slots(new std::atomic<T*>[Capacity]) {};
+            ~Array(void) { delete[] m_Slots; };
+            T* Get(const int64_t Index) { return m_Slots[Index & (m_Capacity - 1)].load(std::memory_order_relaxed); };
+            void Put(const int64_t Index, T* Item) { m_Slots[Index & (m_Capacity - 1)].store(Item, std::memory_order_relaxed); };
+            const size_t m_Capacity;
+            std::atomic<T*>* m_Slots;
+        };
+
+        Array*
+        Grow(
+            Array* Old,
+            const int64_t Top,
+            const int64_t Bottom
+        )
+        {
+            Array* array = new Array(Old->m_Capacity * 2);
+            for (int64_t i = Top; i < Bottom; i++)
+            {
+                array->Put(i, Old->Get(i));
+            }
+            m_Retired.push_back(array);
+            m_Array.store(array, std::memory_order_release);
+            return array;
+        }
+
+        alignas(64) std::atomic<int64_t> m_Top = 0;
+        alignas(64) std::atomic<int64_t> m_Bottom = 0;
+        std::atomic<Array*> m_Array;
+        std::vector<Array*> m_Retired;
+    };
+
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "DeleteSoon.hpp"
+
+namespace dispatch
+{
+
+    thread_local DispatcherBase* DroppedQueue = nullptr;
+
+    struct PendingDelete
+    {
+        DispatcherBase* m_Dispatcher;
+        void (*m_Delete)(void*);
+        void* m_Object;
+    };
+
+    class DeleteBatch
+    /*++
+      The deletes for one dispatcher, run as one task. If
+      the task is dropped without running, for example by a
+      dispatcher destroyed with it still in its inbox, the
+      deletes still happen when it is destroyed rather than
+      leaking.
+
+      A dropped batch runs as if on its dispatcher, so the
+      BoundRefPtr releases in it are made here instead of
+      being sent back to a dispatcher that is going away
+    --*/
+    {
+    public:
+        DeleteBatch(void) = default;
+        DeleteBatch(DeleteBatch&& Other) noexcept : m_Pending(std::move(Other.m_Pending)) { Other.m_Pending.clear(); };
+        DeleteBatch(const DeleteBatch&) = delete;
+        ~DeleteBatch(void)
+        {
+            if (!m_Pending.empty())
+            {
+                auto previous = DroppedQueue;
+                DroppedQueue = m_Pending.front().m_Dispatcher;
+                Run();
+                DroppedQueue = previous;
+            }
+        };
+
+        void
+        Add(
+            const PendingDelete& Pending
+        )
+        {
+            m_Pending.push_back(Pending);
+        }
+
+        void
+        Run(
+            void
+        )
+        {
+            auto pending = std::move(m_Pending);
+            m_Pending.clear();
+            for (auto& entry : pending)
+            {
+                entry.m_Delete(entry.m_Object);
+            }
+        }
+    private:
+        std::vector<PendingDelete> m_Pending;
+    };
+
+    static thread_local std::vector<PendingDelete> g_PendingDeletes;
+
+    void
+    PostDeleteSoon(
+        DispatcherBase* Dispatcher,
+        void (*Delete)(void*),
+        void* Object
+    )
+    /*++
+      Queue Delete(Object) to run on Dispatcher. Threads
+      that are not dispatchers have no idle point to flush
+      at, so they post straight away
+    --*/
+    {
+        assert(Dispatcher != nullptr);
+        g_PendingDeletes.push_back(PendingDelete{ Dispatcher, Delete, Object });
+        if (ThreadQueue == nullptr || g_PendingDeletes.size() >= DELETE_SOON_BATCH)
+        {
+            FlushDeleteSoon();
+        }
+    }
+
+    void
+    FlushDeleteSoon(
+        void
+    )
+    /*++
+      Post everything this thread has queued, one task per
+      target dispatcher, in the order it was queued
+    --*/
+    {
+        if (g_PendingDeletes.empty())
+        {
+            return;
+        }
+
+        auto pending = std::move(g_PendingDeletes);
+        g_PendingDeletes.clear();
+        std::stable_sort(pending.begin(), pending.end(), [](const PendingDelete& Lhs, const PendingDelete& Rhs) {
+            return Lhs.m_Dispatcher < Rhs.m_Dispatcher;
+        });
+
+        for (size_t first = 0; first < pending.size();)
+        {
+            auto dispatcher = pending[first].m_Dispatcher;
+            DeleteBatch batch;
+            size_t last = first;
+            while (last < pending.size() && pending[last].m_Dispatcher == dispatcher)
+            {
+                batch.Add(pending[last++]);
+            }
+            dispatcher->PostTask(
+                [batch = std::move(batch)]() mutable {
+                    batch.Run();
+                },
+                TaskPriority::PRIORITY_LOW
+            );
+            first = last;
+        }
+    }
+
+}
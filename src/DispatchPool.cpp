@@ -1,3 +1,6 @@
+#include <assert.h>
+
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -9,92 +12,774 @@ namespace dispatch
 {
 
     DispatcherBase* CurrentQueue(void);
+    extern thread_local DispatcherBase* ThreadQueue;
+    extern thread_local DispatcherBase* ThreadDispatcher;
+
+    static constexpr size_t STEAL_ATTEMPTS = 32;
+
+    PoolWorker::PoolWorker(
+        const std::string& Name,
+        DispatchPool* Pool,
+        const size_t Index
+    ) : Dispatcher::Dispatcher(Name),
+        m_Pool(Pool),
+        m_Index(Index),
+        m_Seed(0x9E3779B97F4A7C15ull * (Index + 1))
+    {
+    }
 
-    DispatchPool::DispatchPool(const std::string& Name, const size_t Size)
-    :DispatcherBase::DispatcherBase(Name)
+    PoolWorker::~PoolWorker(
+        void
+    )
     {
         //
-        // Decide if we use the number of available cores
+        // Join before touching the deque so that we
+        // are the only remaining user of it
         //
-        size_t count = Size;
+        Wait();
+        JobNode* node;
+        while ((node = m_Deque.Pop()) != nullptr)
+        {
+            JobAllocator::Free(node);
+        }
+    }
+
+    void
+    PoolWorker::OnThreadStart(
+        void
+    )
+    /*++
+      Pin ourselves before the loop allocates anything, so
+      that first touch puts our job slabs on our own node
+    --*/
+    {
+        if (m_Affinity.empty())
+        {
+            return;
+        }
+        if (!SetThreadAffinity(m_Affinity))
+        {
+#ifdef DEBUG
+            std::cerr << "Warning, could not pin " << GetName() << " to CPUs " << FormatCpuList(m_Affinity) << std::endl;
+#endif
+        }
+    }
+
+    JobNode*
+    PoolWorker::StealFrom(
+        const std::vector<size_t>& Victims,
+        const bool SkipLocal
+    )
+    /*++
+      Try each of Victims once, starting from a random
+      one, and take the oldest task from the first one
+      that has any
+    --*/
+    {
+        auto& workers = m_Pool->m_Dispatchers;
+        m_Seed ^= m_Seed << 13;
+        m_Seed ^= m_Seed >> 7;
+        m_Seed ^= m_Seed << 17;
+        size_t start = m_Seed % Victims.size();
+        for (size_t i = 0; i < Victims.size(); i++)
+        {
+            auto victim = workers[Victims[(start + i) % Victims.size()]].get();
+            if (victim == this || (SkipLocal && victim->m_NodeIndex == m_NodeIndex))
+            {
+                continue;
+            }
+            auto node = victim->m_Deque.Steal();
+            if (node != nullptr)
+            {
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+    JobNode*
+    PoolWorker::StealFromSibling(
+        void
+    )
+    /*++
+      Steal from siblings on our own NUMA node first, and
+      only go to another node when they have nothing
+    --*/
+    {
+        auto node = StealFrom(m_Pool->m_NodeWorkers[m_NodeIndex], false);
+        if (node == nullptr && m_Pool->m_NodeWorkers.size() > 1)
+        {
+            node = StealFrom(m_Pool->m_AllWorkers, true);
+        }
+        return node;
+    }
+
+    JobNode*
+    PoolWorker::AcquireWork(
+        void
+    )
+    /*++
+      Called by the dispatch loop when the native queue is
+      empty. Pop our own deque first (LIFO), then the pool
+      injector, then steal from siblings (FIFO), spinning
+      briefly before letting the loop park
+    --*/
+    {
+        if (m_Pool->m_Mode != PoolMode::WORK_STEALING)
+        {
+            return nullptr;
+        }
+
+        auto node = m_Deque.Pop();
+        if (node != nullptr)
+        {
+            return node;
+        }
+
+        for (size_t attempt = 0; attempt < STEAL_ATTEMPTS; attempt++)
+        {
+            node = m_Pool->PopInjected();
+            if (node == nullptr)
+            {
+                node = StealFromSibling();
+            }
+            if (node != nullptr)
+            {
+                //
+                // There may be more where that came from,
+                // pass the wakeup on to another sleeper
+                //
+                if (m_Pool->StealableWorkPending())
+                {
+                    m_Pool->WakeParkedWorker();
+                }
+                return node;
+            }
+            std::this_thread::yield();
+        }
+        return nullptr;
+    }
+
+    bool
+    PoolWorker::ExternalWorkPending(
+        void
+    )
+    {
+        return m_Pool->m_Mode == PoolMode::WORK_STEALING && m_Pool->StealableWorkPending();
+    }
+
+    void
+    PoolWorker::OnPark(
+        const bool Parked
+    )
+    /*++
+      Publish that we are parked so posters know to wake us.
+      Whoever flips m_Parked back to false owns the decrement.
+      Elastic pools also note since when, to retire us once
+      we have idled long enough
+    --*/
+    {
+        if (m_Pool->IsElastic())
+        {
+            m_IdleSince.store(Parked ? MetricsBlock::Now() : 0, std::memory_order_relaxed);
+        }
+        if (m_Pool->m_Mode != PoolMode::WORK_STEALING)
+        {
+            return;
+        }
+        if (Parked)
+        {
+            m_Parked.store(true, std::memory_order_seq_cst);
+            m_Pool->m_Parked.fetch_add(1, std::memory_order_seq_cst);
+        }
+        else if (m_Parked.exchange(false))
+        {
+            m_Pool->m_Parked--;
+        }
+    }
+
+    void
+    PoolWorker::OnRoutedJobDone(
+        void
+    )
+    {
+        m_Pending.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void
+    PoolWorker::Notify(
+        void
+    )
+    /*++
+      A post found us asleep. Once our thread has retired
+      there is nobody to wake, so have the first worker,
+      which never retires, start it again to run the post.
+      Joining and starting threads is left to it so that no
+      poster ever waits on either
+    --*/
+    {
+        if (m_State.load() == WorkerState::STOPPED && !m_Pool->m_Stopping.load())
+        {
+            auto pool = m_Pool;
+            assert(this != pool->m_Dispatchers[0].get());
+            pool->m_Dispatchers[0]->PostTask([pool, this]{ pool->Revive(this); });
+            return;
+        }
+        Dispatcher::Notify();
+    }
+
+    void
+    PoolWorker::Retire(
+        void
+    )
+    /*++
+      Runs on our own thread once the pool has picked us to
+      retire. The loop leaves as soon as our queue is empty,
+      so stay if anything is still due to arrive here
+    --*/
+    {
+        auto ring = m_IoRing.load(std::memory_order_relaxed);
+        if (!m_DelayedQueue.Empty() || (ring != nullptr && ring->InFlight() != 0))
+        {
+            auto retiring = WorkerState::RETIRING;
+            m_State.compare_exchange_strong(retiring, WorkerState::RUNNING);
+            return;
+        }
+        KeepAlive(false);
+    }
+
+    void
+    PoolWorker::Unretire(
+        void
+    )
+    /*++
+      The pool grew again before we left
+    --*/
+    {
+        KeepAlive(true);
+        auto retiring = WorkerState::RETIRING;
+        m_State.compare_exchange_strong(retiring, WorkerState::RUNNING);
+    }
+
+    struct WorkerSlot
+    {
+        int m_Node;
+        CpuSet m_Cpus;
+    };
+
+    static std::vector<WorkerSlot>
+    PlanPlacement(
+        const PoolConfig& Config
+    )
+    /*++
+      Decide the node and CPUs of each worker. Pinned
+      workers are dealt out across nodes in turn, so that a
+      pool smaller than the machine still spreads evenly
+    --*/
+    {
+        std::vector<WorkerSlot> slots;
+        auto placed = Config.m_Placement != PoolPlacement::NONE || !Config.m_CpuSets.empty();
+        auto nodes = placed ? NumaNodes() : std::vector<NumaNode>();
+
+        size_t count = Config.m_Size;
+        if (count == 0)
+        {
+            for (auto& node : nodes)
+            {
+                count += node.m_Cpus.size();
+            }
+        }
         if (count == 0)
         {
-            count = std::thread::hardware_concurrency();
+            count = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+
+        if (!Config.m_CpuSets.empty())
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                auto cpus = Config.m_CpuSets[i % Config.m_CpuSets.size()];
+                std::sort(cpus.begin(), cpus.end());
+                int home = 0;
+                for (auto& node : nodes)
+                {
+                    if (!cpus.empty() && std::binary_search(node.m_Cpus.begin(), node.m_Cpus.end(), cpus.front()))
+                    {
+                        home = node.m_Id;
+                    }
+                }
+                slots.push_back(WorkerSlot{ home, cpus });
+            }
+            return slots;
+        }
+
+        if (!placed)
+        {
+            slots.assign(count, WorkerSlot{ 0, {} });
+            return slots;
+        }
+
+        std::vector<std::pair<size_t, int>> order;
+        for (size_t round = 0; ; round++)
+        {
+            auto added = order.size();
+            for (size_t node = 0; node < nodes.size(); node++)
+            {
+                if (round < nodes[node].m_Cpus.size())
+                {
+                    order.push_back({ node, nodes[node].m_Cpus[round] });
+                }
+            }
+            if (order.size() == added)
+            {
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            auto [node, cpu] = order[i % order.size()];
+            if (Config.m_Placement == PoolPlacement::PIN_CORES)
+            {
+                slots.push_back(WorkerSlot{ nodes[node].m_Id, CpuSet{ cpu } });
+            }
+            else
+            {
+                slots.push_back(WorkerSlot{ nodes[node].m_Id, nodes[node].m_Cpus });
+            }
+        }
+        return slots;
+    }
+
+    DispatchPool::DispatchPool(
+        const std::string& Name,
+        const size_t Size,
+        const PoolMode Mode
+    ) : DispatchPool(Name, PoolConfig{ Size, Mode })
+    {
+    }
+
+    DispatchPool::DispatchPool(
+        const std::string& Name,
+        const PoolConfig& Config
+    ) : DispatcherBase::DispatcherBase(Name),
+        m_Mode(Config.m_Mode),
+        m_Routing(Config.m_Routing),
+        m_LocalDepth(Config.m_LocalDepth),
+        m_GrowWait(Config.m_GrowWait),
+        m_RetireIdle(Config.m_RetireIdle)
+    {
+        //
+        // An elastic pool places all the workers it may
+        // grow to, starting only the first m_MinSize
+        //
+        auto slots = PlanPlacement(Config);
+        m_MinSize = slots.size();
+        if (Config.m_MaxSize > m_MinSize)
+        {
+            auto elastic = Config;
+            elastic.m_Size = Config.m_MaxSize;
+            slots = PlanPlacement(elastic);
         }
 
         //
         // Configure counters
         //
-        m_Active = count;
+        m_Active = m_MinSize;
+        m_Live = m_MinSize;
 
         //
-        // Initialize the dispatchers
+        // Initialize the dispatchers. They are all created
+        // before any is started as running workers walk
+        // m_Dispatchers looking for work to steal
         //
-        for (size_t i = 0; i < count; i++)
+        std::vector<int> nodeIds;
+        for (size_t i = 0; i < slots.size(); i++)
         {
             std::stringstream dispatcher_name;
             dispatcher_name << Name << "[" << i << "]";
-            auto dispatcher = std::make_unique<Dispatcher>(dispatcher_name.str());
+            auto dispatcher = std::make_unique<PoolWorker>(dispatcher_name.str(), this, i);
             dispatcher->SetThreadDispatcher(this);
             dispatcher->SetDestructionHandler(
                 std::bind(&DispatchPool::OnDispatcherTerminated, this, std::placeholders::_1)
             );
-            dispatcher->Run();
+
+            auto home = std::find(nodeIds.begin(), nodeIds.end(), slots[i].m_Node);
+            if (home == nodeIds.end())
+            {
+                nodeIds.push_back(slots[i].m_Node);
+                m_NodeWorkers.emplace_back();
+                home = nodeIds.end() - 1;
+            }
+            dispatcher->m_Node = slots[i].m_Node;
+            dispatcher->m_NodeIndex = home - nodeIds.begin();
+            dispatcher->m_Affinity = std::move(slots[i].m_Cpus);
+            m_NodeWorkers[dispatcher->m_NodeIndex].push_back(i);
+            m_AllWorkers.push_back(i);
             m_Dispatchers.push_back(std::move(dispatcher));
         }
+
+        for (size_t i = 0; i < m_MinSize; i++)
+        {
+            m_Dispatchers[i]->m_State = WorkerState::RUNNING;
+            m_Dispatchers[i]->Run();
+        }
+        ArmBalance();
+    }
+
+    DispatchPool::~DispatchPool(
+        void
+    )
+    /*++
+      Join every worker before any is destroyed, a worker
+      that is still running may be stealing from another
+    --*/
+    {
+        Wait();
+        m_Dispatchers.clear();
+        for (auto node : m_Injector)
+        {
+            JobAllocator::Free(node);
+        }
     }
 
-    DispatcherBase*
+    PoolWorker*
     DispatchPool::Next(
+        const size_t Count
+    )
+    /*++
+      Returns the next dispatcher to push Count tasks to,
+      as picked by our routing policy. Every policy but
+      round-robin counts them as pending on the worker
+      until they finish. Only live workers are picked
+    --*/
+    {
+        auto workers = m_Live.load(std::memory_order_relaxed);
+        PoolWorker* chosen;
+        switch (m_Routing)
+        {
+        case PoolRouting::TWO_CHOICES:
+        {
+            thread_local uint64_t seed = 0x9E3779B97F4A7C15ull ^ (uint64_t)(uintptr_t)&seed;
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            auto first = m_Dispatchers[seed % workers].get();
+            auto second = workers > 1 ? m_Dispatchers[(seed % workers + 1 + (seed >> 32) % (workers - 1)) % workers].get() : first;
+            chosen = second->m_Pending.load(std::memory_order_relaxed) < first->m_Pending.load(std::memory_order_relaxed) ? second : first;
+            break;
+        }
+        case PoolRouting::LEAST_LOADED:
+        {
+            //
+            // Start the scan somewhere new each time so
+            // that ties are spread around
+            //
+            auto start = m_Dispatched++;
+            chosen = m_Dispatchers[start % workers].get();
+            auto least = chosen->m_Pending.load(std::memory_order_relaxed);
+            for (size_t i = 1; i < workers && least > 0; i++)
+            {
+                auto worker = m_Dispatchers[(start + i) % workers].get();
+                auto pending = worker->m_Pending.load(std::memory_order_relaxed);
+                if (pending < least)
+                {
+                    chosen = worker;
+                    least = pending;
+                }
+            }
+            break;
+        }
+        default:
+            return m_Dispatchers[(m_Dispatched++) % workers].get();
+        }
+        chosen->m_Pending.fetch_add(Count, std::memory_order_relaxed);
+        return chosen;
+    }
+
+    PoolWorker*
+    DispatchPool::Target(
         void
     )
     /*++
-      Returns the next dispatcher to push tasks to.
-      Base implementation is a simple round-robin
+      The worker to post one task to. From one of our own
+      workers with little queued that is the worker itself,
+      the post staying on its lock-free native queue and
+      the task running as soon as the queue ahead of it
+      does. Anywhere else the routing policy decides
     --*/
-    {   
-        auto index = (m_Dispatched++) % m_Dispatchers.size();
-        return m_Dispatchers[index].get();
+    {
+        if (ThreadDispatcher == this)
+        {
+            auto worker = static_cast<PoolWorker*>(ThreadQueue);
+            if (worker->m_Queue.Size() < m_LocalDepth)
+            {
+                if (m_Routing != PoolRouting::ROUND_ROBIN)
+                {
+                    worker->m_Pending.fetch_add(1, std::memory_order_relaxed);
+                }
+                return worker;
+            }
+        }
+        return Next();
     }
     
+    void
+    DispatchPool::PostStealable(
+        Job&& ToPost
+    )
+    /*++
+      Work-stealing post. From one of our own workers the
+      task goes onto the bottom of its deque, from anywhere
+      else into the shared injector queue
+    --*/
+    {
+        SamplePostTime(ToPost);
+        TracePost(ToPost);
+        auto node = AllocateJobNode(std::move(ToPost));
+        if (ThreadDispatcher == this)
+        {
+            static_cast<PoolWorker*>(ThreadQueue)->m_Deque.Push(node);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> guard(m_InjectorMutex);
+            m_Injector.push_back(node);
+            m_Injected++;
+        }
+        WakeParkedWorker();
+    }
+
+    JobNode*
+    DispatchPool::PopInjected(
+        void
+    )
+    {
+        if (m_Injected.load(std::memory_order_relaxed) == 0)
+        {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> guard(m_InjectorMutex);
+        if (m_Injector.empty())
+        {
+            return nullptr;
+        }
+        auto node = m_Injector.front();
+        m_Injector.pop_front();
+        m_Injected--;
+        return node;
+    }
+
+    bool
+    DispatchPool::StealableWorkPending(
+        void
+    )
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_Injected.load(std::memory_order_relaxed) > 0)
+        {
+            return true;
+        }
+        for (auto& dispatcher : m_Dispatchers)
+        {
+            if (!dispatcher->m_Deque.Empty())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void
+    DispatchPool::WakeParkedWorker(
+        const size_t Count
+    )
+    /*++
+      Wake up to Count parked workers, if there are any.
+      The fence pairs with the one in StealableWorkPending
+      so that either the worker sees our task or we see
+      that it has parked
+    --*/
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_Parked.load(std::memory_order_relaxed) == 0)
+        {
+            return;
+        }
+        size_t woken = 0;
+        for (auto& dispatcher : m_Dispatchers)
+        {
+            if (dispatcher->m_Parked.load(std::memory_order_relaxed) &&
+                dispatcher->m_Parked.exchange(false))
+            {
+                m_Parked--;
+                dispatcher->Wake();
+                if (++woken == Count)
+                {
+                    return;
+                }
+            }
+        }
+    }
+
     void
     DispatchPool::PostTask(
-        const Callable& Task,
+        UniqueCallable Task,
         const TaskPriority Priority
     )
     /*++
       Post a task to the next dispatcher.
-      If the current queue is empty then always post the
-      task here as it is significantly faster
+      If we are on one of our workers and its queue is
+      near empty then post the task there, as it is
+      significantly faster
     --*/
     {
-        // auto currentDispatcher = CurrentQueue();
-        // if (currentDispatcher->Empty())
-        // {
-        //     currentDispatcher->PostTask(Task, Priority);
-        // }
-        // else
-        // {
-        //     Next()->PostTask(Task, Priority);
-        // }
-        Next()->PostTask(Task, Priority);
+        if (m_Mode == PoolMode::WORK_STEALING)
+        {
+            PostStealable(Job(std::move(Task), Priority, this));
+        }
+        else
+        {
+            auto worker = Target();
+            if (m_Routing == PoolRouting::ROUND_ROBIN)
+            {
+                worker->PostTask(std::move(Task), Priority);
+            }
+            else
+            {
+                auto job = Job(std::move(Task), Priority, worker);
+                job.SetRouted(true);
+                worker->PostTaskInternal(std::move(job));
+            }
+        }
+        ArmBalance();
     }
 
     void
     DispatchPool::PostTaskAndReply(
-        const Callable& Task,
-        const Callable& Reply,
+        UniqueCallable Task,
+        UniqueCallable Reply,
         const TaskPriority Priority
     )
     /*++
-      Post a task with reply to the next dispatcher
+      Post a task with reply to the next dispatcher, or
+      keep it on the current worker as PostTask would
     --*/
     {
-        Next()->PostTaskAndReply(
-            Task,
-            Reply,
-            Priority
-        );
+        if (m_Mode == PoolMode::WORK_STEALING)
+        {
+            assert(ThreadQueue != nullptr);
+            auto reply = Job(std::move(Reply), Priority, ThreadQueue);
+            PostStealable(Job(std::move(Task), Priority, this, reply));
+        }
+        else
+        {
+            auto worker = Target();
+            if (m_Routing == PoolRouting::ROUND_ROBIN)
+            {
+                worker->PostTaskAndReply(
+                    std::move(Task),
+                    std::move(Reply),
+                    Priority
+                );
+            }
+            else
+            {
+                assert(ThreadQueue != nullptr);
+                auto reply = Job(std::move(Reply), Priority, ThreadQueue);
+                auto job = Job(std::move(Task), Priority, worker, reply);
+                job.SetRouted(true);
+                worker->PostTaskInternal(std::move(job));
+            }
+        }
+        ArmBalance();
+    }
+
+    void
+    DispatchPool::PostTasks(
+        TaskBatch Tasks,
+        const TaskPriority Priority
+    )
+    /*++
+      Post a batch of tasks. In round-robin mode the batch
+      is split into one contiguous chunk per worker, each
+      posted with a single push and wakeup. In work-stealing
+      mode the batch goes onto our own deque, or into the
+      injector under one lock, and enough parked workers
+      are woken to start stealing it
+    --*/
+    {
+        if (Tasks.empty())
+        {
+            return;
+        }
+
+        if (m_Mode == PoolMode::WORK_STEALING)
+        {
+            if (ThreadDispatcher == this)
+            {
+                auto worker = static_cast<PoolWorker*>(ThreadQueue);
+                for (auto& task : Tasks)
+                {
+                    auto job = Job(std::move(task), Priority, this);
+                    SamplePostTime(job);
+                    TracePost(job);
+                    worker->m_Deque.Push(AllocateJobNode(std::move(job)));
+                }
+            }
+            else
+            {
+                std::vector<JobNode*> nodes;
+                nodes.reserve(Tasks.size());
+                for (auto& task : Tasks)
+                {
+                    auto job = Job(std::move(task), Priority, this);
+                    SamplePostTime(job);
+                    TracePost(job);
+                    nodes.push_back(AllocateJobNode(std::move(job)));
+                }
+                std::lock_guard<std::mutex> guard(m_InjectorMutex);
+                m_Injector.insert(m_Injector.end(), nodes.begin(), nodes.end());
+                m_Injected += nodes.size();
+            }
+            WakeParkedWorker(Tasks.size());
+            ArmBalance();
+            return;
+        }
+
+        //
+        // Hand out contiguous chunks, the first Tasks.size()
+        // % chunks of them one task larger than the rest
+        //
+        auto live = m_Live.load(std::memory_order_relaxed);
+        auto chunks = std::min(Tasks.size(), live);
+        auto chunkSize = Tasks.size() / chunks;
+        auto remainder = Tasks.size() % chunks;
+        std::span<UniqueCallable> remaining(Tasks);
+        if (m_Routing != PoolRouting::ROUND_ROBIN)
+        {
+            //
+            // Route chunk by chunk, each one counting
+            // towards the load the next is placed by
+            //
+            for (size_t i = 0; i < chunks; i++)
+            {
+                auto count = chunkSize + (i < remainder ? 1 : 0);
+                Next(count)->PostTaskSpan(remaining.first(count), Priority, true);
+                remaining = remaining.subspan(count);
+            }
+            ArmBalance();
+            return;
+        }
+        auto first = m_Dispatched.fetch_add(chunks);
+        for (size_t i = 0; i < chunks; i++)
+        {
+            auto count = chunkSize + (i < remainder ? 1 : 0);
+            auto worker = m_Dispatchers[(first + i) % live].get();
+            worker->PostTaskSpan(remaining.first(count), Priority);
+            remaining = remaining.subspan(count);
+        }
+        ArmBalance();
     }
 
     void
@@ -102,12 +787,18 @@ namespace dispatch
         void
     )
     /*++
-      Request each of the dispatchers to stop
+      Request each of the dispatchers with a thread to stop.
+      No retired worker is started again from here on
     --*/
     {
+        std::lock_guard<std::mutex> guard(m_ElasticMutex);
+        m_Stopping = true;
         for (auto& dispatcher : m_Dispatchers)
         {
-            dispatcher->Stop();
+            if (dispatcher->m_State.load() != WorkerState::STOPPED)
+            {
+                dispatcher->Stop();
+            }
         }
     }
 
@@ -116,13 +807,320 @@ namespace dispatch
         void
     )
     /*++
-      Request each of the dispatchers to start
+      Start the pool again at its minimum size
     --*/
     {
-        for (auto& dispatcher : m_Dispatchers)
         {
-            dispatcher->Start();
+            std::lock_guard<std::mutex> guard(m_ElasticMutex);
+            m_Stopping = false;
+            m_Live = m_MinSize;
+            for (auto& dispatcher : m_Dispatchers)
+            {
+                dispatcher->m_Probe.m_Sent = 0;
+                dispatcher->m_Probe.m_Wait = 0;
+            }
+            m_InjectorProbe.m_Sent = 0;
+            m_InjectorProbe.m_Wait = 0;
+            for (size_t i = 0; i < m_MinSize; i++)
+            {
+                StartWorker(m_Dispatchers[i].get());
+            }
         }
+
+        //
+        // A balance left queued from before we stopped
+        // carries on by itself
+        //
+        ArmBalance();
+    }
+
+    bool
+    DispatchPool::StartWorker(
+        PoolWorker* Worker
+    )
+    /*++
+      Give a worker whose thread has left a new one. Called
+      with m_ElasticMutex held
+    --*/
+    {
+        if (m_Stopping.load() || Worker->m_State.load() != WorkerState::STOPPED)
+        {
+            return false;
+        }
+
+        //
+        // The old thread has at most the end of its loop
+        // left to run. Threads are only joined under the
+        // lock, so nobody else can be waiting on it
+        //
+        if (!Worker->Wait())
+        {
+            return false;
+        }
+        Worker->KeepAlive(true);
+        Worker->m_IdleSince = 0;
+        Worker->m_State = WorkerState::RUNNING;
+        m_Active++;
+        Worker->Run();
+        return true;
+    }
+
+    void
+    DispatchPool::Revive(
+        PoolWorker* Worker
+    )
+    /*++
+      Start a retired worker that has been posted to since
+      it left, e.g. a reply to a task it posted or a post
+      routed to it just before it retired
+    --*/
+    {
+        std::lock_guard<std::mutex> guard(m_ElasticMutex);
+        StartWorker(Worker);
+    }
+
+    void
+    DispatchPool::SendProbe(
+        QueueProbe* Probe,
+        PoolWorker* Worker
+    )
+    /*++
+      Time a task through Worker's queue or, with no worker,
+      through the injector. Does nothing while the last one
+      is still in flight
+    --*/
+    {
+        if (Probe->m_Sent.load() != 0)
+        {
+            return;
+        }
+        Probe->m_Sent = MetricsBlock::Now();
+        auto task = [Probe]{
+            Probe->m_Wait = MetricsBlock::Now() - Probe->m_Sent.load();
+            Probe->m_Sent = 0;
+        };
+        if (Worker != nullptr)
+        {
+            Worker->PostTask(task);
+            return;
+        }
+        auto node = AllocateJobNode(Job(task, TaskPriority::PRIORITY_NORMAL, this));
+        {
+            std::lock_guard<std::mutex> guard(m_InjectorMutex);
+            m_Injector.push_back(node);
+            m_Injected++;
+        }
+        WakeParkedWorker();
+    }
+
+    void
+    DispatchPool::Balance(
+        void
+    )
+    /*++
+      Runs on the first worker of an elastic pool every
+      POOL_BALANCE_INTERVAL. Adds a worker while tasks wait
+      longer than m_GrowWait on average, measured by timing
+      probes through the queues, and otherwise retires the
+      last live worker once it has been parked for
+      m_RetireIdle. Workers are only added and retired at
+      the end, so the live ones are always the first
+      m_Live. Posting is left until the lock is dropped, a
+      post may have to start a retired worker.
+
+      Once the pool is back at its minimum with nothing
+      queued it stops running until the next post
+    --*/
+    {
+        std::vector<PoolWorker*> probes;
+        std::vector<PoolWorker*> retiring;
+        PoolWorker* unretire = nullptr;
+        bool probeInjector = false;
+        {
+            std::lock_guard<std::mutex> guard(m_ElasticMutex);
+            if (m_Stopping.load())
+            {
+                m_Balancing = false;
+                return;
+            }
+
+            //
+            // A probe still in flight has waited at least
+            // since it was sent
+            //
+            auto now = MetricsBlock::Now();
+            auto measure = [now](QueueProbe& Probe) {
+                auto sent = Probe.m_Sent.load();
+                auto wait = Probe.m_Wait.load();
+                return sent != 0 ? std::max(wait, now - sent) : wait;
+            };
+
+            //
+            // Idle workers wait for nothing. With stealing
+            // a parked worker would take any task waiting in
+            // the injector, so only time it when all are busy
+            //
+            auto live = m_Live.load();
+            int64_t total = 0;
+            if (m_Mode == PoolMode::WORK_STEALING)
+            {
+                if (m_Parked.load() == 0)
+                {
+                    total = measure(m_InjectorProbe) * (int64_t)live;
+                    probeInjector = true;
+                }
+                else
+                {
+                    m_InjectorProbe.m_Wait = 0;
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < live; i++)
+                {
+                    auto worker = m_Dispatchers[i].get();
+                    if (worker->m_IdleSince.load(std::memory_order_relaxed) == 0)
+                    {
+                        total += measure(worker->m_Probe);
+                        probes.push_back(worker);
+                    }
+                    else
+                    {
+                        worker->m_Probe.m_Wait = 0;
+                    }
+                }
+            }
+
+            auto growWait = std::chrono::duration_cast<std::chrono::nanoseconds>(m_GrowWait).count();
+            auto retireIdle = std::chrono::duration_cast<std::chrono::nanoseconds>(m_RetireIdle).count();
+            if (total > growWait * (int64_t)live && live < m_Dispatchers.size())
+            {
+                //
+                // The next worker may still be on its way
+                // out, or running posts that arrived after
+                //
+                auto worker = m_Dispatchers[live].get();
+                if (!StartWorker(worker) && worker->m_State.load() == WorkerState::RETIRING)
+                {
+                    unretire = worker;
+                }
+                m_Live = live + 1;
+            }
+            else if (live > m_MinSize)
+            {
+                auto worker = m_Dispatchers[live - 1].get();
+                auto idle = worker->m_IdleSince.load(std::memory_order_relaxed);
+                auto running = WorkerState::RUNNING;
+                if (idle != 0 && now - idle >= retireIdle &&
+                    worker->m_State.compare_exchange_strong(running, WorkerState::RETIRING))
+                {
+                    m_Live = live - 1;
+                    retiring.push_back(worker);
+                }
+            }
+
+            //
+            // Workers started again past the live ones only
+            // stay until they have run what was posted
+            //
+            for (size_t i = m_Live.load(); i < m_Dispatchers.size(); i++)
+            {
+                auto worker = m_Dispatchers[i].get();
+                auto running = WorkerState::RUNNING;
+                if (worker->m_IdleSince.load(std::memory_order_relaxed) != 0 &&
+                    worker->m_State.compare_exchange_strong(running, WorkerState::RETIRING))
+                {
+                    retiring.push_back(worker);
+                }
+            }
+        }
+
+        for (auto worker : retiring)
+        {
+            worker->PostTask([worker]{ worker->Retire(); });
+        }
+        if (unretire != nullptr)
+        {
+            unretire->PostTask([unretire]{ unretire->Unretire(); });
+        }
+
+        if (retiring.empty() && unretire == nullptr && NothingQueued())
+        {
+            //
+            // A post that saw us still balancing has left
+            // its task where the second look finds it
+            //
+            m_Balancing = false;
+            if (!NothingQueued())
+            {
+                ArmBalance();
+            }
+            return;
+        }
+
+        for (auto worker : probes)
+        {
+            SendProbe(&worker->m_Probe, worker);
+        }
+        if (probeInjector)
+        {
+            SendProbe(&m_InjectorProbe, nullptr);
+        }
+        m_Dispatchers[0]->PostDelayedTask(dispatch::bind(&DispatchPool::Balance, this), POOL_BALANCE_INTERVAL);
+    }
+
+    void
+    DispatchPool::ArmBalance(
+        void
+    )
+    /*++
+      Queue Balance on the first worker of an elastic pool
+      unless it already is. Every post to the pool calls
+      this, after the task is queued, so Balance can stop
+      while the pool is quiet
+    --*/
+    {
+        if (!IsElastic())
+        {
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!m_Balancing.load(std::memory_order_relaxed) && !m_Stopping.load() && !m_Balancing.exchange(true))
+        {
+            m_Dispatchers[0]->PostDelayedTask(dispatch::bind(&DispatchPool::Balance, this), POOL_BALANCE_INTERVAL);
+        }
+    }
+
+    bool
+    DispatchPool::NothingQueued(
+        void
+    )
+    /*++
+      Called from Balance on the first worker. True if the
+      pool is at its minimum size, nothing is waiting in
+      the injector or any worker's queues, and every other
+      worker is parked
+    --*/
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto live = m_Live.load();
+        if (live != m_MinSize || m_Active.load() != m_MinSize || m_Injected.load() != 0)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < live; i++)
+        {
+            auto worker = m_Dispatchers[i].get();
+            if (!worker->m_CrossThread.Empty() || !worker->m_Deque.Empty())
+            {
+                return false;
+            }
+            if (i == 0 ? !worker->m_Queue.Empty() : worker->m_IdleSince.load(std::memory_order_relaxed) == 0)
+            {
+                return false;
+            }
+        }
+        return true;
     }
 
     bool
@@ -131,14 +1129,110 @@ namespace dispatch
     )
     /*++
       Wait on each of the dispatchers. Only return
-      once all have completed
+      once all have completed, including any that a post
+      started again while we waited. Threads are joined
+      under m_ElasticMutex, as StartWorker may be replacing
+      one, but only once they have left their loop
+    --*/
+    {
+        for (;;)
+        {
+            for (auto& dispatcher : m_Dispatchers)
+            {
+                auto state = dispatcher->m_State.load();
+                while (state != WorkerState::STOPPED)
+                {
+                    dispatcher->m_State.wait(state);
+                    state = dispatcher->m_State.load();
+                }
+                std::lock_guard<std::mutex> guard(m_ElasticMutex);
+                if (dispatcher->m_State.load() == WorkerState::STOPPED)
+                {
+                    dispatcher->Wait();
+                }
+            }
+
+            std::lock_guard<std::mutex> guard(m_ElasticMutex);
+            auto running = std::any_of(m_Dispatchers.begin(), m_Dispatchers.end(), [](auto& Dispatcher) {
+                return Dispatcher->m_State.load() != WorkerState::STOPPED;
+            });
+            if (!running)
+            {
+                return true;
+            }
+        }
+    }
+
+    void
+    DispatchPool::SetIdlePolicy(
+        const IdlePolicy Policy,
+        const uint32_t Spins,
+        const uint32_t Yields
+    )
+    /*++
+      Apply the idle policy to each of the dispatchers
     --*/
     {
+        DispatcherBase::SetIdlePolicy(Policy, Spins, Yields);
         for (auto& dispatcher : m_Dispatchers)
         {
-            dispatcher->Wait();
+            dispatcher->SetIdlePolicy(Policy, Spins, Yields);
         }
-        return true;
+    }
+
+    std::vector<WorkerPlacement>
+    DispatchPool::GetPlacement(
+        void
+    )
+    /*++
+      Where each worker runs. An empty CPU set means the
+      worker is not pinned
+    --*/
+    {
+        std::vector<WorkerPlacement> placement;
+        for (auto& dispatcher : m_Dispatchers)
+        {
+            placement.push_back(WorkerPlacement{ dispatcher->GetName(), dispatcher->m_Node, dispatcher->m_Affinity });
+        }
+        return placement;
+    }
+
+    std::vector<size_t>
+    DispatchPool::GetWorkerLoad(
+        void
+    )
+    /*++
+      The tasks routed to each worker that have not
+      finished. Always zero with round-robin routing
+    --*/
+    {
+        std::vector<size_t> load;
+        for (auto& dispatcher : m_Dispatchers)
+        {
+            load.push_back(dispatcher->m_Pending.load(std::memory_order_relaxed));
+        }
+        return load;
+    }
+
+    DispatcherMetrics
+    DispatchPool::GetMetrics(
+        void
+    )
+    /*++
+      The sum over our workers. Tasks still waiting in the
+      injector or a worker's deque count as unclaimed
+    --*/
+    {
+        DispatcherMetrics metrics;
+        metrics.m_Name = GetName();
+        metrics.m_Dispatchers = 0;
+        metrics.m_Unclaimed = m_Injected.load(std::memory_order_relaxed);
+        for (auto& dispatcher : m_Dispatchers)
+        {
+            metrics.Merge(dispatcher->GetMetrics());
+            metrics.m_Unclaimed += dispatcher->m_Deque.Size();
+        }
+        return metrics;
     }
 
     void
@@ -147,9 +1241,21 @@ namespace dispatch
     )
     /*++
       Callback for the termination of a dispatcher
-      Update active count and callback if zero
+      Update active count and callback if zero.
+      A post racing a retiring worker's exit may have seen
+      its thread neither running nor stopped, so check for
+      one once stopped and have the first worker start it
     --*/
     {
+        auto worker = static_cast<PoolWorker*>(Dispatacher);
+        worker->m_State.store(WorkerState::STOPPED);
+        worker->m_State.notify_all();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!m_Stopping.load() && !worker->m_CrossThread.Empty())
+        {
+            m_Dispatchers[0]->PostTask([this, worker]{ Revive(worker); });
+        }
+
         m_Active--;
         if (m_Active == 0)
         {
@@ -18,7 +18,6 @@
 namespace dispatch
 {
     std::mutex g_DispatcherMutex;
-    std::map<std::string, DispatcherBasePtr> g_Dispatchers;
     std::vector<DispatcherBase*> g_CompletedDispatchers;
 
     std::atomic<size_t> g_ActiveDispatcherCount = 0;
@@ -31,17 +30,14 @@ namespace dispatch
 
     void
     RemoveDispatcher(DispatcherBase* Dispatcher)
+    /*++
+      Stop tracking Dispatcher. Handles to it stop
+      working, and the registry's reference is dropped
+      once any post racing with this has finished
+    --*/
     {
-        std::lock_guard<std::mutex> mutex(g_DispatcherMutex);
-        for (auto dispatcher = g_Dispatchers.begin(); dispatcher != g_Dispatchers.end(); dispatcher++)
-        {
-            if (std::get<1>(*dispatcher).get() == Dispatcher)
-            {
-                assert(Dispatcher->Completed());
-                g_Dispatchers.erase(dispatcher);
-                break;
-            }
-        }
+        assert(Dispatcher->Completed());
+        UnregisterDispatcher(Dispatcher->GetName(), Dispatcher->GetHandle());
     }
 
     void
@@ -75,8 +71,8 @@ namespace dispatch
         DispatcherBasePtr Dispatcher
     )
     {
+        Dispatcher->SetHandle(RegisterDispatcher(Name, Dispatcher));
         std::lock_guard<std::mutex> mutex(g_DispatcherMutex);
-        g_Dispatchers[Name] = Dispatcher;
         g_ActiveDispatcherCount++;
         g_TotalDispatchers++;
     }
@@ -84,11 +80,11 @@ namespace dispatch
     DispatcherBasePtr
     CreateAndEnterDispatcher(
         const std::string& Name,
-        const Callable& Entrypoint)
+        UniqueCallable Entrypoint)
     {
         
         auto dispatcher = std::make_shared<Dispatcher>(Name);
-        dispatcher->PostTask(Entrypoint);
+        dispatcher->PostTask(std::move(Entrypoint));
         dispatcher->SetDestructionHandler(std::bind(&OnDispatcherDestroyed, std::placeholders::_1));
         TrackDispatcher(Name, dispatcher);
         dispatcher->Enter();
@@ -98,11 +94,11 @@ namespace dispatch
     DispatcherBasePtr
     CreateDispatcher(
         const std::string& Name,
-        const Callable& Entrypoint
+        UniqueCallable Entrypoint
     )
     {
         auto dispatcher = std::make_shared<Dispatcher>(Name);
-        dispatcher->PostTask(Entrypoint);
+        dispatcher->PostTask(std::move(Entrypoint));
         dispatcher->SetDestructionHandler(std::bind(&OnDispatcherDestroyed, std::placeholders::_1));
         TrackDispatcher(Name, dispatcher);
         dispatcher->Run();
@@ -125,12 +121,12 @@ namespace dispatch
 
     DispatcherBasePtr
     CreateDispatcher(
-        const Callable& Entrypoint
+        UniqueCallable Entrypoint
     )
     {
         std::stringstream name;
         name << "anonymous" << g_TotalDispatchers++;
-        return CreateDispatcher(name.str(), Entrypoint);
+        return CreateDispatcher(name.str(), std::move(Entrypoint));
     }
 
     DispatcherBasePtr
@@ -147,13 +143,45 @@ namespace dispatch
         return CreateDispatcher(name.str());
     }
 
+#ifdef __linux__
+    ReactorDispatcherPtr
+    CreateReactorDispatcher(
+        const std::string& Name
+    )
+    /*++
+      Create a dispatcher that can also wait on file
+      descriptors, see ReactorDispatcher::WatchFd
+    --*/
+    {
+        auto dispatcher = std::make_shared<ReactorDispatcher>(Name);
+        dispatcher->SetDestructionHandler(std::bind(&OnDispatcherDestroyed, std::placeholders::_1));
+        TrackDispatcher(Name, dispatcher);
+        dispatcher->Run();
+        return dispatcher;
+    }
+#endif
+
     DispatcherPoolPtr
     CreateDispatchPool(
         const std::string& Name,
-        const size_t Size
+        const size_t Size,
+        const PoolMode Mode
     )
     {
-        auto dispatcher = std::make_shared<DispatchPool>(Name, Size);
+        auto dispatcher = std::make_shared<DispatchPool>(Name, Size, Mode);
+        dispatcher->SetDestructionHandler(std::bind(&OnDispatcherDestroyed, std::placeholders::_1));
+        TrackDispatcher(Name, dispatcher);
+        dispatcher->Run();
+        return dispatcher;
+    }
+
+    DispatcherPoolPtr
+    CreateDispatchPool(
+        const std::string& Name,
+        const PoolConfig& Config
+    )
+    {
+        auto dispatcher = std::make_shared<DispatchPool>(Name, Config);
         dispatcher->SetDestructionHandler(std::bind(&OnDispatcherDestroyed, std::placeholders::_1));
         TrackDispatcher(Name, dispatcher);
         dispatcher->Run();
@@ -163,18 +191,44 @@ namespace dispatch
     DispatcherBasePtr
     GetDispatcher(std::string Name)
     {
-        std::lock_guard<std::mutex> mutex(g_DispatcherMutex);
-        if (g_Dispatchers.find(Name) == g_Dispatchers.end())
+        return LookupDispatcher(Name).Lock();
+    }
+
+    DispatcherHandle
+    GetDispatcherHandle(
+        const std::string& Name
+    )
+    /*++
+      Resolve Name once to a handle that can be posted to
+      without any lookup. Invalid if there is no such
+      dispatcher
+    --*/
+    {
+        return LookupDispatcher(Name);
+    }
+
+    std::vector<DispatcherMetrics>
+    SnapshotMetrics(
+        void
+    )
+    /*++
+      The metrics of every named dispatcher, by name. A
+      pool reports once for all of its workers
+    --*/
+    {
+        std::vector<DispatcherMetrics> snapshot;
+        for (auto& dispatcher : ListDispatchers())
         {
-            return nullptr;
+            snapshot.push_back(dispatcher->GetMetrics());
         }
-        return g_Dispatchers.at(Name);
+        std::sort(snapshot.begin(), snapshot.end(), [](const DispatcherMetrics& Lhs, const DispatcherMetrics& Rhs) { return Lhs.m_Name < Rhs.m_Name; });
+        return snapshot;
     }
 
     void
     PostTaskToDispatcher(
         DispatcherBasePtr Dispatcher,
-        const Callable& Job
+        UniqueCallable Job
     )
     {
         Dispatcher->PostTask(std::move(Job));
@@ -183,33 +237,76 @@ namespace dispatch
     void
     PostTaskToDispatcher(
         const std::string& Name,
-        const Callable& Job
+        UniqueCallable Job
     )
     {
-        auto dispatcher = GetDispatcher(Name);
-        if (dispatcher)
-        {
-            PostTaskToDispatcher(dispatcher, std::move(Job));
-        }
-        else
+        if (!LookupDispatcher(Name).PostTask(std::move(Job)))
         {
             std::cerr << "Dispatcher " << Name << " not found" << std::endl;
         }
     }
 
+    bool
+    PostTaskToDispatcher(
+        const DispatcherHandle& Dispatcher,
+        UniqueCallable Job
+    )
+    {
+        return Dispatcher.PostTask(std::move(Job));
+    }
+
     void
     PostTaskToDispatcher(
         DispatcherBase* Dispatcher,
-        const Callable& Job
+        UniqueCallable Job
     )
     {
         Dispatcher->PostTask(std::move(Job));
     }
 
+    void
+    PostTasksToDispatcher(
+        DispatcherBase* Dispatcher,
+        TaskBatch Jobs
+    )
+    {
+        Dispatcher->PostTasks(std::move(Jobs));
+    }
+
+    void
+    PostTasksToDispatcher(
+        DispatcherBasePtr Dispatcher,
+        TaskBatch Jobs
+    )
+    {
+        Dispatcher->PostTasks(std::move(Jobs));
+    }
+
+    void
+    PostTasksToDispatcher(
+        const std::string& Name,
+        TaskBatch Jobs
+    )
+    {
+        if (!LookupDispatcher(Name).PostTasks(std::move(Jobs)))
+        {
+            std::cerr << "Dispatcher " << Name << " not found" << std::endl;
+        }
+    }
+
+    bool
+    PostTasksToDispatcher(
+        const DispatcherHandle& Dispatcher,
+        TaskBatch Jobs
+    )
+    {
+        return Dispatcher.PostTasks(std::move(Jobs));
+    }
+
     void
     PostDelayedTaskToDispatcher(
         DispatcherBase* Dispatcher,
-        const Callable& Job,
+        UniqueCallable Job,
         const std::chrono::microseconds Delay
     )
     {
@@ -219,7 +316,7 @@ namespace dispatch
     void
     PostDelayedTaskToDispatcher(
         DispatcherBasePtr Dispatcher,
-        const Callable& Job,
+        UniqueCallable Job,
         const std::chrono::microseconds Delay
     )
     {
@@ -229,26 +326,31 @@ namespace dispatch
     void
     PostDelayedTaskToDispatcher(
         const std::string& Name,
-        const Callable& Job,
+        UniqueCallable Job,
         const std::chrono::microseconds Delay
     )
     {
-        auto dispatcher = GetDispatcher(Name);
-        if (dispatcher)
-        {
-            PostDelayedTaskToDispatcher(dispatcher, std::move(Job), Delay);
-        }
-        else
+        if (!LookupDispatcher(Name).PostDelayedTask(std::move(Job), Delay))
         {
             std::cerr << "Dispatcher " << Name << " not found" << std::endl;
         }
     }
 
+    bool
+    PostDelayedTaskToDispatcher(
+        const DispatcherHandle& Dispatcher,
+        UniqueCallable Job,
+        const std::chrono::microseconds Delay
+    )
+    {
+        return Dispatcher.PostDelayedTask(std::move(Job), Delay);
+    }
+
     void
     PostTaskAndReply(
         DispatcherBasePtr Dispatcher,
-        const Callable& Job,
-        const Callable& Reply
+        UniqueCallable Job,
+        UniqueCallable Reply
     )
     {
         Dispatcher->PostTaskAndReply(std::move(Job), std::move(Reply));
@@ -257,49 +359,73 @@ namespace dispatch
     void
     PostTaskAndReply(
         const std::string& Name,
-        const Callable& Job,
-        const Callable& Reply
+        UniqueCallable Job,
+        UniqueCallable Reply
     )
     {
-        auto dispatcher = GetDispatcher(Name);
-        PostTaskAndReply(dispatcher, Job, Reply);
+        if (!LookupDispatcher(Name).PostTaskAndReply(std::move(Job), std::move(Reply)))
+        {
+            std::cerr << "Dispatcher " << Name << " not found" << std::endl;
+        }
+    }
+
+    bool
+    PostTaskAndReply(
+        const DispatcherHandle& Dispatcher,
+        UniqueCallable Job,
+        UniqueCallable Reply
+    )
+    {
+        return Dispatcher.PostTaskAndReply(std::move(Job), std::move(Reply));
     }
 
     void
     PostDelayedTask(
-        const Callable& Job,
+        UniqueCallable Job,
         const std::chrono::microseconds Delay
     )
     {
         auto dispatcher = CurrentDispatcher();
-        PostDelayedTaskToDispatcher(dispatcher, Job, Delay);
+        PostDelayedTaskToDispatcher(dispatcher, std::move(Job), Delay);
     }
 
     void
     PostDelayedTaskStrict(
-        const Callable& Job,
+        UniqueCallable Job,
         const std::chrono::microseconds Delay
     )
     {
         auto dispatcher = CurrentQueue();
-        PostDelayedTaskToDispatcher(dispatcher, Job, Delay);
+        PostDelayedTaskToDispatcher(dispatcher, std::move(Job), Delay);
     }
 
     void
     PostTask(
-        const Callable& Job
+        UniqueCallable Job
     )
     /*++
       Post a task to the current dispatcher
       --*/
     {
         auto dispatcher = CurrentDispatcher();
-        PostTaskToDispatcher(dispatcher, Job);
+        PostTaskToDispatcher(dispatcher, std::move(Job));
+    }
+
+    void
+    PostTasks(
+        TaskBatch Jobs
+    )
+    /*++
+      Post a batch of tasks to the current dispatcher
+    --*/
+    {
+        auto dispatcher = CurrentDispatcher();
+        PostTasksToDispatcher(dispatcher, std::move(Jobs));
     }
 
     void
     PostTaskStrict(
-        const Callable& Job
+        UniqueCallable Job
     )
     /*++
       Post a task to the current queue strictly
@@ -308,19 +434,69 @@ namespace dispatch
     --*/
     {
         auto dispatcher = CurrentQueue();
-        PostTaskToDispatcher(dispatcher, Job);
+        PostTaskToDispatcher(dispatcher, std::move(Job));
     }
 
     void
     PostTaskFast(
-        const Callable& Job
+        UniqueCallable Job
     )
     /*++
       The fastest way to post a task is to the
       current queue as it bypasses any locking
     --*/
     {
-        PostTaskStrict(Job);
+        PostTaskStrict(std::move(Job));
+    }
+
+    void
+    AsyncRead(
+        const int Fd,
+        void* Buffer,
+        const size_t Length,
+        const uint64_t Offset,
+        IoCompletion Completion
+    )
+    /*++
+      Read from Fd at Offset without blocking the current
+      dispatcher. Completion runs on this dispatcher with
+      the number of bytes read, or -errno. Buffer must stay
+      valid until then
+    --*/
+    {
+        assert(ThreadQueue != nullptr);
+        ThreadQueue->GetIoRing()->Read(Fd, Buffer, Length, Offset, std::move(Completion));
+    }
+
+    void
+    AsyncWrite(
+        const int Fd,
+        const void* Buffer,
+        const size_t Length,
+        const uint64_t Offset,
+        IoCompletion Completion
+    )
+    /*++
+      Write to Fd at Offset without blocking the current
+      dispatcher, see AsyncRead
+    --*/
+    {
+        assert(ThreadQueue != nullptr);
+        ThreadQueue->GetIoRing()->Write(Fd, Buffer, Length, Offset, std::move(Completion));
+    }
+
+    void
+    AsyncFsync(
+        const int Fd,
+        IoCompletion Completion
+    )
+    /*++
+      Flush Fd to storage without blocking the current
+      dispatcher. Completion receives 0 or -errno
+    --*/
+    {
+        assert(ThreadQueue != nullptr);
+        ThreadQueue->GetIoRing()->Fsync(Fd, std::move(Completion));
     }
 
     bool
@@ -11,8 +11,12 @@
 #include <algorithm>
 #include <deque>
 
+#include "DeleteSoon.hpp"
 #include "DispatcherBase.hpp"
+#include "Future.hpp"
 #include "Job.hpp"
+#include "SharedRefptr.hpp"
+#include "Task.hpp"
 
 namespace dispatch
 {
@@ -38,14 +42,179 @@ namespace dispatch
         if (m_Thread.joinable())
         {
             m_Thread.join();
-            m_Waiting = false;
         }
+        m_Waiting = false;
         return true;
     }
 
+    //
+    // Number of tasks run between polls of PollEvents()
+    // while the queue is busy, must be a power of two
+    //
+    static constexpr size_t EVENT_POLL_INTERVAL = 64;
+
+    static const bool g_MultiCore = std::thread::hardware_concurrency() > 1;
+
+    static inline void
+    CpuRelax(
+        void
+    )
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    void
+    DispatcherBase::SetIdlePolicy(
+        const IdlePolicy Policy,
+        const uint32_t Spins,
+        const uint32_t Yields
+    )
+    /*++
+      Choose how the dispatcher waits when it runs out of
+      work. SPIN and YIELD never block, BLOCK parks on the
+      condition variable straight away and ADAPTIVE spins
+      Spins times, then yields Yields times, then parks.
+      Takes effect the next time the dispatcher goes idle
+    --*/
+    {
+        m_IdleSpins.store(Spins, std::memory_order_relaxed);
+        m_IdleYields.store(Yields, std::memory_order_relaxed);
+        m_IdlePolicy.store(Policy, std::memory_order_relaxed);
+    }
+
+    bool
+    DispatcherBase::WorkArrived(
+        void
+    )
+    {
+        if (!m_CrossThread.Empty())
+        {
+            return true;
+        }
+        auto ring = m_IoRing.load(std::memory_order_relaxed);
+        if (ring != nullptr && ring->Ready())
+        {
+            return true;
+        }
+        if (!m_DelayedQueue.Empty() && std::chrono::system_clock::now() >= m_NextDelayedTask)
+        {
+            return true;
+        }
+        return ExternalWorkPending() || PollEvents();
+    }
+
+    void
+    DispatcherBase::Idle(
+        void
+    )
+    /*++
+      Called by the loop when there is nothing to run.
+      Polls for new work according to the idle policy,
+      parking once the policy allows it. Returns as soon
+      as work may be available
+    --*/
+    {
+        auto policy = m_IdlePolicy.load(std::memory_order_relaxed);
+        uint32_t spins = 0;
+        uint32_t yields = 0;
+        switch (policy)
+        {
+        case IdlePolicy::SPIN:
+            spins = UINT32_MAX;
+            break;
+        case IdlePolicy::YIELD:
+            yields = UINT32_MAX;
+            break;
+        case IdlePolicy::ADAPTIVE:
+            //
+            // Spinning on a single core only delays the
+            // thread that would post to us
+            //
+            spins = g_MultiCore ? m_IdleSpins.load(std::memory_order_relaxed) : 0;
+            yields = m_IdleYields.load(std::memory_order_relaxed);
+            break;
+        case IdlePolicy::BLOCK:
+            break;
+        }
+
+        for (;;)
+        {
+            for (uint32_t i = 0; i < spins; i++)
+            {
+                if (WorkArrived())
+                {
+                    return;
+                }
+                CpuRelax();
+            }
+            for (uint32_t i = 0; i < yields; i++)
+            {
+                if (WorkArrived())
+                {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            if (policy == IdlePolicy::BLOCK || policy == IdlePolicy::ADAPTIVE)
+            {
+                Park();
+                return;
+            }
+        }
+    }
+
     void
-    DispatcherBase::KeepAliveInternal(void)
+    DispatcherBase::Park(
+        void
+    )
+    /*++
+      Block until something is posted from another thread,
+      external work shows up or the next delayed task is due
+    --*/
+    {
+        assert(OnNativeThread());
+        OnPark(true);
+
+        //
+        // Posters only notify once they see m_Sleeping.
+        // The fence pairs with the one in PostJobChain so
+        // that either they see us sleeping or we see their
+        // task in the inbox
+        //
+        m_Sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Block();
+        m_Sleeping.store(false, std::memory_order_relaxed);
+        OnPark(false);
+    }
+
+    void
+    DispatcherBase::Block(
+        void
+    )
+    /*++
+      Wait on the condition variable. Runs with m_Sleeping
+      set, any post from now on will call Notify()
+    --*/
     {
+        //
+        // With I/O in flight wait on the ring instead, so
+        // that completions wake us as well as posts
+        //
+        auto ring = m_IoRing.load(std::memory_order_relaxed);
+        if (ring != nullptr && ring->Available() && ring->InFlight() != 0)
+        {
+            if (m_CrossThread.Empty() && !ExternalWorkPending())
+            {
+                ring->Wait(m_DelayedQueue.Empty() ? dispatch::MAXTIME : m_NextDelayedTask);
+            }
+            return;
+        }
+
         std::unique_lock<std::mutex> lk(m_CrossThreadMutex);
         //
         // We will only ever need to wake if a task
@@ -53,22 +222,97 @@ namespace dispatch
         // m_Queue can only be posted to by the current
         // thread (which is waiting...)
         //
-        assert(OnNativeThread());
-        if (m_DelayedQueue.size() == 0)
+        if (m_DelayedQueue.Empty())
         {
-            assert(m_Queue.size() == 0);
+            assert(m_Queue.Empty());
             m_TaskAvailable.wait(lk, [this]{
-                return m_CrossThread.size() > 0;}
+                return !m_CrossThread.Empty() || ExternalWorkPending();}
             );
         }
         else
         {
             m_TaskAvailable.wait_until(lk, m_NextDelayedTask, [this]{
-                return m_CrossThread.size() > 0;}
+                return !m_CrossThread.Empty() || ExternalWorkPending();}
             );
         }
     }
 
+    void
+    DispatcherBase::Notify(
+        void
+    )
+    /*++
+      Wake the dispatcher from Block(). Taking the mutex
+      orders us against a dispatcher that has checked for
+      work but not yet started waiting
+    --*/
+    {
+        auto ring = m_IoRing.load(std::memory_order_acquire);
+        if (ring != nullptr)
+        {
+            ring->Wake();
+        }
+        {
+            std::lock_guard<std::mutex> guard(m_CrossThreadMutex);
+        }
+        m_TaskAvailable.notify_one();
+    }
+
+    void
+    DispatcherBase::Wake(
+        void
+    )
+    /*++
+      Wake the dispatcher if it is parked so that it
+      re-checks for work, e.g. when ExternalWorkPending()
+      has become true
+    --*/
+    {
+        Notify();
+    }
+
+    IoRing*
+    DispatcherBase::GetIoRing(
+        void
+    )
+    /*++
+      The dispatcher's I/O ring, created on first use.
+      Only usable from the dispatcher's own thread
+    --*/
+    {
+        assert(OnNativeThread());
+        auto ring = m_IoRing.load(std::memory_order_relaxed);
+        if (ring == nullptr)
+        {
+            ring = new IoRing(this);
+            m_IoRing.store(ring, std::memory_order_release);
+        }
+        return ring;
+    }
+
+    DispatcherMetrics
+    DispatcherBase::GetMetrics(
+        void
+    )
+    /*++
+      A snapshot of our counters, safe from any thread.
+      Everything is zero when built with DISPATCH_NO_METRICS
+    --*/
+    {
+        DispatcherMetrics metrics;
+        metrics.m_Name = GetName();
+#ifndef DISPATCH_NO_METRICS
+        m_Metrics.Fill(metrics);
+        for (size_t i = 0; i < PRIORITY_LEVELS; i++)
+        {
+            metrics.m_Depth[i] = m_Queue.Depth(i);
+            metrics.m_HighWater[i] = m_Queue.HighWater(i);
+        }
+        metrics.m_Delayed = m_DelayedQueue.Size();
+#endif
+        return metrics;
+    }
+
     void
     DispatcherBase::SetThreadDispatcher(
         DispatcherBase* Dispatcher
@@ -84,14 +328,139 @@ namespace dispatch
     {
         assert(ToRun.ShouldRunNow());
         assert(OnNativeThread());
+
+#ifndef DISPATCH_NO_METRICS
+        //
+        // Clocks are only read for sampled tasks, and for
+        // delayed ones to see how late they are
+        //
+        bool sampled = (m_TasksCompleted & (METRICS_SAMPLE_INTERVAL - 1)) == 0;
+        int64_t start = 0;
+        if (sampled || ToRun.HasReadyTime())
+        {
+            start = MetricsBlock::Now();
+        }
+        if (ToRun.HasReadyTime())
+        {
+            auto ready = std::chrono::duration_cast<std::chrono::nanoseconds>(ToRun.GetReadyTime().time_since_epoch()).count();
+            m_Metrics.RecordQueueWait(start > ready ? start - ready : 0);
+        }
+#endif
+
+#ifndef DISPATCH_NO_TRACE
+        auto traceId = ToRun.GetTraceId();
+        if (traceId != 0) [[unlikely]]
+        {
+            TraceJobStarted(traceId);
+        }
+#endif
+
+        //
+        // Let the task find its reply, PostTaskWithResult
+        // stores the result straight into it
+        //
+        ThreadReply = ToRun.PeekReply();
         ToRun();
+        ThreadReply = nullptr;
         if (ToRun.HasReply())
         {
-            auto reply = std::move(*ToRun.GetReply());
-            auto dispatcher = (DispatcherBase*)reply.GetDispatcher();
-            dispatcher->PostTaskInternal(std::move(reply));
+            //
+            // The reply node was allocated when the task was
+            // posted, hand it over as is
+            //
+            auto reply = ToRun.GetReply();
+            auto dispatcher = (DispatcherBase*)reply->m_Job.GetDispatcher();
+            SamplePostTime(reply->m_Job);
+#ifndef DISPATCH_NO_TRACE
+            if (traceId != 0) [[unlikely]]
+            {
+                TraceJobReplied(traceId, reply->m_Job.GetTraceId());
+            }
+#endif
+            dispatcher->PostJobNode(reply.release());
         }
         m_TasksCompleted++;
+        if (ToRun.IsRouted())
+        {
+            OnRoutedJobDone();
+        }
+#ifndef DISPATCH_NO_TRACE
+        if (traceId != 0) [[unlikely]]
+        {
+            TraceJobEnded(traceId);
+        }
+#endif
+
+#ifndef DISPATCH_NO_METRICS
+        if (sampled)
+        {
+            m_Metrics.RecordRunTime(MetricsBlock::Now() - start);
+        }
+        m_Metrics.Ran();
+#endif
+    }
+
+    void
+    DispatcherBase::Handled(
+        const size_t Count,
+        const int64_t Nanoseconds
+    )
+    /*++
+      Called by subclasses that run handlers themselves
+      rather than through the queue, so they show up in
+      the metrics as work
+    --*/
+    {
+#ifndef DISPATCH_NO_METRICS
+        m_Metrics.Handled(Count, Nanoseconds);
+#endif
+    }
+
+    void
+    DispatcherBase::DrainCrossThread(
+        void
+    )
+    /*++
+      Take every job posted from other threads in a
+      single exchange and move them onto the native queues
+    --*/
+    {
+        auto node = m_CrossThread.Drain();
+        uint64_t count = 0;
+        while (node != nullptr)
+        {
+            auto next = node->m_Next;
+            Enqueue(std::move(node->m_Job));
+            JobAllocator::Free(node);
+            node = next;
+            count++;
+        }
+#ifndef DISPATCH_NO_METRICS
+        m_Metrics.CrossThread(count);
+#endif
+    }
+
+    void
+    DispatcherBase::Enqueue(
+        Job&& ToQueue
+    )
+    /*++
+      Put a job on our own queues. Native thread only
+    --*/
+    {
+        if (ToQueue.IsDelayed())
+        {
+            m_DelayedQueue.Insert(std::move(ToQueue));
+            m_NextDelayedTask = m_DelayedQueue.NextExpiry();
+        }
+        else
+        {
+            m_Queue.Push(std::move(ToQueue));
+        }
+        m_ReceivedTask = true;
+#ifndef DISPATCH_NO_METRICS
+        m_Metrics.Posted();
+#endif
     }
 
     void
@@ -110,28 +479,48 @@ namespace dispatch
 #else
         pthread_setname_np(pthread_self(), m_Name.c_str());
 #endif
+        OnThreadStart();
+#ifndef DISPATCH_NO_METRICS
+        m_Metrics.Started();
+#endif
 
         for (;;)
         {
-            if (m_CrossThread.size() > 0)
+            if (!m_CrossThread.Empty())
+            {
+                DrainCrossThread();
+            }
+
+            //
+            // Flush new I/O requests and collect finished
+            // ones, a batch at a time
+            //
+            auto ring = m_IoRing.load(std::memory_order_relaxed);
+            if (ring != nullptr && ring->Busy())
             {
-                std::lock_guard<std::mutex> guard(m_CrossThreadMutex);
-                for (auto& callable : m_CrossThread)
+                ring->Submit();
+                auto reaped = ring->Reap(m_Queue);
+                if (reaped != 0)
                 {
-                    PostTaskInternal(std::move(callable));
+                    m_ReceivedTask = true;
+#ifndef DISPATCH_NO_METRICS
+                    m_Metrics.Posted(reaped);
+#endif
                 }
-                m_CrossThread.clear();
             }
 
             //
-            // Check if we have a delayed task to run
-            // If so, add it to the start of the queue
+            // Check if we have delayed tasks to run
+            // If so, move all of them to the start of the queue
             //
-            if (m_DelayedQueue.size() > 0 && m_DelayedQueue.front().ShouldRunNow())
+            if (!m_DelayedQueue.Empty())
             {
-                auto job = std::move(m_DelayedQueue.front());
-                m_DelayedQueue.pop_front();
-                m_Queue.push_front(std::move(job));
+                auto now = std::chrono::system_clock::now();
+                if (now >= m_NextDelayedTask)
+                {
+                    m_DelayedQueue.Expire(now, m_Queue);
+                    m_NextDelayedTask = m_DelayedQueue.NextExpiry();
+                }
             }
 
             //
@@ -140,57 +529,113 @@ namespace dispatch
             if (m_Stop == true)
             {
                 // Empty the queue
-                m_Queue.clear();
+                m_Queue.Clear();
                 // Notify observers
                 NotifyCompletion();
                 break;
             }
 
-            if (m_Queue.size() == 0)
+            if (m_Queue.Empty())
+            {
+                //
+                // About to run dry, so send anything queued
+                // with DeleteSoon on its way
+                //
+                FlushDeleteSoon();
+
+                //
+                // Look for work outside of our own queues,
+                // such as stealing from sibling pool workers
+                //
+                auto node = AcquireWork();
+                if (node != nullptr)
+                {
+                    m_Queue.Push(std::move(node->m_Job));
+                    m_ReceivedTask = true;
+                    JobAllocator::Free(node);
+#ifndef DISPATCH_NO_METRICS
+                    m_Metrics.Posted();
+#endif
+                }
+            }
+
+            if (m_Queue.Empty())
             {
                 //
                 // Check if we kill this dispatcher
                 //
                 if (m_KeepAlive == false && m_ReceivedTask == true)
                 {
-                    break;
+                    //
+                    // Posters only notify a sleeping dispatcher,
+                    // so leave as one. Either a late post sees
+                    // that and calls Notify() or we see it here
+                    //
+                    m_Sleeping.store(true, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (m_CrossThread.Empty())
+                    {
+                        break;
+                    }
+                    m_Sleeping.store(false, std::memory_order_relaxed);
+                    continue;
                 }
 
                 //
                 // Notify the completion handler only
                 // if we have no delayed tasks
                 //
-                if (m_Queue.size() == 0)
+                if (m_Queue.Empty())
                 {
                     NotifyCompletion();
                 }
-                
+
+                //
+                // Wait for more work without touching
+                // the queue, then go round again
                 //
-                // Push the keep alive task onto the queue
+#ifndef DISPATCH_NO_METRICS
                 //
-                // auto job = Job(dispatch::bind(&DispatcherBase::KeepAliveInternal, this), TaskPriority::PRIORITY_NORMAL, this);
-                this->PostTask(
-                    dispatch::bind(
-                        &DispatcherBase::KeepAliveInternal,
-                        this
-                    ),
-                    TaskPriority::PRIORITY_NORMAL
-                );
-                m_Keepalives++;
+                // Handlers may run while we wait, which is
+                // not idle time
+                //
+                auto idleStart = MetricsBlock::Now();
+                auto handlerTime = m_Metrics.HandlerTime();
+                Idle();
+                m_Metrics.Idled(MetricsBlock::Now() - idleStart - (m_Metrics.HandlerTime() - handlerTime));
+#else
+                Idle();
+#endif
+                continue;
             }
 
-            auto job = std::move(m_Queue.front());
-            m_Queue.pop_front();
+            auto job = m_Queue.Pop();
 
             assert (job.ShouldRunNow());
             DispatchJob(std::move(job));
+
+            //
+            // Don't let a busy queue starve event sources
+            //
+            if ((m_TasksCompleted & (EVENT_POLL_INTERVAL - 1)) == 0)
+            {
+                PollEvents();
+            }
         }
 
+        FlushDeleteSoon();
+#ifndef DISPATCH_NO_METRICS
+        m_Metrics.Stopped();
+#endif
+
         //
-        // We are no longer the dispatcher for this thread
+        // We are no longer the dispatcher for this thread,
+        // and a later thread given the same id must not
+        // take itself for ours
         //
         ThreadQueue = nullptr;
         ThreadDispatcher = nullptr;
+        m_ThreadId = std::thread::id();
 
         //
         // This will be the last thing that the
@@ -216,8 +661,28 @@ namespace dispatch
         //
         Wait();
 
+        //
+        // Free anything posted after the loop exited
+        //
+        auto node = m_CrossThread.Drain();
+        while (node != nullptr)
+        {
+            auto next = node->m_Next;
+            JobAllocator::Free(node);
+            node = next;
+        }
+
+        delete m_IoRing.load();
+
+        //
+        // Nodes we allocated that are still in flight
+        // elsewhere keep the allocator alive
+        //
+        m_Allocator->Release();
+        m_FrameAllocator->Release();
+
 #ifdef DEBUGINFO
-        std::cerr << "Dispatcher \"" << GetName() << "\" terminating (compeleted " << m_TasksCompleted - m_Keepalives << " tasks)" << std::endl;
+        std::cerr << "Dispatcher \"" << GetName() << "\" terminating (compeleted " << m_TasksCompleted << " tasks)" << std::endl;
 #endif
     }
 
@@ -229,6 +694,7 @@ namespace dispatch
     {
         m_Stop = false;
         m_Completed = false;
+        m_Sleeping = false;
         m_Thread = std::thread(
             std::bind(
                 &DispatcherBase::DispatchLoop,
@@ -271,36 +737,145 @@ namespace dispatch
         Job TaskJob
     )
     {
+        SamplePostTime(TaskJob);
+        TracePost(TaskJob);
         if (OnNativeThread())
         {
-            if (TaskJob.IsDelayed())
+            Enqueue(std::move(TaskJob));
+        }
+        else
+        {
+            PostJobNode(AllocateJobNode(std::move(TaskJob)));
+        }
+    }
+
+    void
+    DispatcherBase::PostJobNode(
+        JobNode* Node
+    )
+    /*++
+      Post a job that is already wrapped in a node, taking
+      ownership of the node
+    --*/
+    {
+        PostJobChain(Node, Node);
+    }
+
+    void
+    DispatcherBase::PostJobChain(
+        JobNode* First,
+        JobNode* Last
+    )
+    /*++
+      Post a chain of nodes, linked First to Last via
+      m_Next, taking ownership of them. The jobs run in
+      chain order
+    --*/
+    {
+        if (OnNativeThread())
+        {
+            auto node = First;
+            while (true)
             {
-                m_DelayedQueue.push_back(std::move(TaskJob));
-                std::sort(m_DelayedQueue.begin(), m_DelayedQueue.end(), [](Job& a, Job& b){
-                    return a.GetDispatchTime() < b.GetDispatchTime();
-                });
-                m_NextDelayedTask = m_DelayedQueue.begin()->GetDispatchTime();
+                auto next = node->m_Next;
+                Enqueue(std::move(node->m_Job));
+                JobAllocator::Free(node);
+                if (node == Last)
+                {
+                    break;
+                }
+                node = next;
             }
-            else
+            return;
+        }
+
+        //
+        // Only the post that makes the inbox non-empty
+        // needs to wake the dispatcher, and only if it has
+        // parked rather than polling
+        //
+        if (m_CrossThread.PushChain(First, Last))
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_Sleeping.load(std::memory_order_relaxed))
             {
-                m_Queue.push_back(std::move(TaskJob));
-                std::sort(m_Queue.begin(), m_Queue.end());
+                Notify();
+            }
+        }
+    }
+
+    void
+    DispatcherBase::PostTasks(
+        TaskBatch Tasks,
+        const TaskPriority Priority
+    )
+    /*++
+      Post a batch of tasks in order
+    --*/
+    {
+        PostTaskSpan(Tasks, Priority);
+    }
+
+    void
+    DispatcherBase::PostTaskSpan(
+        std::span<UniqueCallable> Tasks,
+        const TaskPriority Priority,
+        const bool Routed
+    )
+    /*++
+      Post the tasks in Tasks, in order, moving from them.
+      From another thread the whole span is published with
+      a single push to the inbox and at most one wakeup.
+      Routed marks them as counted by a pool's router
+    --*/
+    {
+        if (Tasks.empty())
+        {
+            return;
+        }
+
+        if (OnNativeThread())
+        {
+            for (auto& task : Tasks)
+            {
+                auto job = Job(std::move(task), Priority, this);
+                job.SetRouted(Routed);
+                SamplePostTime(job);
+                TracePost(job);
+                m_Queue.Push(std::move(job));
             }
             m_ReceivedTask = true;
+#ifndef DISPATCH_NO_METRICS
+            m_Metrics.Posted(Tasks.size());
+#endif
+            return;
         }
-        else
+
+        JobNode* first = nullptr;
+        JobNode* last = nullptr;
+        for (auto& task : Tasks)
         {
+            auto job = Job(std::move(task), Priority, this);
+            job.SetRouted(Routed);
+            SamplePostTime(job);
+            TracePost(job);
+            auto node = AllocateJobNode(std::move(job));
+            if (last == nullptr)
+            {
+                first = node;
+            }
+            else
             {
-                std::lock_guard<std::mutex> guard(m_CrossThreadMutex);
-                m_CrossThread.push_back(std::move(TaskJob));
+                last->m_Next = node;
             }
-            m_TaskAvailable.notify_one();
+            last = node;
         }
+        PostJobChain(first, last);
     }
 
     void
     DispatcherBase::PostDelayedTask(
-        const Callable& Task,
+        UniqueCallable Task,
         const std::chrono::microseconds Delay
     )
     {
@@ -309,9 +884,21 @@ namespace dispatch
         PostTaskInternal(std::move(job));
     }
 
+    ScheduleAwaiter
+    DispatcherBase::Schedule(
+        const TaskPriority Priority
+    )
+    /*++
+      co_await the result to continue the current
+      coroutine on this dispatcher
+    --*/
+    {
+        return ScheduleAwaiter{ this, Priority };
+    }
+
     void
     Dispatcher::PostTask(
-        const Callable& Task,
+        UniqueCallable Task,
         const TaskPriority Priority
     )
     {
@@ -321,8 +908,8 @@ namespace dispatch
 
     void
     Dispatcher::PostTaskAndReply(
-        const Callable& Task,
-        const Callable& Reply,
+        UniqueCallable Task,
+        UniqueCallable Reply,
         const TaskPriority Priority
     )
     {
@@ -346,4 +933,21 @@ namespace dispatch
         this->DispatcherBase::PostTaskInternal(std::move(job));
     }
 
+    void
+    _PostToOwner(
+        void* Dispatcher,
+        void (*Function)(void*),
+        void* Context
+    )
+    /*++
+      Used by BiasedRefPtr to merge counts on the
+      dispatcher that owns them
+    --*/
+    {
+        static_cast<DispatcherBase*>(Dispatcher)->PostTask(
+            dispatch::bind(Function, Context),
+            TaskPriority::PRIORITY_HIGH
+        );
+    }
+
 }
\ No newline at end of file
@@ -0,0 +1,416 @@
+#include <assert.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "DispatcherBase.hpp"
+#include "DispatcherHandle.hpp"
+
+namespace dispatch
+{
+
+    static constexpr size_t SLOTS_PER_BLOCK = 256;
+    static constexpr size_t MAX_SLOT_BLOCKS = 1024;
+
+    //
+    // A slot's state packs the generation of the dispatcher
+    // in it, odd while live, above the count of posts that
+    // are using it right now
+    //
+    static constexpr uint64_t USERS_MASK = 0xffffffffull;
+    static constexpr uint64_t GENERATION_ONE = 1ull << 32;
+
+    struct DispatcherSlot
+    {
+        std::atomic<uint64_t> m_State = 0;
+        DispatcherBase* m_Dispatcher = nullptr;
+        std::shared_ptr<DispatcherBase> m_Owner;
+        uint32_t m_NextFree = DispatcherHandle::INVALID_INDEX;
+    };
+
+    struct DispatcherSlotBlock
+    {
+        DispatcherSlot m_Slots[SLOTS_PER_BLOCK];
+    };
+
+    using NameTable = std::unordered_map<std::string, DispatcherHandle>;
+
+    class DispatcherRegistry
+    /*++
+      Owns every tracked dispatcher. Slots live in blocks
+      that are never moved or freed while running, so a
+      stale handle can always look at its slot. Names map
+      to handles through an immutable table that is copied
+      on every change and cached per thread, so lookups
+      only load a version number unless something changed
+    --*/
+    {
+    public:
+        ~DispatcherRegistry(
+            void
+        )
+        {
+            for (auto& block : m_Blocks)
+            {
+                delete block.load(std::memory_order_relaxed);
+            }
+        }
+
+        DispatcherSlot*
+        GetSlot(
+            const uint32_t Index
+        )
+        {
+            if (Index / SLOTS_PER_BLOCK >= MAX_SLOT_BLOCKS)
+            {
+                return nullptr;
+            }
+            auto block = m_Blocks[Index / SLOTS_PER_BLOCK].load(std::memory_order_acquire);
+            return block == nullptr ? nullptr : &block->m_Slots[Index % SLOTS_PER_BLOCK];
+        }
+
+        DispatcherHandle
+        Register(
+            const std::string& Name,
+            std::shared_ptr<DispatcherBase> Dispatcher
+        )
+        {
+            DispatcherHandle replaced;
+            DispatcherHandle handle;
+            {
+                std::lock_guard<std::mutex> guard(m_Lock);
+                auto index = m_FreeSlot;
+                if (index == DispatcherHandle::INVALID_INDEX)
+                {
+                    index = m_SlotCount++;
+                    assert(index / SLOTS_PER_BLOCK < MAX_SLOT_BLOCKS);
+                    auto& block = m_Blocks[index / SLOTS_PER_BLOCK];
+                    if (block.load(std::memory_order_relaxed) == nullptr)
+                    {
+                        block.store(new DispatcherSlotBlock(), std::memory_order_release);
+                    }
+                }
+                auto slot = GetSlot(index);
+                m_FreeSlot = slot->m_NextFree;
+
+                slot->m_Dispatcher = Dispatcher.get();
+                slot->m_Owner = std::move(Dispatcher);
+                auto state = slot->m_State.fetch_add(GENERATION_ONE, std::memory_order_release);
+                handle = DispatcherHandle(index, (uint32_t)((state + GENERATION_ONE) >> 32));
+
+                auto table = std::make_shared<NameTable>();
+                if (auto current = m_Names.load(std::memory_order_acquire))
+                {
+                    *table = *current;
+                }
+                auto existing = table->find(Name);
+                if (existing != table->end())
+                {
+                    replaced = existing->second;
+                }
+                (*table)[Name] = handle;
+                Publish(std::move(table));
+            }
+
+            //
+            // Reusing a name drops the registry's hold on
+            // the dispatcher that had it
+            //
+            if (replaced)
+            {
+                Retire(replaced);
+            }
+            return handle;
+        }
+
+        void
+        Unregister(
+            const std::string& Name,
+            const DispatcherHandle Handle
+        )
+        {
+            {
+                std::lock_guard<std::mutex> guard(m_Lock);
+                auto current = m_Names.load(std::memory_order_acquire);
+                if (current != nullptr)
+                {
+                    auto existing = current->find(Name);
+                    if (existing != current->end() && existing->second == Handle)
+                    {
+                        auto table = std::make_shared<NameTable>(*current);
+                        table->erase(Name);
+                        Publish(std::move(table));
+                    }
+                }
+            }
+            Retire(Handle);
+        }
+
+        DispatcherHandle
+        Lookup(
+            const std::string& Name
+        )
+        {
+            thread_local uint64_t cachedVersion = 0;
+            thread_local std::shared_ptr<const NameTable> cachedTable;
+
+            auto version = m_Version.load(std::memory_order_acquire);
+            if (cachedVersion != version)
+            {
+                cachedTable = m_Names.load(std::memory_order_acquire);
+                cachedVersion = version;
+            }
+            if (cachedTable == nullptr)
+            {
+                return DispatcherHandle();
+            }
+            auto existing = cachedTable->find(Name);
+            return existing == cachedTable->end() ? DispatcherHandle() : existing->second;
+        }
+
+        std::vector<std::shared_ptr<DispatcherBase>>
+        List(
+            void
+        )
+        {
+            std::vector<std::shared_ptr<DispatcherBase>> dispatchers;
+            auto table = m_Names.load(std::memory_order_acquire);
+            if (table == nullptr)
+            {
+                return dispatchers;
+            }
+            for (auto& entry : *table)
+            {
+                if (auto dispatcher = entry.second.Lock())
+                {
+                    dispatchers.push_back(std::move(dispatcher));
+                }
+            }
+            return dispatchers;
+        }
+
+    private:
+        void
+        Publish(
+            std::shared_ptr<const NameTable> Table
+        )
+        {
+            m_Names.store(std::move(Table), std::memory_order_release);
+            m_Version.fetch_add(1, std::memory_order_release);
+        }
+
+        void
+        Retire(
+            const DispatcherHandle Handle
+        )
+        /*++
+          Invalidate Handle, wait out any post that is
+          still using it and then let go of the dispatcher
+        --*/
+        {
+            auto slot = GetSlot(Handle.GetIndex());
+            {
+                std::lock_guard<std::mutex> guard(m_Lock);
+                if (slot == nullptr || (slot->m_State.load(std::memory_order_relaxed) >> 32) != Handle.GetGeneration())
+                {
+                    return;
+                }
+                slot->m_State.fetch_add(GENERATION_ONE, std::memory_order_acq_rel);
+            }
+
+            while ((slot->m_State.load(std::memory_order_acquire) & USERS_MASK) != 0)
+            {
+                std::this_thread::yield();
+            }
+
+            auto owner = std::move(slot->m_Owner);
+            slot->m_Dispatcher = nullptr;
+            {
+                std::lock_guard<std::mutex> guard(m_Lock);
+                slot->m_NextFree = m_FreeSlot;
+                m_FreeSlot = Handle.GetIndex();
+            }
+
+            //
+            // Dropping the last reference joins the
+            // dispatcher's thread, so do it unlocked
+            //
+            owner.reset();
+        }
+
+        std::mutex m_Lock;
+        std::atomic<DispatcherSlotBlock*> m_Blocks[MAX_SLOT_BLOCKS] = {};
+        uint32_t m_SlotCount = 0;
+        uint32_t m_FreeSlot = DispatcherHandle::INVALID_INDEX;
+        std::atomic<std::shared_ptr<const NameTable>> m_Names;
+        std::atomic<uint64_t> m_Version = 1;
+    };
+
+    static DispatcherRegistry g_Registry;
+
+    DispatcherHandle
+    RegisterDispatcher(
+        const std::string& Name,
+        std::shared_ptr<DispatcherBase> Dispatcher
+    )
+    {
+        return g_Registry.Register(Name, std::move(Dispatcher));
+    }
+
+    void
+    UnregisterDispatcher(
+        const std::string& Name,
+        const DispatcherHandle Handle
+    )
+    {
+        g_Registry.Unregister(Name, Handle);
+    }
+
+    DispatcherHandle
+    LookupDispatcher(
+        const std::string& Name
+    )
+    {
+        return g_Registry.Lookup(Name);
+    }
+
+    std::vector<std::shared_ptr<DispatcherBase>>
+    ListDispatchers(
+        void
+    )
+    /*++
+      Every named dispatcher that is still live
+    --*/
+    {
+        return g_Registry.List();
+    }
+
+    DispatcherBase*
+    DispatcherHandle::Acquire(
+        void
+    ) const
+    /*++
+      Count ourselves as a user of the slot if it still
+      holds our generation. Retire waits for users to
+      leave, so the dispatcher outlives the post
+    --*/
+    {
+        auto slot = g_Registry.GetSlot(m_Index);
+        if (slot == nullptr)
+        {
+            return nullptr;
+        }
+        auto state = slot->m_State.fetch_add(1, std::memory_order_acquire);
+        if ((state >> 32) != m_Generation)
+        {
+            slot->m_State.fetch_sub(1, std::memory_order_release);
+            return nullptr;
+        }
+        return slot->m_Dispatcher;
+    }
+
+    void
+    DispatcherHandle::Release(
+        void
+    ) const
+    {
+        g_Registry.GetSlot(m_Index)->m_State.fetch_sub(1, std::memory_order_release);
+    }
+
+    bool
+    DispatcherHandle::PostTask(
+        UniqueCallable Task,
+        const TaskPriority Priority
+    ) const
+    {
+        auto dispatcher = Acquire();
+        if (dispatcher == nullptr)
+        {
+            return false;
+        }
+        dispatcher->PostTask(std::move(Task), Priority);
+        Release();
+        return true;
+    }
+
+    bool
+    DispatcherHandle::PostTasks(
+        TaskBatch Tasks,
+        const TaskPriority Priority
+    ) const
+    {
+        auto dispatcher = Acquire();
+        if (dispatcher == nullptr)
+        {
+            return false;
+        }
+        dispatcher->PostTasks(std::move(Tasks), Priority);
+        Release();
+        return true;
+    }
+
+    bool
+    DispatcherHandle::PostDelayedTask(
+        UniqueCallable Task,
+        const std::chrono::microseconds Delay
+    ) const
+    {
+        auto dispatcher = Acquire();
+        if (dispatcher == nullptr)
+        {
+            return false;
+        }
+        dispatcher->PostDelayedTask(std::move(Task), Delay);
+        Release();
+        return true;
+    }
+
+    bool
+    DispatcherHandle::PostTaskAndReply(
+        UniqueCallable Task,
+        UniqueCallable Reply,
+        const TaskPriority Priority
+    ) const
+    {
+        auto dispatcher = Acquire();
+        if (dispatcher == nullptr)
+        {
+            return false;
+        }
+        dispatcher->PostTaskAndReply(std::move(Task), std::move(Reply), Priority);
+        Release();
+        return true;
+    }
+
+    std::shared_ptr<DispatcherBase>
+    DispatcherHandle::Lock(
+        void
+    ) const
+    /*++
+      A strong reference to the dispatcher, or nullptr if
+      it has been removed
+    --*/
+    {
+        if (Acquire() == nullptr)
+        {
+            return nullptr;
+        }
+        auto owner = g_Registry.GetSlot(m_Index)->m_Owner;
+        Release();
+        return owner;
+    }
+
+    bool
+    DispatcherHandle::Valid(
+        void
+    ) const
+    {
+        auto slot = g_Registry.GetSlot(m_Index);
+        return slot != nullptr && (slot->m_State.load(std::memory_order_acquire) >> 32) == m_Generation;
+    }
+
+}
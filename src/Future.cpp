@@ -0,0 +1,102 @@
+#include <assert.h>
+
+#include <vector>
+
+#include "Future.hpp"
+
+namespace dispatch
+{
+    thread_local JobNode* ThreadReply = nullptr;
+
+    FutureTable*
+    FutureTable::Current(
+        void
+    )
+    /*++
+      The table of the dispatcher running on this thread.
+      None once its loop has exited, when no reply can
+      arrive either
+    --*/
+    {
+        return ThreadQueue != nullptr ? &ThreadQueue->GetFutureTable() : nullptr;
+    }
+
+    uint32_t
+    FutureTable::Acquire(
+        uint32_t& Generation
+    )
+    /*++
+      Take a free slot, returning its index and current
+      generation. The slot is empty until Update
+    --*/
+    {
+        auto table = Current();
+        assert(table != nullptr);
+        uint32_t slot = table->m_FreeSlot;
+        if (slot == NO_SLOT)
+        {
+            slot = (uint32_t)table->m_Slots.size();
+            table->m_Slots.push_back(FutureSlot{ nullptr, 0, NO_SLOT });
+        }
+        else
+        {
+            table->m_FreeSlot = table->m_Slots[slot].m_NextFree;
+        }
+        Generation = table->m_Slots[slot].m_Generation;
+        return slot;
+    }
+
+    void
+    FutureTable::Update(
+        const uint32_t Slot,
+        void* Future
+    )
+    {
+        auto table = Current();
+        assert(table != nullptr && Slot < table->m_Slots.size());
+        table->m_Slots[Slot].m_Future = Future;
+    }
+
+    void
+    FutureTable::Release(
+        const uint32_t Slot
+    )
+    /*++
+      Return Slot to the free list. Bumping the generation
+      makes any reply still holding it miss in Lookup. A
+      future outliving its dispatcher's loop has nothing
+      left to release
+    --*/
+    {
+        auto table = Current();
+        if (table == nullptr)
+        {
+            return;
+        }
+        assert(Slot < table->m_Slots.size());
+        auto& slot = table->m_Slots[Slot];
+        slot.m_Future = nullptr;
+        slot.m_Generation++;
+        slot.m_NextFree = table->m_FreeSlot;
+        table->m_FreeSlot = Slot;
+    }
+
+    void*
+    FutureTable::Lookup(
+        const uint32_t Slot,
+        const uint32_t Generation
+    )
+    /*++
+      The future waiting on Slot, or nullptr if it has
+      since gone away
+    --*/
+    {
+        auto table = Current();
+        if (table == nullptr || Slot >= table->m_Slots.size() || table->m_Slots[Slot].m_Generation != Generation)
+        {
+            return nullptr;
+        }
+        return table->m_Slots[Slot].m_Future;
+    }
+
+}
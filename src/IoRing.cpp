@@ -0,0 +1,456 @@
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+
+#include "IoRing.hpp"
+
+namespace dispatch
+{
+
+#ifdef __linux__
+    //
+    // Opcodes for the synchronous fallback, which share
+    // the io_uring values when they are available
+    //
+    static constexpr uint8_t OP_READ = IORING_OP_READ;
+    static constexpr uint8_t OP_WRITE = IORING_OP_WRITE;
+    static constexpr uint8_t OP_FSYNC = IORING_OP_FSYNC;
+
+    //
+    // The ring indices are shared with the kernel
+    //
+    static inline unsigned
+    LoadAcquire(
+        unsigned* Location
+    )
+    {
+        return std::atomic_ref<unsigned>(*Location).load(std::memory_order_acquire);
+    }
+
+    static inline void
+    StoreRelease(
+        unsigned* Location,
+        const unsigned Value
+    )
+    {
+        std::atomic_ref<unsigned>(*Location).store(Value, std::memory_order_release);
+    }
+#else
+    static constexpr uint8_t OP_READ = 0;
+    static constexpr uint8_t OP_WRITE = 1;
+    static constexpr uint8_t OP_FSYNC = 2;
+#endif
+
+    IoRing::IoRing(
+        void* Dispatcher
+    ) : m_Dispatcher(Dispatcher)
+    /*++
+      Set up the ring, leaving m_Fd as -1 and falling back
+      to synchronous I/O if anything fails
+    --*/
+    {
+#ifdef __linux__
+        io_uring_params params = {};
+        int fd = syscall(__NR_io_uring_setup, ENTRIES, &params);
+        if (fd < 0)
+        {
+            return;
+        }
+
+        m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            m_SqRingSize = m_CqRingSize = std::max(m_SqRingSize, m_CqRingSize);
+        }
+
+        m_SqRing = mmap(nullptr, m_SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (m_SqRing == MAP_FAILED)
+        {
+            m_SqRing = nullptr;
+            close(fd);
+            return;
+        }
+
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            m_CqRing = m_SqRing;
+        }
+        else
+        {
+            m_CqRing = mmap(nullptr, m_CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        }
+
+        m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        m_Sqes = mmap(nullptr, m_SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        m_WakeEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_CqRing == MAP_FAILED || m_Sqes == MAP_FAILED || m_WakeEvent == -1)
+        {
+            if (m_CqRing != MAP_FAILED && m_CqRing != m_SqRing)
+            {
+                munmap(m_CqRing, m_CqRingSize);
+            }
+            if (m_Sqes != MAP_FAILED)
+            {
+                munmap(m_Sqes, m_SqesSize);
+            }
+            if (m_WakeEvent != -1)
+            {
+                close(m_WakeEvent);
+                m_WakeEvent = -1;
+            }
+            munmap(m_SqRing, m_SqRingSize);
+            m_SqRing = m_CqRing = m_Sqes = nullptr;
+            close(fd);
+            return;
+        }
+
+        auto sq = (char*)m_SqRing;
+        m_SqHead = (unsigned*)(sq + params.sq_off.head);
+        m_SqTail = (unsigned*)(sq + params.sq_off.tail);
+        m_SqMask = *(unsigned*)(sq + params.sq_off.ring_mask);
+        m_SqArray = (unsigned*)(sq + params.sq_off.array);
+        m_SqEntries = params.sq_entries;
+
+        auto cq = (char*)m_CqRing;
+        m_CqHead = (unsigned*)(cq + params.cq_off.head);
+        m_CqTail = (unsigned*)(cq + params.cq_off.tail);
+        m_CqMask = *(unsigned*)(cq + params.cq_off.ring_mask);
+        m_Cqes = cq + params.cq_off.cqes;
+
+        m_Fd = fd;
+#endif
+    }
+
+    IoRing::~IoRing(
+        void
+    )
+    /*++
+      Closing the ring cancels anything still in flight,
+      their completions are dropped
+    --*/
+    {
+#ifdef __linux__
+        if (m_Fd != -1)
+        {
+            munmap(m_Sqes, m_SqesSize);
+            if (m_CqRing != m_SqRing)
+            {
+                munmap(m_CqRing, m_CqRingSize);
+            }
+            munmap(m_SqRing, m_SqRingSize);
+            close(m_WakeEvent);
+            close(m_Fd);
+        }
+#endif
+    }
+
+    IoRing::Request*
+    IoRing::NewRequest(
+        IoCompletion&& Completion
+    )
+    {
+        if (m_FreeRequests == nullptr)
+        {
+            m_Requests.push_back(std::make_unique<Request>());
+            m_FreeRequests = m_Requests.back().get();
+            m_FreeRequests->m_Next = nullptr;
+        }
+        auto request = m_FreeRequests;
+        m_FreeRequests = request->m_Next;
+        request->m_Completion = std::move(Completion);
+        return request;
+    }
+
+    void
+    IoRing::FreeRequest(
+        Request* ToFree
+    )
+    {
+        ToFree->m_Completion = nullptr;
+        ToFree->m_Next = m_FreeRequests;
+        m_FreeRequests = ToFree;
+    }
+
+    void
+    IoRing::Complete(
+        Request* Completed,
+        const int64_t Result
+    )
+    /*++
+      Hold a request completed without the ring until
+      the next Reap
+    --*/
+    {
+        Completed->m_Result = Result;
+        m_Completed.push_back(Completed);
+    }
+
+    void
+    IoRing::Queue(
+        const uint8_t Opcode,
+        const int Fd,
+        const void* Buffer,
+        const size_t Length,
+        const uint64_t Offset,
+        IoCompletion&& Completion
+    )
+    {
+        auto request = NewRequest(std::move(Completion));
+
+#ifdef __linux__
+        if (m_Fd != -1)
+        {
+            auto tail = *m_SqTail;
+            if (tail - LoadAcquire(m_SqHead) == m_SqEntries)
+            {
+                //
+                // The submission ring is full, hand what we
+                // have to the kernel to make space
+                //
+                Submit();
+            }
+
+            if (tail - LoadAcquire(m_SqHead) < m_SqEntries)
+            {
+                auto index = tail & m_SqMask;
+                auto sqe = &((io_uring_sqe*)m_Sqes)[index];
+                memset(sqe, 0, sizeof(*sqe));
+                sqe->opcode = Opcode;
+                sqe->fd = Fd;
+                sqe->addr = (uint64_t)Buffer;
+                sqe->len = (uint32_t)Length;
+                sqe->off = Offset;
+                sqe->user_data = (uint64_t)request;
+                m_SqArray[index] = index;
+                StoreRelease(m_SqTail, tail + 1);
+                m_Unsubmitted++;
+                m_InFlight++;
+                return;
+            }
+        }
+#endif
+
+        //
+        // No ring, or no room in it, do it now
+        //
+        ssize_t result = 0;
+        switch (Opcode)
+        {
+        case OP_READ:
+            result = pread(Fd, (void*)Buffer, Length, Offset);
+            break;
+        case OP_WRITE:
+            result = pwrite(Fd, Buffer, Length, Offset);
+            break;
+        case OP_FSYNC:
+            result = fsync(Fd);
+            break;
+        }
+        Complete(request, result < 0 ? -errno : result);
+    }
+
+    void
+    IoRing::Read(
+        const int Fd,
+        void* Buffer,
+        const size_t Length,
+        const uint64_t Offset,
+        IoCompletion Completion
+    )
+    {
+        Queue(OP_READ, Fd, Buffer, Length, Offset, std::move(Completion));
+    }
+
+    void
+    IoRing::Write(
+        const int Fd,
+        const void* Buffer,
+        const size_t Length,
+        const uint64_t Offset,
+        IoCompletion Completion
+    )
+    {
+        Queue(OP_WRITE, Fd, Buffer, Length, Offset, std::move(Completion));
+    }
+
+    void
+    IoRing::Fsync(
+        const int Fd,
+        IoCompletion Completion
+    )
+    {
+        Queue(OP_FSYNC, Fd, nullptr, 0, 0, std::move(Completion));
+    }
+
+    bool
+    IoRing::Submit(
+        void
+    )
+    /*++
+      Hand every queued request to the kernel in a single
+      io_uring_enter. Returns false if some remain queued
+    --*/
+    {
+#ifdef __linux__
+        while (m_Unsubmitted != 0)
+        {
+            auto submitted = syscall(__NR_io_uring_enter, m_Fd, m_Unsubmitted, 0, 0, nullptr, 0);
+            if (submitted < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            m_Unsubmitted -= submitted;
+        }
+#endif
+        return true;
+    }
+
+    size_t
+    IoRing::Reap(
+        RunQueue& Queue
+    )
+    /*++
+      Move every available completion onto Queue as a
+      job on our dispatcher, publishing the new completion
+      ring head once for the whole batch.
+      Returns the number of completions reaped
+    --*/
+    {
+        size_t reaped = m_Completed.size();
+        for (auto request : m_Completed)
+        {
+            Queue.Push(Job(
+                [completion = std::move(request->m_Completion), result = request->m_Result]{ completion(result); },
+                TaskPriority::PRIORITY_NORMAL,
+                m_Dispatcher
+            ));
+            FreeRequest(request);
+        }
+        m_Completed.clear();
+
+#ifdef __linux__
+        if (m_Fd != -1)
+        {
+            auto head = *m_CqHead;
+            auto tail = LoadAcquire(m_CqTail);
+            for (; head != tail; head++)
+            {
+                auto cqe = &((io_uring_cqe*)m_Cqes)[head & m_CqMask];
+                auto request = (Request*)cqe->user_data;
+                Queue.Push(Job(
+                    [completion = std::move(request->m_Completion), result = (int64_t)cqe->res]{ completion(result); },
+                    TaskPriority::PRIORITY_NORMAL,
+                    m_Dispatcher
+                ));
+                FreeRequest(request);
+                m_InFlight--;
+                reaped++;
+            }
+            StoreRelease(m_CqHead, head);
+        }
+#endif
+        return reaped;
+    }
+
+    bool
+    IoRing::Ready(
+        void
+    )
+    /*++
+      True if Reap would find completions
+    --*/
+    {
+        if (!m_Completed.empty())
+        {
+            return true;
+        }
+#ifdef __linux__
+        if (m_Fd != -1)
+        {
+            return *m_CqHead != LoadAcquire(m_CqTail);
+        }
+#endif
+        return false;
+    }
+
+    void
+    IoRing::Wait(
+        const timepoint Deadline
+    )
+    /*++
+      Block until a completion arrives, Wake() is called or
+      Deadline passes. Used in place of the condition
+      variable by a dispatcher with requests in flight
+    --*/
+    {
+#ifdef __linux__
+        assert(m_Fd != -1);
+        Submit();
+        if (Ready())
+        {
+            return;
+        }
+
+        pollfd fds[2] = {
+            { m_Fd, POLLIN, 0 },
+            { m_WakeEvent, POLLIN, 0 }
+        };
+        timespec timeout;
+        timespec* timeoutPtr = nullptr;
+        if (Deadline != dispatch::MAXTIME)
+        {
+            auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(Deadline - std::chrono::system_clock::now()).count();
+            if (remaining < 0)
+            {
+                remaining = 0;
+            }
+            timeout.tv_sec = remaining / 1000000000;
+            timeout.tv_nsec = remaining % 1000000000;
+            timeoutPtr = &timeout;
+        }
+        ppoll(fds, 2, timeoutPtr, nullptr);
+        if (fds[1].revents & POLLIN)
+        {
+            uint64_t value;
+            auto result = read(m_WakeEvent, &value, sizeof(value));
+            (void)result;
+        }
+#endif
+    }
+
+    void
+    IoRing::Wake(
+        void
+    )
+    /*++
+      Interrupt Wait() from any thread
+    --*/
+    {
+#ifdef __linux__
+        if (m_WakeEvent != -1)
+        {
+            uint64_t one = 1;
+            auto result = write(m_WakeEvent, &one, sizeof(one));
+            (void)result;
+        }
+#endif
+    }
+
+}
@@ -0,0 +1,310 @@
+#include <assert.h>
+
+#include <cstddef>
+#include <new>
+
+#include "DispatcherBase.hpp"
+#include "JobAllocator.hpp"
+
+namespace dispatch
+{
+    extern thread_local DispatcherBase* ThreadQueue;
+
+    //
+    // Marks the remote free list of an allocator whose
+    // dispatcher has gone away
+    //
+    static void* const ORPHANED = (void*)1;
+
+    JobNode*
+    AllocateJobNode(
+        Job&& ToWrap
+    )
+    /*++
+      Allocate a node from the current thread's dispatcher,
+      falling back to the heap on non-dispatcher threads
+    --*/
+    {
+        auto allocator = JobAllocator::Current();
+        if (allocator != nullptr)
+        {
+            return allocator->Allocate(std::move(ToWrap));
+        }
+        return new JobNode(std::move(ToWrap));
+    }
+
+    void
+    JobNodeDeleter::operator()(
+        JobNode* Node
+    ) const
+    {
+        JobAllocator::Free(Node);
+    }
+
+    //
+    // Every frame is prefixed with the allocator it came
+    // from, nullptr for the heap. The prefix keeps frames
+    // aligned for any type
+    //
+    struct alignas(std::max_align_t) FrameHeader
+    {
+        JobAllocator* m_Allocator;
+    };
+
+    void*
+    AllocateFrame(
+        const size_t Size
+    )
+    /*++
+      Allocate a coroutine frame from the current thread's
+      dispatcher if it fits in a frame slot, otherwise from
+      the heap
+    --*/
+    {
+        JobAllocator* allocator = nullptr;
+        void* memory;
+        if (ThreadQueue != nullptr && Size + sizeof(FrameHeader) <= FRAME_SLOT_SIZE)
+        {
+            allocator = ThreadQueue->GetFrameAllocator();
+            memory = allocator->AllocateRaw();
+        }
+        else
+        {
+            memory = ::operator new(Size + sizeof(FrameHeader));
+        }
+        auto header = (FrameHeader*)memory;
+        header->m_Allocator = allocator;
+        return header + 1;
+    }
+
+    void
+    FreeFrame(
+        void* Frame
+    )
+    {
+        auto header = (FrameHeader*)Frame - 1;
+        if (header->m_Allocator == nullptr)
+        {
+            ::operator delete(header);
+            return;
+        }
+        JobAllocator::FreeRaw(header, header->m_Allocator);
+    }
+
+    JobAllocator::JobAllocator(
+        const void* Owner,
+        const size_t SlotSize
+    ) : m_Owner(Owner),
+        m_SlotSize((SlotSize + alignof(JobNode) - 1) & ~(alignof(JobNode) - 1))
+    {
+    }
+
+    bool
+    JobAllocator::OnOwnerThread(
+        void
+    ) const
+    {
+        return ThreadQueue != nullptr && ThreadQueue == m_Owner;
+    }
+
+    JobAllocator*
+    JobAllocator::Current(
+        void
+    )
+    {
+        return ThreadQueue != nullptr ? ThreadQueue->GetAllocator() : nullptr;
+    }
+
+    JobAllocator::~JobAllocator(
+        void
+    )
+    {
+        for (auto slab : m_Slabs)
+        {
+            ::operator delete(slab, std::align_val_t(alignof(JobNode)));
+        }
+    }
+
+    void
+    JobAllocator::AllocateSlab(
+        void
+    )
+    /*++
+      Carve a new cache-aligned slab into the local free list
+    --*/
+    {
+        auto slab = (char*)::operator new(m_SlotSize * SLAB_NODES, std::align_val_t(alignof(JobNode)));
+        m_Slabs.push_back(slab);
+        m_Nodes.store(m_Slabs.size() * SLAB_NODES, std::memory_order_relaxed);
+        for (size_t i = SLAB_NODES; i-- > 0;)
+        {
+            FreeLocal(slab + i * m_SlotSize);
+        }
+    }
+
+    JobNode*
+    JobAllocator::Allocate(
+        Job&& ToWrap
+    )
+    /*++
+      Owner thread only
+    --*/
+    {
+        assert(m_SlotSize >= sizeof(JobNode));
+        return ::new (AllocateRaw()) JobNode(std::move(ToWrap), this);
+    }
+
+    void*
+    JobAllocator::AllocateRaw(
+        void
+    )
+    /*++
+      Owner thread only. Returns an uninitialised slot
+    --*/
+    {
+        assert(OnOwnerThread());
+        if (m_LocalFree == nullptr)
+        {
+            //
+            // Reclaim everything other threads have handed back
+            //
+            m_LocalFree = m_RemoteFree.exchange(nullptr, std::memory_order_acquire);
+        }
+
+        if (m_LocalFree != nullptr)
+        {
+            Bump(m_Hits);
+        }
+        else
+        {
+            Bump(m_Misses);
+            AllocateSlab();
+        }
+
+        auto memory = m_LocalFree;
+        m_LocalFree = memory->m_Next;
+        return memory;
+    }
+
+    void
+    JobAllocator::FreeLocal(
+        void* Memory
+    )
+    {
+        auto node = (FreeNode*)Memory;
+        node->m_Next = m_LocalFree;
+        m_LocalFree = node;
+    }
+
+    void
+    JobAllocator::FreeRemote(
+        void* Memory
+    )
+    /*++
+      Hand a node back from a thread other than the owner.
+      If the owner has released the allocator, count the
+      node off instead and delete the allocator with the last
+    --*/
+    {
+        auto node = (FreeNode*)Memory;
+        auto head = m_RemoteFree.load(std::memory_order_relaxed);
+        do
+        {
+            if (head == ORPHANED)
+            {
+                if (m_Outstanding.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    delete this;
+                }
+                return;
+            }
+            node->m_Next = head;
+        }
+        while (!m_RemoteFree.compare_exchange_weak(
+            head,
+            node,
+            std::memory_order_release,
+            std::memory_order_relaxed
+        ));
+        m_RemoteFrees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void
+    JobAllocator::Free(
+        JobNode* Node
+    )
+    {
+        auto allocator = Node->m_Allocator;
+        if (allocator == nullptr)
+        {
+            delete Node;
+            return;
+        }
+
+        Node->~JobNode();
+        FreeRaw(Node, allocator);
+    }
+
+    void
+    JobAllocator::FreeRaw(
+        void* Memory,
+        JobAllocator* Owner
+    )
+    /*++
+      Return a slot from AllocateRaw to Owner, from any thread
+    --*/
+    {
+        if (Owner->OnOwnerThread())
+        {
+            Owner->FreeLocal(Memory);
+        }
+        else
+        {
+            Owner->FreeRemote(Memory);
+        }
+    }
+
+    void
+    JobAllocator::Release(
+        void
+    )
+    /*++
+      Called when the owning dispatcher is destroyed. Any node
+      not on a free list is still in flight on another thread
+      and will be counted off by FreeRemote. Whichever side
+      brings the count to zero deletes the allocator
+    --*/
+    {
+        auto remote = m_RemoteFree.exchange((FreeNode*)ORPHANED, std::memory_order_acq_rel);
+        int64_t available = 0;
+        for (auto node = m_LocalFree; node != nullptr; node = node->m_Next)
+        {
+            available++;
+        }
+        for (auto node = remote; node != nullptr; node = node->m_Next)
+        {
+            available++;
+        }
+        m_LocalFree = nullptr;
+
+        int64_t outstanding = (int64_t)(m_Slabs.size() * SLAB_NODES) - available;
+        if (m_Outstanding.fetch_add(outstanding, std::memory_order_acq_rel) + outstanding == 0)
+        {
+            delete this;
+        }
+    }
+
+    JobAllocatorStatistics
+    JobAllocator::GetStatistics(
+        void
+    ) const
+    {
+        return JobAllocatorStatistics{
+            m_Hits.load(std::memory_order_relaxed),
+            m_Misses.load(std::memory_order_relaxed),
+            m_RemoteFrees.load(std::memory_order_relaxed),
+            m_Nodes.load(std::memory_order_relaxed)
+        };
+    }
+
+}
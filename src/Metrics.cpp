@@ -0,0 +1,197 @@
+#include <algorithm>
+
+#include "Metrics.hpp"
+
+namespace dispatch
+{
+
+    size_t
+    LatencyHistogram::Bucket(
+        const uint64_t Nanoseconds
+    )
+    {
+        if (Nanoseconds < LINEAR)
+        {
+            return (size_t)Nanoseconds;
+        }
+        size_t exponent = 63 - __builtin_clzll(Nanoseconds);
+        if (exponent > MAX_EXPONENT)
+        {
+            return BUCKETS - 1;
+        }
+        size_t sub = (Nanoseconds >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+        return LINEAR + (exponent - 4) * SUB_BUCKETS + sub;
+    }
+
+    uint64_t
+    LatencyHistogram::LowerBound(
+        const size_t Bucket
+    )
+    {
+        if (Bucket < LINEAR)
+        {
+            return Bucket;
+        }
+        size_t exponent = 4 + (Bucket - LINEAR) / SUB_BUCKETS;
+        uint64_t sub = (Bucket - LINEAR) % SUB_BUCKETS;
+        return (SUB_BUCKETS + sub) << (exponent - SUB_BITS);
+    }
+
+    void
+    LatencyHistogram::Merge(
+        const LatencyHistogram& Other
+    )
+    {
+        for (size_t i = 0; i < BUCKETS; i++)
+        {
+            m_Counts[i] += Other.m_Counts[i];
+        }
+    }
+
+    uint64_t
+    LatencyHistogram::Count(
+        void
+    ) const
+    {
+        uint64_t count = 0;
+        for (auto bucket : m_Counts)
+        {
+            count += bucket;
+        }
+        return count;
+    }
+
+    uint64_t
+    LatencyHistogram::Percentile(
+        const double Fraction
+    ) const
+    /*++
+      The upper bound of the bucket holding the given
+      fraction of samples, 0 if there are none
+    --*/
+    {
+        auto count = Count();
+        if (count == 0)
+        {
+            return 0;
+        }
+        auto target = std::min((uint64_t)(Fraction * (double)count), count - 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++)
+        {
+            seen += m_Counts[i];
+            if (seen > target)
+            {
+                return i + 1 < BUCKETS ? LowerBound(i + 1) : LowerBound(i);
+            }
+        }
+        return LowerBound(BUCKETS - 1);
+    }
+
+    LatencyHistogram
+    AtomicHistogram::Snapshot(
+        void
+    ) const
+    {
+        LatencyHistogram snapshot;
+        for (size_t i = 0; i < LatencyHistogram::BUCKETS; i++)
+        {
+            snapshot.m_Counts[i] = m_Counts[i].load(std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+
+    void
+    DispatcherMetrics::Merge(
+        const DispatcherMetrics& Other
+    )
+    /*++
+      Add Other into this, for aggregating pool workers
+    --*/
+    {
+        m_Dispatchers += Other.m_Dispatchers;
+        m_Posted += Other.m_Posted;
+        m_Run += Other.m_Run;
+        m_CrossThread += Other.m_CrossThread;
+        for (size_t i = 0; i < PRIORITY_LEVELS; i++)
+        {
+            m_Depth[i] += Other.m_Depth[i];
+            m_HighWater[i] = std::max(m_HighWater[i], Other.m_HighWater[i]);
+        }
+        m_Delayed += Other.m_Delayed;
+        m_Unclaimed += Other.m_Unclaimed;
+        m_IdleTime += Other.m_IdleTime;
+        m_BusyTime += Other.m_BusyTime;
+        m_QueueWait.Merge(Other.m_QueueWait);
+        m_RunTime.Merge(Other.m_RunTime);
+    }
+
+    void
+    MetricsBlock::Started(
+        void
+    )
+    {
+        m_Started.store(Now(), std::memory_order_relaxed);
+    }
+
+    void
+    MetricsBlock::Stopped(
+        void
+    )
+    /*++
+      Close the current run. Idle time is only ever added
+      while running, so the total of all runs less the
+      total idle is the time spent busy
+    --*/
+    {
+        auto started = m_Started.load(std::memory_order_relaxed);
+        m_Started.store(0, std::memory_order_relaxed);
+        if (started != 0)
+        {
+            Add(m_Elapsed, Now() - started);
+        }
+    }
+
+    void
+    MetricsBlock::Handled(
+        const uint64_t Count,
+        const int64_t Nanoseconds
+    )
+    /*++
+      Count handlers run straight from the loop rather than
+      posted, such as reactor handlers, as posted and run
+    --*/
+    {
+        Add(m_Posted, Count);
+        Add(m_Run, Count);
+        m_HandlerTime += Nanoseconds;
+    }
+
+    void
+    MetricsBlock::Fill(
+        DispatcherMetrics& Metrics
+    ) const
+    /*++
+      Copy the counters out. Busy time is however long the
+      loop has been running, over all of its runs, less the
+      time it spent idle
+    --*/
+    {
+        Metrics.m_Posted = m_Posted.load(std::memory_order_relaxed);
+        Metrics.m_CrossThread = m_CrossThread.load(std::memory_order_relaxed);
+        Metrics.m_Run = m_Run.load(std::memory_order_relaxed);
+
+        auto started = m_Started.load(std::memory_order_relaxed);
+        auto elapsed = m_Elapsed.load(std::memory_order_relaxed);
+        auto idle = m_Idle.load(std::memory_order_relaxed);
+        if (started != 0)
+        {
+            elapsed += Now() - started;
+        }
+        Metrics.m_BusyTime = std::chrono::nanoseconds(std::max<int64_t>(elapsed - idle, 0));
+        Metrics.m_IdleTime = std::chrono::nanoseconds(idle);
+        Metrics.m_QueueWait = m_QueueWait.Snapshot();
+        Metrics.m_RunTime = m_RunTime.Snapshot();
+    }
+
+}
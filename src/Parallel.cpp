@@ -0,0 +1,171 @@
+#include <assert.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Parallel.hpp"
+
+namespace dispatch
+{
+
+    //
+    // With no grain given, aim for this many chunks per
+    // participant so that uneven chunks still balance
+    //
+    static constexpr size_t CHUNKS_PER_PARTICIPANT = 8;
+
+    class ParallelLoop
+    /*++
+      The ranges of one ParallelForRanges call still to be
+      claimed. Every participant takes the oldest, and so
+      largest, range, splits off right halves for others
+      until it is down to the grain and then runs it.
+      Helpers hold a reference, so a helper that only gets
+      to run after the loop has finished finds nothing to
+      do rather than a dangling loop
+    --*/
+    {
+    public:
+        ParallelLoop(
+            const size_t Begin,
+            const size_t End,
+            const size_t Grain,
+            RangeFunction Body
+        ) : m_Body(Body),
+            m_Grain(Grain),
+            m_Remaining(End - Begin)
+        {
+            //
+            // Halving can leave up to twice as many chunks
+            // as a straight division by the grain
+            //
+            m_Ranges.reserve(2 * ((End - Begin + Grain - 1) / Grain));
+            m_Ranges.push_back({ Begin, End });
+        }
+
+        void
+        Participate(
+            void
+        )
+        {
+            while (m_Remaining.load(std::memory_order_acquire) != 0)
+            {
+                Range range;
+                if (!Claim(range))
+                {
+                    //
+                    // Everything is claimed, but splits may
+                    // still be pushed by whoever is working
+                    //
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                while (range.m_End - range.m_Begin > m_Grain)
+                {
+                    auto middle = range.m_Begin + (range.m_End - range.m_Begin) / 2;
+                    Push({ middle, range.m_End });
+                    range.m_End = middle;
+                }
+
+                m_Body(range.m_Begin, range.m_End);
+                m_Remaining.fetch_sub(range.m_End - range.m_Begin, std::memory_order_acq_rel);
+            }
+        }
+
+    private:
+        struct Range
+        {
+            size_t m_Begin;
+            size_t m_End;
+        };
+
+        bool
+        Claim(
+            Range& Claimed
+        )
+        {
+            std::lock_guard<std::mutex> guard(m_Lock);
+            if (m_Head == m_Ranges.size())
+            {
+                return false;
+            }
+            Claimed = m_Ranges[m_Head++];
+            return true;
+        }
+
+        void
+        Push(
+            const Range& Split
+        )
+        {
+            std::lock_guard<std::mutex> guard(m_Lock);
+            m_Ranges.push_back(Split);
+        }
+
+        RangeFunction m_Body;
+        const size_t m_Grain;
+        std::atomic<size_t> m_Remaining;
+        std::mutex m_Lock;
+        std::vector<Range> m_Ranges;
+        size_t m_Head = 0;
+    };
+
+    void
+    ParallelForRanges(
+        DispatchPool* Pool,
+        const size_t Begin,
+        const size_t End,
+        const size_t Grain,
+        RangeFunction Body
+    )
+    /*++
+      Call Body over chunks covering [Begin, End), using
+      the workers of Pool and the calling thread. The
+      caller takes part rather than blocking, and can
+      finish the loop alone if the workers are busy, so it
+      is safe to call from one of Pool's own workers
+    --*/
+    {
+        if (Begin >= End)
+        {
+            return;
+        }
+
+        auto count = End - Begin;
+        auto workers = Pool->GetWorkerCount();
+        auto grain = Grain;
+        if (grain == 0)
+        {
+            grain = std::max<size_t>(1, count / ((workers + 1) * CHUNKS_PER_PARTICIPANT));
+        }
+
+        auto chunks = (count + grain - 1) / grain;
+        if (chunks == 1)
+        {
+            Body(Begin, End);
+            return;
+        }
+
+        auto loop = std::make_shared<ParallelLoop>(Begin, End, grain, Body);
+        auto helpers = std::min(workers, chunks - 1);
+
+        //
+        // Posted as a batch, which is spread over the
+        // workers. Single posts from a worker would stay on
+        // it and only join once we had finished
+        //
+        TaskBatch batch;
+        for (size_t helper = 0; helper < helpers; helper++)
+        {
+            batch.push_back([loop]{ loop->Participate(); });
+        }
+        Pool->PostTasks(std::move(batch));
+        loop->Participate();
+    }
+
+}
@@ -0,0 +1,341 @@
+#ifdef __linux__
+
+#include <assert.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <chrono>
+
+#include "ReactorDispatcher.hpp"
+
+namespace dispatch
+{
+
+    //
+    // Epoll tokens pack the descriptor with the generation
+    // of its watch so that events for a descriptor that
+    // was unwatched, and maybe reused, in the same batch
+    // are dropped. Generation 0 marks our internal fds
+    //
+    static inline uint64_t
+    MakeToken(
+        const int Fd,
+        const uint32_t Generation
+    )
+    {
+        return ((uint64_t)Generation << 32) | (uint32_t)Fd;
+    }
+
+    ReactorDispatcher::ReactorDispatcher(
+        const std::string& Name
+    ) : Dispatcher::Dispatcher(Name)
+    {
+        m_Epoll = epoll_create1(EPOLL_CLOEXEC);
+        m_WakeEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        m_Timer = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+        assert(m_Epoll != -1 && m_WakeEvent != -1 && m_Timer != -1);
+
+        for (auto fd : { m_WakeEvent, m_Timer })
+        {
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.u64 = MakeToken(fd, 0);
+            auto result = epoll_ctl(m_Epoll, EPOLL_CTL_ADD, fd, &event);
+            assert(result == 0);
+            (void)result;
+        }
+
+        //
+        // Spinning would mean a syscall per poll, park
+        // in epoll_wait straight away by default
+        //
+        SetIdlePolicy(IdlePolicy::BLOCK);
+    }
+
+    ReactorDispatcher::~ReactorDispatcher(
+        void
+    )
+    {
+        //
+        // Join before closing the descriptors the
+        // dispatch loop may still be waiting on
+        //
+        Wait();
+        close(m_Timer);
+        close(m_WakeEvent);
+        close(m_Epoll);
+    }
+
+    bool
+    ReactorDispatcher::WatchFd(
+        const int Fd,
+        const uint32_t Events,
+        FdHandler Handler
+    )
+    /*++
+      Call Handler on this dispatcher whenever any of the
+      EPOLL* Events are ready on Fd. Watching an Fd again
+      replaces its events and handler. From another thread
+      the watch is posted to the dispatcher, and failures
+      are only reported when called on the dispatcher
+    --*/
+    {
+        if (OnNativeThread())
+        {
+            return WatchFdInternal(Fd, Events, std::move(Handler));
+        }
+        PostTask(
+            [this, Fd, Events, Handler = std::move(Handler)]() mutable {
+                WatchFdInternal(Fd, Events, std::move(Handler));
+            }
+        );
+        return true;
+    }
+
+    void
+    ReactorDispatcher::UnwatchFd(
+        const int Fd
+    )
+    /*++
+      Stop watching Fd. Once this has run on the dispatcher
+      the handler will not be called again, even for events
+      already collected in the current batch
+    --*/
+    {
+        if (OnNativeThread())
+        {
+            UnwatchFdInternal(Fd);
+            return;
+        }
+        PostTask(
+            [this, Fd]{
+                UnwatchFdInternal(Fd);
+            }
+        );
+    }
+
+    bool
+    ReactorDispatcher::WatchFdInternal(
+        const int Fd,
+        const uint32_t Events,
+        FdHandler Handler
+    )
+    {
+        assert(OnNativeThread());
+        if (++m_Generation == 0)
+        {
+            m_Generation = 1;
+        }
+
+        epoll_event event = {};
+        event.events = Events;
+        event.data.u64 = MakeToken(Fd, m_Generation);
+        auto operation = m_Watchers.contains(Fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+        if (epoll_ctl(m_Epoll, operation, Fd, &event) != 0)
+        {
+            return false;
+        }
+        m_Watchers[Fd] = Watcher{ m_Generation, std::move(Handler) };
+        return true;
+    }
+
+    void
+    ReactorDispatcher::UnwatchFdInternal(
+        const int Fd
+    )
+    {
+        assert(OnNativeThread());
+        if (m_Watchers.erase(Fd) == 0)
+        {
+            return;
+        }
+
+        //
+        // This fails if Fd has already been closed, which
+        // removed it from the epoll set anyway
+        //
+        epoll_ctl(m_Epoll, EPOLL_CTL_DEL, Fd, nullptr);
+    }
+
+    void
+    ReactorDispatcher::ArmTimer(
+        void
+    )
+    /*++
+      Point the timerfd at the next delayed task, only
+      touching it when that has changed
+    --*/
+    {
+        auto deadline = m_DelayedQueue.Empty() ? dispatch::MAXTIME : m_NextDelayedTask;
+        if (deadline == m_TimerDeadline)
+        {
+            return;
+        }
+        m_TimerDeadline = deadline;
+
+        itimerspec spec = {};
+        if (deadline != dispatch::MAXTIME)
+        {
+            auto since = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+            spec.it_value.tv_sec = since / 1000000000;
+            spec.it_value.tv_nsec = since % 1000000000;
+
+            //
+            // A zero it_value disarms the timer
+            //
+            if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0)
+            {
+                spec.it_value.tv_nsec = 1;
+            }
+        }
+        timerfd_settime(m_Timer, TFD_TIMER_ABSTIME, &spec, nullptr);
+    }
+
+    size_t
+    ReactorDispatcher::Poll(
+        const int Timeout
+    )
+    /*++
+      Wait up to Timeout milliseconds for events and run
+      the handlers of any that are ready.
+      Returns the number of handlers run
+    --*/
+    {
+        epoll_event events[MAX_EVENTS];
+        auto count = epoll_wait(m_Epoll, events, MAX_EVENTS, Timeout);
+        if (count <= 0)
+        {
+            return 0;
+        }
+
+#ifndef DISPATCH_NO_METRICS
+        auto start = MetricsBlock::Now();
+#endif
+        size_t handled = 0;
+        for (int i = 0; i < count; i++)
+        {
+            auto fd = (int)(uint32_t)events[i].data.u64;
+            auto generation = (uint32_t)(events[i].data.u64 >> 32);
+            if (generation == 0)
+            {
+                //
+                // Our own eventfd or timerfd, reset it. The
+                // loop checks the inbox, delayed queue and
+                // I/O ring
+                //
+                if (fd != m_WakeEvent && fd != m_Timer)
+                {
+                    continue;
+                }
+                uint64_t value;
+                auto result = read(fd, &value, sizeof(value));
+                (void)result;
+                if (fd == m_Timer)
+                {
+                    m_TimerDeadline = dispatch::MAXTIME;
+                }
+                continue;
+            }
+
+            auto watcher = m_Watchers.find(fd);
+            if (watcher == m_Watchers.end() || watcher->second.m_Generation != generation)
+            {
+                continue;
+            }
+
+            //
+            // The handler may unwatch or rewatch its own fd,
+            // so run it off the map and only put it back if
+            // the watch is unchanged afterwards
+            //
+            auto handler = std::move(watcher->second.m_Handler);
+            handler(fd, events[i].events);
+            handled++;
+
+            watcher = m_Watchers.find(fd);
+            if (watcher != m_Watchers.end() && watcher->second.m_Generation == generation)
+            {
+                watcher->second.m_Handler = std::move(handler);
+            }
+        }
+#ifndef DISPATCH_NO_METRICS
+        if (handled != 0)
+        {
+            Handled(handled, MetricsBlock::Now() - start);
+        }
+#endif
+        return handled;
+    }
+
+    bool
+    ReactorDispatcher::PollEvents(
+        void
+    )
+    /*++
+      Run handlers for descriptors that are already ready
+      without blocking
+    --*/
+    {
+        if (m_Watchers.empty())
+        {
+            return false;
+        }
+        return Poll(0) > 0;
+    }
+
+    void
+    ReactorDispatcher::Block(
+        void
+    )
+    /*++
+      Park in epoll_wait until a descriptor is ready, a
+      cross-thread post signals the eventfd or the timerfd
+      fires for the next delayed task
+    --*/
+    {
+        //
+        // The ring fd polls readable while completions are
+        // waiting to be reaped
+        //
+        auto ring = m_IoRing.load(std::memory_order_relaxed);
+        if (ring != nullptr && ring->Available())
+        {
+            ring->Submit();
+            if (!m_RingWatched)
+            {
+                epoll_event event = {};
+                event.events = EPOLLIN;
+                event.data.u64 = MakeToken(ring->GetFd(), 0);
+                epoll_ctl(m_Epoll, EPOLL_CTL_ADD, ring->GetFd(), &event);
+                m_RingWatched = true;
+            }
+            if (ring->Ready())
+            {
+                return;
+            }
+        }
+
+        if (!m_CrossThread.Empty() || ExternalWorkPending())
+        {
+            return;
+        }
+        ArmTimer();
+        Poll(-1);
+    }
+
+    void
+    ReactorDispatcher::Notify(
+        void
+    )
+    {
+        uint64_t one = 1;
+        auto result = write(m_WakeEvent, &one, sizeof(one));
+        (void)result;
+    }
+
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include <assert.h>
+
+#include "RunQueue.hpp"
+
+namespace dispatch
+{
+
+    size_t
+    RunQueue::Lane(
+        const TaskPriority Priority
+    )
+    /*++
+      Map a priority onto its lane index. Lower
+      indices are drained first
+    --*/
+    {
+        size_t lane = (size_t)Priority - (size_t)TaskPriority::PRIORITY_HIGH;
+        assert(lane < PRIORITY_LEVELS);
+        return lane;
+    }
+
+    void
+    RunQueue::Grew(
+        const size_t Lane
+    )
+    /*++
+      Account for a job added to Lane. Only this thread
+      writes the counts, so no read-modify-write is needed
+    --*/
+    {
+        m_Size.store(m_Size.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+#ifndef DISPATCH_NO_METRICS
+        auto depth = m_Depth[Lane].load(std::memory_order_relaxed) + 1;
+        m_Depth[Lane].store(depth, std::memory_order_relaxed);
+        if (depth > m_HighWater[Lane].load(std::memory_order_relaxed))
+        {
+            m_HighWater[Lane].store(depth, std::memory_order_relaxed);
+        }
+#endif
+    }
+
+    void
+    RunQueue::Shrank(
+        const size_t Lane
+    )
+    {
+        m_Size.store(m_Size.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+#ifndef DISPATCH_NO_METRICS
+        m_Depth[Lane].store(m_Depth[Lane].load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+#endif
+    }
+
+    void
+    RunQueue::Push(
+        Job&& ToPush
+    )
+    /*++
+      Append a job to the back of its priority lane
+    --*/
+    {
+        auto lane = Lane(ToPush.GetPriority());
+        m_Lanes[lane].PushBack(std::move(ToPush));
+        Grew(lane);
+    }
+
+    void
+    RunQueue::PushFront(
+        Job&& ToPush
+    )
+    /*++
+      Insert a job at the front of its priority lane
+      so that it runs before any other job of the same
+      priority. Used when promoting expired delayed tasks
+    --*/
+    {
+        auto lane = Lane(ToPush.GetPriority());
+        m_Lanes[lane].PushFront(std::move(ToPush));
+        Grew(lane);
+    }
+
+    Job
+    RunQueue::Pop(
+        void
+    )
+    /*++
+      Remove and return the oldest job from the
+      highest priority non-empty lane
+    --*/
+    {
+        assert(Size() > 0);
+        for (size_t lane = 0; lane < PRIORITY_LEVELS; lane++)
+        {
+            if (!m_Lanes[lane].Empty())
+            {
+                Shrank(lane);
+                return m_Lanes[lane].PopFront();
+            }
+        }
+        assert(false);
+        __builtin_unreachable();
+    }
+
+    void
+    RunQueue::Clear(
+        void
+    )
+    {
+        for (size_t lane = 0; lane < PRIORITY_LEVELS; lane++)
+        {
+            m_Lanes[lane].Clear();
+#ifndef DISPATCH_NO_METRICS
+            m_Depth[lane].store(0, std::memory_order_relaxed);
+#endif
+        }
+        m_Size.store(0, std::memory_order_relaxed);
+    }
+
+}
@@ -0,0 +1,196 @@
+#include <assert.h>
+
+#include "TaskGraph.hpp"
+
+namespace dispatch
+{
+    extern thread_local DispatcherBase* ThreadQueue;
+    extern thread_local DispatcherBase* ThreadDispatcher;
+
+    static constexpr TaskGraph::NodeId NO_NODE = SIZE_MAX;
+
+    TaskGraph::~TaskGraph(
+        void
+    )
+    {
+        Wait();
+    }
+
+    TaskGraph::NodeId
+    TaskGraph::AddNode(
+        UniqueCallable Work
+    )
+    {
+        assert(!Running());
+        m_Nodes.emplace_back(std::move(Work));
+        return m_Nodes.size() - 1;
+    }
+
+    void
+    TaskGraph::AddEdge(
+        const NodeId Before,
+        const NodeId After
+    )
+    /*++
+      After may only start once Before has finished. The
+      edges must not form a cycle
+    --*/
+    {
+        assert(!Running());
+        assert(Before < m_Nodes.size() && After < m_Nodes.size() && Before != After);
+        m_Nodes[Before].m_Successors.push_back(After);
+        m_Nodes[After].m_Dependencies++;
+    }
+
+    void
+    TaskGraph::Run(
+        DispatchPool* Pool,
+        UniqueCallable OnComplete
+    )
+    /*++
+      Start a run of the graph on Pool. OnComplete is
+      posted to the calling dispatcher once every node has
+      finished, or run on the last worker if we are not on
+      a dispatcher. The graph must not be changed, or run
+      again, until then
+    --*/
+    {
+        assert(!Running());
+        if (m_Nodes.empty())
+        {
+            if (OnComplete)
+            {
+                OnComplete();
+            }
+            return;
+        }
+
+        m_Pool = Pool;
+        m_OnComplete = std::move(OnComplete);
+        m_ReplyTo = ThreadQueue;
+        for (auto& node : m_Nodes)
+        {
+            node.m_Pending.store(node.m_Dependencies, std::memory_order_relaxed);
+        }
+        m_Remaining.store(m_Nodes.size(), std::memory_order_relaxed);
+        m_Running->store(true, std::memory_order_release);
+
+        for (NodeId root = 0; root < m_Nodes.size(); root++)
+        {
+            if (m_Nodes[root].m_Dependencies == 0)
+            {
+                Post(root);
+            }
+        }
+    }
+
+    void
+    TaskGraph::Wait(
+        void
+    )
+    /*++
+      Block until the current run, if any, has finished.
+      Never call this from a worker of the pool running it
+    --*/
+    {
+        while (m_Running->load(std::memory_order_acquire))
+        {
+            m_Running->wait(true, std::memory_order_acquire);
+        }
+    }
+
+    void
+    TaskGraph::Post(
+        const NodeId Ready
+    )
+    /*++
+      Queue a node whose dependencies have all finished.
+      From one of the pool's workers it stays on that
+      worker, on its deque in work-stealing mode where idle
+      siblings can still take it
+    --*/
+    {
+        auto task = [this, Ready]{ Execute(Ready); };
+        if (m_Pool->GetMode() == PoolMode::ROUND_ROBIN && ThreadDispatcher == m_Pool)
+        {
+            ThreadQueue->PostTask(task);
+            return;
+        }
+        m_Pool->PostTask(task);
+    }
+
+    void
+    TaskGraph::Execute(
+        NodeId Ready
+    )
+    /*++
+      Run a node, then release its successors. The first
+      successor to become ready runs next on this thread
+      while the rest are queued
+    --*/
+    {
+        while (Ready != NO_NODE)
+        {
+            auto& node = m_Nodes[Ready];
+            node.m_Work();
+
+            Ready = NO_NODE;
+            for (auto successor : node.m_Successors)
+            {
+                if (m_Nodes[successor].m_Pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                {
+                    continue;
+                }
+                if (Ready == NO_NODE)
+                {
+                    Ready = successor;
+                }
+                else
+                {
+                    Post(successor);
+                }
+            }
+
+            //
+            // A successor we hold back keeps the count above
+            // zero, so only a node with none can be the last
+            //
+            if (m_Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                Finish();
+                return;
+            }
+        }
+    }
+
+    void
+    TaskGraph::Finish(
+        void
+    )
+    /*++
+      Called on the worker that ran the last node. Once
+      m_Running is clear the graph may be rerun or
+      destroyed, so take what we need first, the flag
+      included, and touch nothing of ours after
+    --*/
+    {
+        auto onComplete = std::move(m_OnComplete);
+        auto replyTo = m_ReplyTo;
+        auto running = m_Running;
+        running->store(false, std::memory_order_release);
+        running->notify_all();
+        if (!onComplete)
+        {
+            return;
+        }
+        if (replyTo != nullptr)
+        {
+            replyTo->PostTask(std::move(onComplete));
+        }
+        else
+        {
+            onComplete();
+        }
+    }
+
+}
@@ -0,0 +1,228 @@
+#include <assert.h>
+
+#include <algorithm>
+
+#include "TimerWheel.hpp"
+
+namespace dispatch
+{
+
+    static constexpr uint64_t MAX_TICK = (1ull << (TimerWheel::LEVELS * TimerWheel::SLOT_BITS)) - 1;
+
+    TimerWheel::TimerWheel(
+        void
+    ) : m_Start(std::chrono::system_clock::now())
+    {
+    }
+
+    uint64_t
+    TimerWheel::FloorTick(
+        const timepoint Time
+    ) const
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Time - m_Start).count();
+        if (elapsed <= 0)
+        {
+            return 0;
+        }
+        return std::min<uint64_t>(elapsed / RESOLUTION.count(), MAX_TICK);
+    }
+
+    uint64_t
+    TimerWheel::CeilTick(
+        const timepoint Time
+    ) const
+    /*++
+      Round up so that a job is never considered due
+      before its dispatch time
+    --*/
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Time - m_Start).count();
+        if (elapsed <= 0)
+        {
+            return 0;
+        }
+        return std::min<uint64_t>((elapsed + RESOLUTION.count() - 1) / RESOLUTION.count(), MAX_TICK);
+    }
+
+    timepoint
+    TimerWheel::TickTime(
+        const uint64_t Tick
+    ) const
+    {
+        return m_Start + std::chrono::duration_cast<timepoint::duration>(RESOLUTION * Tick);
+    }
+
+    void
+    TimerWheel::Place(
+        Job&& ToPlace
+    )
+    /*++
+      Put a job into the slot matching its tick relative to
+      the current tick. A job stored at level L shares every
+      bit above level L with m_Current, so it only needs to
+      move when m_Current enters its level L slot
+    --*/
+    {
+        uint64_t tick = CeilTick(ToPlace.GetDispatchTime());
+        if (tick <= m_Current)
+        {
+            m_Due.push_back(std::move(ToPlace));
+            return;
+        }
+
+        size_t level = (63 - __builtin_clzll(tick ^ m_Current)) / SLOT_BITS;
+        size_t slot = (tick >> (level * SLOT_BITS)) & (SLOTS - 1);
+        assert(level < LEVELS);
+        m_Slots[level][slot].push_back(std::move(ToPlace));
+        m_Occupied[level] |= 1ull << slot;
+    }
+
+    void
+    TimerWheel::Insert(
+        Job&& ToInsert
+    )
+    {
+        assert(ToInsert.IsDelayed());
+        Place(std::move(ToInsert));
+        m_Size.store(m_Size.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void
+    TimerWheel::DrainSlot(
+        const size_t Level,
+        const size_t Slot,
+        std::vector<Job>& Destination
+    )
+    {
+        auto& slot = m_Slots[Level][Slot];
+        for (auto& job : slot)
+        {
+            Destination.push_back(std::move(job));
+        }
+        slot.clear();
+        m_Occupied[Level] &= ~(1ull << Slot);
+    }
+
+    void
+    TimerWheel::Advance(
+        const uint64_t Tick
+    )
+    /*++
+      Move the wheel forward to Tick in a single step.
+      Every slot that ends before Tick is due, the slot
+      containing Tick at each level is cascaded downwards
+      and everything else is already correctly placed
+    --*/
+    {
+        if (Tick <= m_Current)
+        {
+            return;
+        }
+
+        for (size_t level = LEVELS; level-- > 0;)
+        {
+            uint64_t occupied = m_Occupied[level];
+            if (occupied == 0)
+            {
+                continue;
+            }
+
+            size_t shift = level * SLOT_BITS;
+            if ((Tick >> (shift + SLOT_BITS)) != (m_Current >> (shift + SLOT_BITS)))
+            {
+                //
+                // Tick has left this level's frame entirely
+                //
+                while (occupied != 0)
+                {
+                    DrainSlot(level, __builtin_ctzll(occupied), m_Due);
+                    occupied &= occupied - 1;
+                }
+                continue;
+            }
+
+            size_t index = (Tick >> shift) & (SLOTS - 1);
+            uint64_t expired = occupied & ((1ull << index) - 1);
+            while (expired != 0)
+            {
+                DrainSlot(level, __builtin_ctzll(expired), m_Due);
+                expired &= expired - 1;
+            }
+
+            if (occupied & (1ull << index))
+            {
+                DrainSlot(level, index, level == 0 ? m_Due : m_Cascade);
+            }
+        }
+
+        m_Current = Tick;
+        for (auto& job : m_Cascade)
+        {
+            Place(std::move(job));
+        }
+        m_Cascade.clear();
+    }
+
+    size_t
+    TimerWheel::Expire(
+        const timepoint Now,
+        RunQueue& Queue
+    )
+    /*++
+      Move every job that is due at Now onto the front of
+      the run queue, earliest dispatch time first
+    --*/
+    {
+        Advance(FloorTick(Now));
+
+        size_t count = m_Due.size();
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        std::stable_sort(m_Due.begin(), m_Due.end(), [](const Job& a, const Job& b){
+            return a.GetDispatchTime() < b.GetDispatchTime();
+        });
+        for (size_t i = count; i-- > 0;)
+        {
+            Queue.PushFront(std::move(m_Due[i]));
+        }
+        m_Due.clear();
+        m_Size.store(m_Size.load(std::memory_order_relaxed) - count, std::memory_order_relaxed);
+        return count;
+    }
+
+    timepoint
+    TimerWheel::NextExpiry(
+        void
+    ) const
+    /*++
+      Returns the earliest time at which the wheel needs
+      attention. For the lowest occupied level this is the
+      start of its first occupied slot; above level zero
+      that is a lower bound at which the slot gets cascaded
+    --*/
+    {
+        if (!m_Due.empty())
+        {
+            return TickTime(m_Current);
+        }
+
+        for (size_t level = 0; level < LEVELS; level++)
+        {
+            if (m_Occupied[level] == 0)
+            {
+                continue;
+            }
+            size_t shift = level * SLOT_BITS;
+            uint64_t frame = (m_Current >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+            uint64_t slot = __builtin_ctzll(m_Occupied[level]);
+            return TickTime(frame | (slot << shift));
+        }
+
+        return MAXTIME;
+    }
+
+}
@@ -0,0 +1,227 @@
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+#include <ctype.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include "Topology.hpp"
+
+namespace dispatch
+{
+
+    static std::string
+    ReadLine(
+        const std::string& Path
+    )
+    {
+        std::ifstream file(Path);
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+
+    static CpuSet
+    Intersect(
+        const CpuSet& Lhs,
+        const CpuSet& Rhs
+    )
+    {
+        CpuSet both;
+        std::set_intersection(Lhs.begin(), Lhs.end(), Rhs.begin(), Rhs.end(), std::back_inserter(both));
+        return both;
+    }
+
+    CpuSet
+    ParseCpuList(
+        const std::string& List
+    )
+    /*++
+      Parse a kernel cpulist such as "0-3,8,10-11" as
+      found under /sys/devices/system
+    --*/
+    {
+        CpuSet cpus;
+        size_t position = 0;
+        while (position < List.size())
+        {
+            auto comma = List.find(',', position);
+            if (comma == std::string::npos)
+            {
+                comma = List.size();
+            }
+            auto item = List.substr(position, comma - position);
+            position = comma + 1;
+            if (item.empty() || !isdigit((unsigned char)item[0]))
+            {
+                continue;
+            }
+
+            char* end;
+            int first = (int)strtol(item.c_str(), &end, 10);
+            int last = first;
+            if (*end == '-')
+            {
+                last = (int)strtol(end + 1, nullptr, 10);
+            }
+            for (int cpu = first; cpu <= last; cpu++)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        return cpus;
+    }
+
+    std::string
+    FormatCpuList(
+        const CpuSet& Cpus
+    )
+    /*++
+      The inverse of ParseCpuList
+    --*/
+    {
+        std::string list;
+        for (size_t i = 0; i < Cpus.size();)
+        {
+            size_t run = i;
+            while (run + 1 < Cpus.size() && Cpus[run + 1] == Cpus[run] + 1)
+            {
+                run++;
+            }
+            if (!list.empty())
+            {
+                list += ',';
+            }
+            list += std::to_string(Cpus[i]);
+            if (run != i)
+            {
+                list += '-' + std::to_string(Cpus[run]);
+            }
+            i = run + 1;
+        }
+        return list;
+    }
+
+    CpuSet
+    OnlineCpus(
+        void
+    )
+    /*++
+      The online CPUs this process may run on
+    --*/
+    {
+        auto online = ParseCpuList(ReadLine("/sys/devices/system/cpu/online"));
+        auto allowed = GetThreadAffinity();
+        if (online.empty())
+        {
+            return allowed;
+        }
+        auto usable = Intersect(online, allowed);
+        return usable.empty() ? online : usable;
+    }
+
+    std::vector<NumaNode>
+    NumaNodes(
+        void
+    )
+    /*++
+      The NUMA nodes with CPUs this process may run on.
+      Without NUMA information everything is node 0
+    --*/
+    {
+        std::vector<NumaNode> nodes;
+        auto usable = OnlineCpus();
+#ifdef __linux__
+        auto directory = opendir("/sys/devices/system/node");
+        if (directory != nullptr)
+        {
+            dirent* entry;
+            while ((entry = readdir(directory)) != nullptr)
+            {
+                std::string name = entry->d_name;
+                if (name.size() <= 4 || name.compare(0, 4, "node") != 0 || !isdigit((unsigned char)name[4]))
+                {
+                    continue;
+                }
+                auto cpus = Intersect(ParseCpuList(ReadLine("/sys/devices/system/node/" + name + "/cpulist")), usable);
+                if (!cpus.empty())
+                {
+                    nodes.push_back(NumaNode{ atoi(name.c_str() + 4), cpus });
+                }
+            }
+            closedir(directory);
+        }
+#endif
+        if (nodes.empty())
+        {
+            nodes.push_back(NumaNode{ 0, usable });
+        }
+        std::sort(nodes.begin(), nodes.end(), [](const NumaNode& Lhs, const NumaNode& Rhs) { return Lhs.m_Id < Rhs.m_Id; });
+        return nodes;
+    }
+
+    CpuSet
+    GetThreadAffinity(
+        void
+    )
+    /*++
+      The CPUs the calling thread may run on
+    --*/
+    {
+        CpuSet cpus;
+#ifdef __linux__
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        if (sched_getaffinity(0, sizeof(mask), &mask) == 0)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            {
+                if (CPU_ISSET(cpu, &mask))
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+            return cpus;
+        }
+#endif
+        for (int cpu = 0; cpu < (int)std::thread::hardware_concurrency(); cpu++)
+        {
+            cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+
+    bool
+    SetThreadAffinity(
+        const CpuSet& Cpus
+    )
+    /*++
+      Restrict the calling thread to Cpus. Returns false if
+      that is not possible here
+    --*/
+    {
+#ifdef __linux__
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        for (auto cpu : Cpus)
+        {
+            if (cpu >= 0 && cpu < CPU_SETSIZE)
+            {
+                CPU_SET(cpu, &mask);
+            }
+        }
+        return !Cpus.empty() && sched_setaffinity(0, sizeof(mask), &mask) == 0;
+#else
+        return false;
+#endif
+    }
+
+}
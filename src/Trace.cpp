@@ -0,0 +1,409 @@
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "DispatcherBase.hpp"
+#include "Trace.hpp"
+
+namespace dispatch
+{
+
+    extern thread_local DispatcherBase* ThreadQueue;
+
+    std::atomic<bool> g_Tracing = false;
+
+    enum class TraceKind : uint64_t
+    {
+        POST,
+        START,
+        END,
+        REPLY
+    };
+
+    struct TraceEvent
+    /*++
+      One slot of a TraceBuffer. m_Sequence is a seqlock so
+      a dump can tell a finished event from one that is
+      being overwritten underneath it
+    --*/
+    {
+        std::atomic<uint64_t> m_Sequence = 0;
+        std::atomic<uint64_t> m_Time = 0;
+        std::atomic<uint64_t> m_Kind = 0;
+        std::atomic<uint64_t> m_Id = 0;
+        std::atomic<uint64_t> m_Link = 0;
+    };
+
+    class TraceBuffer
+    /*++
+      The events recorded on one thread. Only that thread
+      writes, so recording takes no lock and no atomic
+      read-modify-write. Buffers are never freed, so a dump
+      still sees threads that have exited. Only once all a
+      buffer holds has been dumped may another thread take
+      it over
+    --*/
+    {
+    public:
+        TraceBuffer(const uint64_t ThreadId, const std::string& Name) :
+            m_ThreadId(ThreadId),
+            m_Name(Name),
+            m_Events(new TraceEvent[TRACE_BUFFER_EVENTS]) {};
+
+        const std::string& GetName(void) const { return m_Name; };
+
+        bool
+        Dumped(
+            void
+        ) const
+        /*++
+          True if every event recorded since tracing started
+          has been written out. Called with g_TraceMutex held
+          once the owning thread has exited
+        --*/
+        {
+            return m_Head.load(std::memory_order_acquire) <= std::max(m_Floor.load(std::memory_order_relaxed), m_Dumped);
+        }
+
+        void
+        Rename(
+            const uint64_t ThreadId,
+            const std::string& Name
+        )
+        /*++
+          Hand a dumped buffer to a different thread, under a
+          thread id of its own. Called with g_TraceMutex held
+        --*/
+        {
+            m_ThreadId = ThreadId;
+            m_Name = Name;
+            Reset();
+        }
+
+        void
+        Record(
+            const TraceKind Kind,
+            const uint64_t Id,
+            const uint64_t Link
+        )
+        {
+            auto position = m_Head.load(std::memory_order_relaxed);
+            auto& event = m_Events[position & (TRACE_BUFFER_EVENTS - 1)];
+            event.m_Sequence.store(position * 2 + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            event.m_Time.store(Now(), std::memory_order_relaxed);
+            event.m_Kind.store((uint64_t)Kind, std::memory_order_relaxed);
+            event.m_Id.store(Id, std::memory_order_relaxed);
+            event.m_Link.store(Link, std::memory_order_relaxed);
+            event.m_Sequence.store(position * 2 + 2, std::memory_order_release);
+            m_Head.store(position + 1, std::memory_order_release);
+        }
+
+        uint64_t
+        NextId(
+            void
+        )
+        /*++
+          Ids are unique across threads without sharing a
+          counter: the buffer's thread id sits above a local
+          count
+        --*/
+        {
+            return (m_ThreadId << 40) | ++m_LastId;
+        }
+
+        void
+        Reset(
+            void
+        )
+        {
+            m_Floor.store(m_Head.load(std::memory_order_acquire), std::memory_order_relaxed);
+        }
+
+        void Write(FILE* File, bool& First);
+
+        static uint64_t
+        Now(
+            void
+        )
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+    private:
+        uint64_t m_ThreadId;
+        std::string m_Name;
+        std::unique_ptr<TraceEvent[]> m_Events;
+        std::atomic<uint64_t> m_Head = 0;
+        std::atomic<uint64_t> m_Floor = 0;
+        uint64_t m_LastId = 0;
+        uint64_t m_Dumped = 0;
+    };
+
+    static std::mutex g_TraceMutex;
+    static std::vector<std::unique_ptr<TraceBuffer>> g_TraceBuffers;
+    static uint64_t g_LastThreadId = 0;
+    //
+    // Never destroyed, threads still exiting after main
+    // returns hand their buffers back to it
+    //
+    static std::vector<TraceBuffer*>& g_FreeTraceBuffers = *new std::vector<TraceBuffer*>();
+    thread_local TraceBuffer* ThreadTrace = nullptr;
+
+    struct TraceLease
+    /*++
+      Gives the thread's buffer back when the thread exits,
+      so that threads coming and going, such as the workers
+      of an elastic pool, do not each leave one behind
+    --*/
+    {
+        ~TraceLease(
+            void
+        )
+        {
+            if (m_Buffer != nullptr)
+            {
+                std::lock_guard<std::mutex> guard(g_TraceMutex);
+                g_FreeTraceBuffers.push_back(m_Buffer);
+                ThreadTrace = nullptr;
+            }
+        }
+
+        TraceBuffer* m_Buffer = nullptr;
+    };
+
+    static thread_local TraceLease ThreadLease;
+
+    static TraceBuffer*
+    GetTraceBuffer(
+        void
+    )
+    /*++
+      The buffer for this thread. One left by a thread of
+      the same name, e.g. a pool worker started again, is
+      taken first so it carries on where it left off. Any
+      other left behind is only taken once it has been
+      dumped, so no thread's events are lost
+    --*/
+    {
+        if (ThreadTrace == nullptr)
+        {
+            std::lock_guard<std::mutex> guard(g_TraceMutex);
+            auto name = ThreadQueue != nullptr ? ThreadQueue->GetName() : "thread " + std::to_string(g_LastThreadId + 1);
+            auto free = std::find_if(g_FreeTraceBuffers.begin(), g_FreeTraceBuffers.end(), [&name](TraceBuffer* Buffer) {
+                return Buffer->GetName() == name;
+            });
+            if (free == g_FreeTraceBuffers.end())
+            {
+                free = std::find_if(g_FreeTraceBuffers.begin(), g_FreeTraceBuffers.end(), [](TraceBuffer* Buffer) {
+                    return Buffer->Dumped();
+                });
+                if (free != g_FreeTraceBuffers.end())
+                {
+                    (*free)->Rename(++g_LastThreadId, name);
+                }
+            }
+            if (free != g_FreeTraceBuffers.end())
+            {
+                ThreadTrace = *free;
+                g_FreeTraceBuffers.erase(free);
+            }
+            else
+            {
+                g_TraceBuffers.push_back(std::make_unique<TraceBuffer>(++g_LastThreadId, name));
+                ThreadTrace = g_TraceBuffers.back().get();
+            }
+            ThreadLease.m_Buffer = ThreadTrace;
+        }
+        return ThreadTrace;
+    }
+
+    void
+    StartTracing(
+        void
+    )
+    /*++
+      Start recording, dropping whatever an earlier session
+      left in the buffers
+    --*/
+    {
+        {
+            std::lock_guard<std::mutex> guard(g_TraceMutex);
+            for (auto& buffer : g_TraceBuffers)
+            {
+                buffer->Reset();
+            }
+        }
+        g_Tracing.store(true, std::memory_order_relaxed);
+    }
+
+    void
+    StopTracing(
+        void
+    )
+    /*++
+      Stop giving new posts trace ids. Jobs that already
+      have one still record when they run
+    --*/
+    {
+        g_Tracing.store(false, std::memory_order_relaxed);
+    }
+
+    void
+    TraceJobPosted(
+        Job& Posted
+    )
+    {
+        auto buffer = GetTraceBuffer();
+        auto id = buffer->NextId();
+        Posted.SetTraceId(id);
+        if (auto reply = Posted.PeekReply())
+        {
+            reply->m_Job.SetTraceId(buffer->NextId());
+        }
+        buffer->Record(TraceKind::POST, id, 0);
+    }
+
+    void
+    TraceJobStarted(
+        const uint64_t TraceId
+    )
+    {
+        GetTraceBuffer()->Record(TraceKind::START, TraceId, 0);
+    }
+
+    void
+    TraceJobEnded(
+        const uint64_t TraceId
+    )
+    {
+        GetTraceBuffer()->Record(TraceKind::END, TraceId, 0);
+    }
+
+    void
+    TraceJobReplied(
+        const uint64_t TraceId,
+        const uint64_t ReplyId
+    )
+    /*++
+      The task TraceId finished and handed its reply on,
+      which starts the reply's flow
+    --*/
+    {
+        GetTraceBuffer()->Record(TraceKind::REPLY, ReplyId, TraceId);
+    }
+
+    void
+    TraceBuffer::Write(
+        FILE* File,
+        bool& First
+    )
+    /*++
+      Append our events as Chrome trace events. Posts and
+      replies are zero length slices that start a flow,
+      bound by id to the slice of the task they lead to.
+      Called with g_TraceMutex held
+    --*/
+    {
+        auto separator = [&]() {
+            fputs(First ? "\n" : ",\n", File);
+            First = false;
+        };
+
+        separator();
+        fprintf(File, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu64 ",\"args\":{\"name\":\"", m_ThreadId);
+        for (auto c : m_Name)
+        {
+            if (c == '"' || c == '\\')
+            {
+                fputc('\\', File);
+            }
+            if ((unsigned char)c >= 0x20)
+            {
+                fputc(c, File);
+            }
+        }
+        fputs("\"}}", File);
+
+        auto head = m_Head.load(std::memory_order_acquire);
+        auto position = m_Floor.load(std::memory_order_relaxed);
+        m_Dumped = head;
+        if (head - position > TRACE_BUFFER_EVENTS)
+        {
+            position = head - TRACE_BUFFER_EVENTS;
+        }
+        for (; position < head; position++)
+        {
+            auto& event = m_Events[position & (TRACE_BUFFER_EVENTS - 1)];
+            auto sequence = event.m_Sequence.load(std::memory_order_acquire);
+            auto time = event.m_Time.load(std::memory_order_relaxed);
+            auto kind = (TraceKind)event.m_Kind.load(std::memory_order_relaxed);
+            auto id = event.m_Id.load(std::memory_order_relaxed);
+            auto link = event.m_Link.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence != position * 2 + 2 || event.m_Sequence.load(std::memory_order_relaxed) != sequence)
+            {
+                continue;
+            }
+
+            separator();
+            auto timestamp = (double)time / 1000.0;
+            switch (kind)
+            {
+            case TraceKind::POST:
+                fprintf(File, "{\"name\":\"post\",\"cat\":\"dispatch\",\"ph\":\"X\",\"dur\":0,\"pid\":1,\"tid\":%" PRIu64 ",\"ts\":%.3f,"
+                              "\"bind_id\":\"0x%" PRIx64 "\",\"flow_out\":true}", m_ThreadId, timestamp, id);
+                break;
+            case TraceKind::START:
+                fprintf(File, "{\"name\":\"task\",\"cat\":\"dispatch\",\"ph\":\"B\",\"pid\":1,\"tid\":%" PRIu64 ",\"ts\":%.3f,"
+                              "\"bind_id\":\"0x%" PRIx64 "\",\"flow_in\":true,\"args\":{\"id\":\"0x%" PRIx64 "\"}}", m_ThreadId, timestamp, id, id);
+                break;
+            case TraceKind::END:
+                fprintf(File, "{\"ph\":\"E\",\"pid\":1,\"tid\":%" PRIu64 ",\"ts\":%.3f}", m_ThreadId, timestamp);
+                break;
+            case TraceKind::REPLY:
+                fprintf(File, "{\"name\":\"reply\",\"cat\":\"dispatch\",\"ph\":\"X\",\"dur\":0,\"pid\":1,\"tid\":%" PRIu64 ",\"ts\":%.3f,"
+                              "\"bind_id\":\"0x%" PRIx64 "\",\"flow_out\":true,\"args\":{\"task\":\"0x%" PRIx64 "\"}}", m_ThreadId, timestamp, id, link);
+                break;
+            }
+        }
+    }
+
+    bool
+    DumpTrace(
+        const std::string& Path
+    )
+    /*++
+      Write everything recorded since tracing last started
+      to Path as Chrome trace event JSON, which Perfetto and
+      chrome://tracing load. Safe while tasks are running,
+      events being overwritten as we read are skipped
+    --*/
+    {
+        auto file = fopen(Path.c_str(), "w");
+        if (file == nullptr)
+        {
+            return false;
+        }
+        fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+        bool first = true;
+        {
+            std::lock_guard<std::mutex> guard(g_TraceMutex);
+            for (auto& buffer : g_TraceBuffers)
+            {
+                buffer->Write(file, first);
+            }
+        }
+        fputs("\n]}\n", file);
+        return fclose(file) == 0;
+    }
+
+}
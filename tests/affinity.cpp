@@ -0,0 +1,95 @@
+#include <assert.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+
+std::atomic<size_t> g_Checked = 0;
+
+void
+CheckWorker(
+    const std::vector<dispatch::WorkerPlacement>* Placement
+)
+/*++
+  Runs on a pool worker, compares the thread's actual
+  affinity with what the pool reports for it
+--*/
+{
+    auto name = dispatch::CurrentQueue()->GetName();
+    for (auto& worker : *Placement)
+    {
+        if (worker.m_Name == name)
+        {
+            assert(dispatch::GetThreadAffinity() == worker.m_Cpus);
+            g_Checked++;
+            return;
+        }
+    }
+    assert(false);
+}
+
+void
+CheckPool(
+    const char* Name,
+    const dispatch::PoolConfig& Config
+)
+{
+    auto pool = dispatch::CreateDispatchPool(Name, Config);
+    auto placement = pool->GetPlacement();
+    assert(placement.size() == pool->GetWorkerCount());
+
+    std::cout << Name << " on " << pool->GetNodeCount() << " node(s)" << std::endl;
+    for (auto& worker : placement)
+    {
+        assert(!worker.m_Cpus.empty());
+        std::cout << "  " << worker.m_Name << " node " << worker.m_Node << " cpus " << dispatch::FormatCpuList(worker.m_Cpus) << std::endl;
+    }
+
+    //
+    // Round robin hands one task to each worker in turn
+    //
+    g_Checked = 0;
+    for (size_t i = 0; i < placement.size(); i++)
+    {
+        pool->PostTask(dispatch::bind(&CheckWorker, &placement));
+    }
+    while (g_Checked < placement.size())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    pool->Stop();
+    dispatch::GlobalDispatcherWait();
+}
+
+int main()
+{
+    assert(dispatch::ParseCpuList("0-3,8,10-11\n") == dispatch::CpuSet({ 0, 1, 2, 3, 8, 10, 11 }));
+    assert(dispatch::ParseCpuList("") == dispatch::CpuSet());
+    assert(dispatch::FormatCpuList({ 0, 1, 2, 3, 8, 10, 11 }) == "0-3,8,10-11");
+
+    auto cpus = dispatch::OnlineCpus();
+    auto nodes = dispatch::NumaNodes();
+    assert(!cpus.empty() && !nodes.empty());
+    std::cout << "Online " << dispatch::FormatCpuList(cpus) << " across " << nodes.size() << " node(s)" << std::endl;
+
+    dispatch::PoolConfig pinned;
+    pinned.m_Placement = dispatch::PoolPlacement::PIN_CORES;
+    CheckPool("pinned", pinned);
+
+    dispatch::PoolConfig numa;
+    numa.m_Size = 4;
+    numa.m_Mode = dispatch::PoolMode::ROUND_ROBIN;
+    numa.m_Placement = dispatch::PoolPlacement::NUMA_NODES;
+    CheckPool("numa", numa);
+
+    dispatch::PoolConfig explicitSets;
+    explicitSets.m_Size = 2;
+    explicitSets.m_CpuSets = { { cpus.back() } };
+    CheckPool("explicit", explicitSets);
+
+    std::cout << "End of Main Thread" << std::endl;
+}
@@ -0,0 +1,88 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+
+#include "DispatchQueue.hpp"
+
+#define IO "io"
+
+const char MESSAGE[] = "Hello from the ring";
+
+int g_Fd;
+char g_Buffer[sizeof(MESSAGE)];
+
+void
+OnRead(
+    const int64_t Result
+)
+{
+    assert(dispatch::OnDispatcher(IO));
+    std::cout << "Read " << Result << " bytes: \"" << g_Buffer << "\"" << std::endl;
+    assert(Result == sizeof(MESSAGE));
+    assert(strcmp(g_Buffer, MESSAGE) == 0);
+
+    //
+    // Errors come back as -errno
+    //
+    dispatch::AsyncRead(-1, g_Buffer, sizeof(g_Buffer), 0, [](int64_t Result){
+        std::cout << "Bad fd read returned " << std::dec << Result << std::endl;
+        assert(Result == -EBADF);
+        dispatch::End();
+    });
+}
+
+void
+OnSynced(
+    const int64_t Result
+)
+{
+    std::cout << "Fsync returned " << Result << std::endl;
+    assert(Result == 0);
+    dispatch::AsyncRead(g_Fd, g_Buffer, sizeof(g_Buffer), 0, &OnRead);
+}
+
+void
+OnWritten(
+    const int64_t Result
+)
+{
+    std::cout << "Wrote " << Result << " bytes" << std::endl;
+    assert(Result == sizeof(MESSAGE));
+    dispatch::AsyncFsync(g_Fd, &OnSynced);
+}
+
+void
+Start(
+    void
+)
+{
+    std::cout << "Using " << (dispatch::CurrentQueue()->GetIoRing()->Available() ? "io_uring" : "synchronous fallback") << std::endl;
+    dispatch::AsyncWrite(g_Fd, MESSAGE, sizeof(MESSAGE), 0, &OnWritten);
+}
+
+int main()
+{
+    char path[] = "/tmp/dispatchqueue_async_io_XXXXXX";
+    g_Fd = mkstemp(path);
+    assert(g_Fd != -1);
+    unlink(path);
+
+    auto io = dispatch::CreateAndEnterDispatcher(IO, dispatch::bind(&Start));
+
+#ifndef DISPATCH_NO_METRICS
+    //
+    // Completions are posted to the dispatcher by the ring
+    //
+    auto metrics = io->GetMetrics();
+    std::cout << "Posted " << metrics.m_Posted << ", ran " << metrics.m_Run << std::endl;
+    assert(metrics.m_Posted == metrics.m_Run);
+#endif
+
+    close(g_Fd);
+    std::cout << "End of Main Thread" << std::endl;
+}
@@ -0,0 +1,178 @@
+#include <assert.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+#include "SharedRefptr.hpp"
+
+const size_t WORKERS = 4;
+const size_t COPIES = 10000;
+const uint64_t MAGIC = 0x5a5a5a5a5a5a5a5a;
+
+std::atomic<size_t> g_Destroyed = 0;
+std::atomic<size_t> g_Returned = 0;
+
+struct Tracked
+{
+    ~Tracked(void)
+    {
+        assert(m_Magic == MAGIC);
+        m_Magic = 0;
+        g_Destroyed++;
+    }
+    uint64_t m_Magic = MAGIC;
+};
+
+using TrackedPtr = dispatch::BiasedRefPtr<Tracked>;
+
+std::vector<dispatch::DispatcherBasePtr> g_Workers;
+dispatch::DispatcherBasePtr g_Owner;
+TrackedPtr g_Kept;
+
+void
+WaitFor(
+    const std::atomic<size_t>& Counter,
+    const size_t Expected
+)
+{
+    while (Counter < Expected)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void
+Returned(
+    TrackedPtr Ptr
+)
+{
+    assert(dispatch::CurrentQueue() == g_Owner.get());
+    assert(Ptr->m_Magic == MAGIC);
+    g_Returned++;
+}
+
+void
+Churn(
+    TrackedPtr Ptr
+)
+/*++
+  On a worker: copies here are counted atomically. Send
+  one back so the owner sees shared references too
+--*/
+{
+    for (size_t i = 0; i < COPIES; i++)
+    {
+        auto copy = Ptr;
+        assert(copy->m_Magic == MAGIC);
+    }
+    g_Owner->PostTask(dispatch::bind(&Returned, Ptr));
+}
+
+void
+ShareFromOwner(
+    void
+)
+/*++
+  On the owner: copies are plain increments. Every
+  worker gets a copy, and we keep one until the end
+--*/
+{
+    auto ptr = dispatch::MakeBiasedRefPtr<Tracked>();
+    assert(ptr.refs() == 1);
+    auto copy = ptr;
+    assert(ptr.refs() == 2);
+    copy = nullptr;
+
+    for (auto& worker : g_Workers)
+    {
+        worker->PostTask(dispatch::bind(&Churn, ptr));
+    }
+    g_Kept = ptr;
+}
+
+void
+DropKept(
+    void
+)
+{
+    g_Kept = nullptr;
+}
+
+void
+HandOff(
+    void
+)
+/*++
+  On the owner: move the only reference to a worker. Its
+  release is merged back here, and frees the object
+--*/
+{
+    auto ptr = dispatch::MakeBiasedRefPtr<Tracked>();
+    g_Workers[0]->PostTask(dispatch::bind([](TrackedPtr Ptr) {
+        assert(Ptr->m_Magic == MAGIC);
+    }, std::move(ptr)));
+}
+
+int main()
+{
+    g_Owner = dispatch::CreateDispatcher("owner");
+    for (size_t i = 0; i < WORKERS; i++)
+    {
+        g_Workers.push_back(dispatch::CreateDispatcher("worker " + std::to_string(i)));
+    }
+
+    //
+    // References counted on both sides, the owner lets go
+    // last
+    //
+    g_Owner->PostTask(dispatch::bind(&ShareFromOwner));
+    WaitFor(g_Returned, WORKERS);
+    assert(g_Destroyed == 0);
+    g_Owner->PostTask(dispatch::bind(&DropKept));
+    WaitFor(g_Destroyed, 1);
+
+    //
+    // The last reference dies away from the owner
+    //
+    g_Owner->PostTask(dispatch::bind(&HandOff));
+    WaitFor(g_Destroyed, 2);
+
+    //
+    // Made off any dispatcher, every count is shared
+    //
+    {
+        auto ptr = dispatch::MakeBiasedRefPtr<Tracked>();
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < WORKERS; i++)
+        {
+            threads.emplace_back([ptr]{
+                for (size_t j = 0; j < COPIES; j++)
+                {
+                    auto copy = ptr;
+                    assert(copy->m_Magic == MAGIC);
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        assert(ptr.refs() == 1);
+    }
+    assert(g_Destroyed == 3);
+
+    g_Owner->Stop();
+    for (auto& worker : g_Workers)
+    {
+        worker->Stop();
+    }
+    dispatch::GlobalDispatcherWait();
+    g_Owner = nullptr;
+    g_Workers.clear();
+    std::cout << "End of Main Thread" << std::endl;
+}
@@ -0,0 +1,90 @@
+#include <assert.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "DispatchQueue.hpp"
+
+#define PRIMARY "primary"
+#define SECONDARY "secondary"
+
+dispatch::DispatcherBasePtr g_Secondary;
+
+dispatch::Task<int>
+Square(
+    const int Value
+)
+/*++
+  Does its work on the secondary dispatcher
+--*/
+{
+    co_await g_Secondary->Schedule();
+    assert(dispatch::OnDispatcher(SECONDARY));
+    std::cout << "Squaring " << Value << " on " SECONDARY << std::endl;
+    co_return Value * Value;
+}
+
+dispatch::Task<std::string>
+Describe(
+    const int Value
+)
+{
+    auto squared = co_await Square(Value);
+    co_return std::to_string(Value) + " squared is " + std::to_string(squared);
+}
+
+dispatch::Task<void>
+Main(
+    void
+)
+{
+    assert(dispatch::OnDispatcher(PRIMARY));
+
+    //
+    // Awaiting a task brings us back to where we were,
+    // even though it finished on another dispatcher
+    //
+    auto description = co_await Describe(7);
+    assert(dispatch::OnDispatcher(PRIMARY));
+    std::cout << description << std::endl;
+    assert(description == "7 squared is 49");
+
+    //
+    // Hop over and back explicitly
+    //
+    co_await g_Secondary->Schedule();
+    assert(dispatch::OnDispatcher(SECONDARY));
+    co_await dispatch::CurrentQueue()->Schedule();
+    assert(dispatch::OnDispatcher(SECONDARY));
+
+    //
+    // Sleep on the secondary's delayed queue
+    //
+    auto start = std::chrono::steady_clock::now();
+    co_await dispatch::SleepFor(std::chrono::milliseconds(20));
+    assert(dispatch::OnDispatcher(SECONDARY));
+    assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+    std::cout << "Slept on " SECONDARY << std::endl;
+
+    g_Secondary->Stop();
+    co_await dispatch::GetDispatcher(PRIMARY)->Schedule();
+    std::cout << "Back on " PRIMARY << std::endl;
+    dispatch::End();
+}
+
+void
+Start(
+    void
+)
+{
+    dispatch::Spawn(dispatch::CurrentQueue(), Main());
+}
+
+int main()
+{
+    g_Secondary = dispatch::CreateDispatcher(SECONDARY);
+    dispatch::CreateAndEnterDispatcher(PRIMARY, dispatch::bind(&Start));
+    dispatch::GlobalDispatcherWait();
+    std::cout << "End of Main Thread" << std::endl;
+}
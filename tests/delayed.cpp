@@ -1,9 +1,111 @@
+#include <assert.h>
+
 #include <chrono>
 #include <iostream>
+#include <iterator>
 #include <string>
+#include <vector>
 
 #include "DispatchQueue.hpp"
 
+using namespace std::chrono_literals;
+
+//
+// The wheel's level 0 covers 64 ticks and level 1 4096,
+// so these land on, and either side of, both boundaries.
+// Posted out of order, then more from a task once the
+// wheel has moved on
+//
+const std::chrono::microseconds FIRST[] = {
+    409700us, 6400us, 800000us, 300us, 20000us, 6500us, 409600us, 100000us, 6300us, 409500us
+};
+const std::chrono::microseconds SECOND[] = {
+    500000us, 6500us, 60000us
+};
+const size_t REARM = 4;
+const size_t TIMERS = std::size(FIRST) + std::size(SECOND);
+
+struct Timer
+{
+    std::chrono::microseconds m_Delay;
+    //
+    // The job's own dispatch time lies somewhere between
+    // these, as it is taken while posting
+    //
+    dispatch::timepoint m_Earliest;
+    dispatch::timepoint m_Latest;
+    dispatch::timepoint m_Fired;
+};
+
+std::vector<Timer> g_Timers(TIMERS);
+std::vector<size_t> g_Fired;
+
+void Fire(const size_t Index);
+
+void
+Arm(
+    dispatch::DispatcherBase* Dispatcher,
+    const size_t Index,
+    const std::chrono::microseconds Delay
+)
+{
+    auto& timer = g_Timers[Index];
+    timer.m_Delay = Delay;
+    timer.m_Earliest = std::chrono::system_clock::now() + Delay;
+    Dispatcher->PostDelayedTask(dispatch::bind(&Fire, Index), Delay);
+    timer.m_Latest = std::chrono::system_clock::now() + Delay;
+}
+
+void
+Fire(
+    const size_t Index
+)
+{
+    g_Timers[Index].m_Fired = std::chrono::system_clock::now();
+    g_Fired.push_back(Index);
+    if (Index == REARM)
+    {
+        for (size_t i = 0; i < std::size(SECOND); i++)
+        {
+            Arm(dispatch::CurrentQueue(), std::size(FIRST) + i, SECOND[i]);
+        }
+    }
+    if (g_Fired.size() == TIMERS)
+    {
+        dispatch::End();
+    }
+}
+
+void
+CheckCascade(
+    void
+)
+/*++
+  Nothing fires before its time, and timers fire in the
+  order of their dispatch times however far they had to
+  cascade down the wheel
+--*/
+{
+    auto dispatcher = dispatch::CreateDispatcher("wheel");
+    for (size_t i = 0; i < std::size(FIRST); i++)
+    {
+        Arm(dispatcher.get(), i, FIRST[i]);
+    }
+    dispatcher->Wait();
+
+    assert(g_Fired.size() == TIMERS);
+    for (size_t i = 0; i < TIMERS; i++)
+    {
+        auto& timer = g_Timers[g_Fired[i]];
+        assert(timer.m_Fired >= timer.m_Earliest);
+        if (i > 0)
+        {
+            assert(g_Timers[g_Fired[i - 1]].m_Earliest <= timer.m_Latest);
+        }
+    }
+    std::cout << "Fired " << TIMERS << " timers in order" << std::endl;
+}
+
 void
 Test(
     const std::string Argument
@@ -23,6 +125,8 @@ DoEnd(
 
 int main()
 {
+    CheckCascade();
+
     //
     // Create the dispatchers
     //
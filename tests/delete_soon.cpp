@@ -0,0 +1,223 @@
+#include <assert.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+
+const size_t OBJECTS = 1000;
+
+dispatch::DispatcherBasePtr g_Owner;
+dispatch::DispatcherBasePtr g_Worker;
+std::atomic<size_t> g_Deleted = 0;
+std::atomic<size_t> g_Misplaced = 0;
+
+struct Tracked
+/*++
+  Checks it is destroyed on the owner
+--*/
+{
+    ~Tracked(void)
+    {
+        if (dispatch::CurrentQueue() != g_Owner.get())
+        {
+            g_Misplaced++;
+        }
+        g_Deleted++;
+    }
+};
+
+void
+WaitForDeleted(
+    const size_t Expected
+)
+{
+    while (g_Deleted < Expected)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(g_Deleted == Expected);
+    assert(g_Misplaced == 0);
+}
+
+void
+DeleteFromWorker(
+    void
+)
+/*++
+  More deletes than fit in a batch, queued from one task
+--*/
+{
+    for (size_t i = 0; i < OBJECTS; i++)
+    {
+        if (i % 2 == 0)
+        {
+            dispatch::DeleteSoon(g_Owner.get(), new Tracked());
+        }
+        else
+        {
+            dispatch::DeleteSoon(g_Owner.get(), std::make_unique<Tracked>());
+        }
+    }
+}
+
+dispatch::BoundRefPtr<Tracked> g_Kept;
+
+void
+DropOnWorker(
+    const dispatch::BoundRefPtr<Tracked>& Ptr
+)
+/*++
+  Taken by reference, as copying a BoundRefPtr here is
+  not allowed. The task's own copy is dropped after this
+--*/
+{
+    assert(dispatch::CurrentQueue() == g_Worker.get());
+}
+
+void
+SendBound(
+    const bool Keep
+)
+/*++
+  On the owner: send a BoundRefPtr to the worker, which
+  drops it there. Its release comes back here
+--*/
+{
+    auto ptr = dispatch::MakeBoundRefPtr<Tracked>();
+    if (Keep)
+    {
+        g_Kept = ptr;
+    }
+    g_Worker->PostTask(dispatch::bind(&DropOnWorker, std::move(ptr)));
+}
+
+void
+DropKept(
+    void
+)
+{
+    assert(g_Kept.refs() == 1);
+    g_Kept = nullptr;
+}
+
+std::atomic<size_t> g_Stranded = 0;
+std::atomic<bool> g_Sent = false;
+std::atomic<bool> g_Stopped = false;
+std::atomic<bool> g_Flushed = false;
+
+struct Stranded
+{
+    ~Stranded(void) { g_Stranded++; };
+};
+
+void
+DropWhenStopped(
+    const dispatch::BoundRefPtr<Stranded>& Ptr
+)
+/*++
+  Hold on until the owner has stopped, so the release is
+  posted to an inbox nobody will read
+--*/
+{
+    while (!g_Stopped)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void
+SendStranded(
+    void
+)
+{
+    g_Worker->PostTask(dispatch::bind(&DropWhenStopped, dispatch::MakeBoundRefPtr<Stranded>()));
+    g_Sent = true;
+}
+
+void
+Flush(
+    void
+)
+{
+    dispatch::FlushDeleteSoon();
+    g_Flushed = true;
+}
+
+int main()
+{
+    g_Owner = dispatch::CreateDispatcher("owner");
+    g_Worker = dispatch::CreateDispatcher("worker");
+
+    //
+    // From a plain thread, posted straight away
+    //
+    dispatch::DeleteSoon(g_Owner.get(), new Tracked());
+    WaitForDeleted(1);
+
+    //
+    // From a dispatcher, batched
+    //
+    g_Worker->PostTask(dispatch::bind(&DeleteFromWorker));
+    WaitForDeleted(1 + OBJECTS);
+
+    //
+    // The last reference to a BoundRefPtr goes away on
+    // another dispatcher
+    //
+    g_Owner->PostTask(dispatch::bind(&SendBound, false));
+    WaitForDeleted(2 + OBJECTS);
+
+    //
+    // Not the last reference: the owner's copy keeps it
+    // alive until the owner drops it
+    //
+    g_Owner->PostTask(dispatch::bind(&SendBound, true));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    assert(g_Deleted == 2 + OBJECTS);
+    g_Owner->PostTask(dispatch::bind(&DropKept));
+    WaitForDeleted(3 + OBJECTS);
+
+    //
+    // ReleaseSoon on any SharedRefPtr
+    //
+    auto shared = dispatch::MakeSharedRefPtr<Tracked>();
+    dispatch::ReleaseSoon(g_Owner.get(), std::move(shared));
+    assert(!shared);
+    WaitForDeleted(4 + OBJECTS);
+
+    //
+    // The release is sent back to an owner that has
+    // stopped. Its batch is dropped with the owner and has
+    // to release there and then rather than post again
+    //
+    auto gone = dispatch::CreateDispatcher("gone");
+    gone->PostTask(dispatch::bind(&SendStranded));
+    while (!g_Sent)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    gone->Stop();
+    gone->Wait();
+    g_Stopped = true;
+    g_Worker->PostTask(dispatch::bind(&Flush));
+    while (!g_Flushed)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(g_Stranded == 0);
+
+    g_Owner->Stop();
+    g_Worker->Stop();
+    dispatch::GlobalDispatcherWait();
+    dispatch::RemoveDispatcher(gone.get());
+    gone = nullptr;
+    assert(g_Stranded == 1);
+    g_Owner = nullptr;
+    g_Worker = nullptr;
+    std::cout << "End of Main Thread" << std::endl;
+}
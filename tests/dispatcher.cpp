@@ -1,6 +1,9 @@
 #include <assert.h>
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <thread>
@@ -9,6 +12,7 @@
 #define PRIMARY "primary"
 #define SECONDARY "secondary"
 #define POOL "pool"
+#define STEALINGPOOL "stealing pool"
 #define TASK1 "First Task"
 #define TASK2 "Second Task"
 #define TASK3 "Third Task"
@@ -19,10 +23,14 @@
 #define EXTRATASK "Extra Task"
 #define POOLTASK "Pool Task "
 #define POOLSUBTASK "Pool Sub Task "
+#define POOLBATCHTASK "Pool Batch Task "
+#define MOVEONLY "move only"
+#define HELPER "helper"
 
 using CallbackProto = std::function<void(std::string)>;
 
 std::mutex g_PrintLock;
+std::atomic<size_t> g_PoolTasksRun = 0;
 
 void Callback(
     const CallbackProto Callback,
@@ -38,6 +46,10 @@ void Test(const std::string Argument)
         std::lock_guard<std::mutex> mutex(g_PrintLock);
         std::cout << std::hex << '[' << std::this_thread::get_id() << "] " << Argument << std::endl;
     }
+    if (Argument.starts_with(POOLTASK) || Argument.starts_with(POOLSUBTASK) || Argument.starts_with(POOLBATCHTASK))
+    {
+        g_PoolTasksRun++;
+    }
     if (Argument == TASK1){
         dispatch::PostTask(
             dispatch::bind(&Test, TASK2)
@@ -96,6 +108,122 @@ void Test(const std::string Argument)
     }
 }
 
+//
+// A functor of exactly Size bytes
+//
+template <size_t Size>
+struct Sized
+{
+    unsigned char m_Bytes[Size];
+    void operator()(void) { m_Bytes[0]++; };
+};
+
+struct ThrowingMove
+{
+    ThrowingMove(void) = default;
+    ThrowingMove(ThrowingMove&&) noexcept(false) {};
+    void operator()(void) {};
+};
+
+template <typename Target>
+bool
+StoredInline(
+    dispatch::UniqueCallable& Callable
+)
+{
+    auto stored = (unsigned char*)Callable.target<Target>();
+    assert(stored != nullptr);
+    return stored >= (unsigned char*)&Callable && stored < (unsigned char*)(&Callable + 1);
+}
+
+void
+CheckInlineBoundary(
+    void
+)
+/*++
+  Functors up to the inline size live in the callable,
+  one byte more goes to the heap, and either kind still
+  runs once moved
+--*/
+{
+    const size_t size = DISPATCH_INLINE_CALLABLE_SIZE;
+    static_assert(dispatch::UniqueCallable::FitsInline<Sized<size>>());
+    static_assert(!dispatch::UniqueCallable::FitsInline<Sized<size + 1>>());
+    static_assert(!dispatch::UniqueCallable::FitsInline<ThrowingMove>());
+
+    dispatch::UniqueCallable fits(Sized<size>{});
+    assert(StoredInline<Sized<size>>(fits));
+    dispatch::UniqueCallable spills(Sized<size + 1>{});
+    assert(!StoredInline<Sized<size + 1>>(spills));
+    dispatch::UniqueCallable throwing(ThrowingMove{});
+    assert(!StoredInline<ThrowingMove>(throwing));
+
+    auto heap = spills.target<Sized<size + 1>>();
+    auto moved = std::move(spills);
+    assert(!spills);
+    assert(moved.target<Sized<size + 1>>() == heap);
+    moved();
+    assert(heap->m_Bytes[0] == 1);
+
+    auto padded = std::make_unique<int>(1);
+    auto capture = [padded = std::move(padded), bytes = Sized<size - sizeof(padded)>{}]{ assert(*padded == 1); };
+    static_assert(sizeof(capture) == size);
+    dispatch::UniqueCallable owning(std::move(capture));
+    assert(StoredInline<decltype(capture)>(owning));
+    auto relocated = std::move(owning);
+    assert(StoredInline<decltype(capture)>(relocated));
+    relocated();
+}
+
+std::atomic<size_t> g_MoveOnlyRun = 0;
+
+void
+CheckMoveOnly(
+    void
+)
+/*++
+  Tasks and replies that own a std::unique_ptr, which a
+  std::function could not hold
+--*/
+{
+    auto dispatcher = dispatch::CreateDispatcher(MOVEONLY);
+    auto helper = dispatch::CreateDispatcher(HELPER);
+
+    auto owned = std::make_unique<int>(1);
+    dispatcher->PostTask([owned = std::move(owned)]{
+        assert(*owned == 1);
+        g_MoveOnlyRun++;
+    });
+    assert(owned == nullptr);
+
+    dispatcher->PostDelayedTask([owned = std::make_unique<int>(2)]{
+        assert(*owned == 2);
+        g_MoveOnlyRun++;
+    }, std::chrono::milliseconds(1));
+
+    dispatcher->PostTask([helper]{
+        helper->PostTaskAndReply(
+            [owned = std::make_unique<int>(3)]{
+                assert(*owned == 3);
+                assert(dispatch::OnDispatcher(HELPER));
+                g_MoveOnlyRun++;
+            },
+            [owned = std::make_unique<int>(4)]{
+                assert(*owned == 4);
+                assert(dispatch::OnDispatcher(MOVEONLY));
+                g_MoveOnlyRun++;
+            }
+        );
+    });
+
+    while (g_MoveOnlyRun < 4)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    dispatcher->Stop();
+    helper->Stop();
+}
+
 int main(){
 #ifdef DEBUG
     std::cout << "Running DEUBG build" << std::endl;
@@ -133,5 +261,45 @@ int main(){
 
     dispatch::GlobalDispatcherWait();
 
+    //
+    // Create a work-stealing dispatch pool and
+    // let it finish all tasks before stopping
+    //
+    g_PoolTasksRun = 0;
+    auto stealingPool = dispatch::CreateDispatchPool(STEALINGPOOL, 4, dispatch::PoolMode::WORK_STEALING);
+    for (size_t i = 0; i < 10; i++)
+    {
+        std::stringstream ss;
+        ss << POOLTASK << i+1;
+        stealingPool->PostTask(
+            dispatch::bind(&Test, ss.str())
+        );
+    }
+
+    //
+    // And a batch posted in one go
+    //
+    dispatch::TaskBatch batch;
+    for (size_t i = 0; i < 8; i++)
+    {
+        std::stringstream ss;
+        ss << POOLBATCHTASK << i+1;
+        batch.push_back(dispatch::bind(&Test, ss.str()));
+    }
+    stealingPool->PostTasks(std::move(batch));
+
+    while (g_PoolTasksRun < 23)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    stealingPool->Stop();
+
+    dispatch::GlobalDispatcherWait();
+
+    CheckInlineBoundary();
+    CheckMoveOnly();
+    dispatch::GlobalDispatcherWait();
+
     std::cout << "End of Main Thread" << std::endl;
 }
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include <assert.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "DispatchQueue.hpp"
+
+const size_t BURST = 300;
+const auto TASK_TIME = std::chrono::milliseconds(1);
+const auto POST_INTERVAL = std::chrono::microseconds(200);
+const auto SETTLE = std::chrono::seconds(10);
+
+std::atomic<size_t> g_Done = 0;
+std::atomic<bool> g_Armed = false;
+std::atomic<bool> g_Replied = false;
+std::string g_Sender;
+std::string g_Receiver;
+dispatch::DispatchPoolPtr g_Pool;
+dispatch::DispatcherBasePtr g_Slow;
+dispatch::Future<int> g_Future;
+std::atomic<int> g_Got = 0;
+
+void
+Work(
+    void
+)
+{
+    std::this_thread::sleep_for(TASK_TIME);
+    g_Done++;
+}
+
+template <typename Condition>
+bool
+WaitFor(
+    Condition Done
+)
+{
+    auto end = std::chrono::steady_clock::now() + SETTLE;
+    while (!Done())
+    {
+        if (std::chrono::steady_clock::now() > end)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void
+Outlast(
+    void
+)
+/*++
+  Runs elsewhere until the pool has shrunk back, so that
+  the reply is posted to a worker that has retired
+--*/
+{
+    bool shrunk = WaitFor([]{ return g_Pool->GetRunningWorkerCount() == g_Pool->GetMinWorkerCount(); });
+    assert(shrunk);
+}
+
+int
+OutlastWithResult(
+    void
+)
+{
+    Outlast();
+    return 42;
+}
+
+void
+Replied(
+    void
+)
+{
+    g_Receiver = dispatch::CurrentQueue()->GetName();
+    g_Replied = true;
+}
+
+void
+Probe(
+    void
+)
+/*++
+  The first task to run on a worker added by growing
+  asks for a reply, and for a result through a future
+  whose slot must still be there once it has retired
+--*/
+{
+    auto name = dispatch::CurrentQueue()->GetName();
+    if (name.ends_with("[0]") || g_Armed.exchange(true))
+    {
+        Work();
+        return;
+    }
+    g_Sender = name;
+    dispatch::PostTaskAndReply(g_Slow, dispatch::bind(&Outlast), dispatch::bind(&Replied));
+    g_Future = dispatch::PostTaskWithResult(g_Slow.get(), &OutlastWithResult);
+    g_Future.Then([](int Value){ g_Got = Value; });
+    Work();
+}
+
+size_t
+Burst(
+    void
+)
+/*++
+  Posted faster than one worker keeps up with, and over
+  long enough for later posts to reach new ones. Returns
+  the most workers seen live
+--*/
+{
+    g_Done = 0;
+    for (size_t i = 0; i < BURST; i++)
+    {
+        g_Pool->PostTask(dispatch::bind(&Probe));
+        std::this_thread::sleep_for(POST_INTERVAL);
+    }
+    size_t most = 0;
+    bool drained = WaitFor([&]{
+        most = std::max(most, g_Pool->GetWorkerCount());
+        return g_Done == BURST;
+    });
+    assert(drained);
+    return most;
+}
+
+bool
+Quiet(
+    void
+)
+/*++
+  Nothing runs on the pool, Balance included, for a good
+  many balance intervals
+--*/
+{
+    auto ran = g_Pool->GetMetrics().m_Run;
+    std::this_thread::sleep_for(dispatch::POOL_BALANCE_INTERVAL * 10);
+    return g_Pool->GetMetrics().m_Run == ran;
+}
+
+void
+GrowAndShrink(
+    const char* Name,
+    const dispatch::PoolMode Mode
+)
+{
+    dispatch::PoolConfig config;
+    config.m_Size = 1;
+    config.m_MaxSize = 4;
+    config.m_Mode = Mode;
+    config.m_GrowWait = std::chrono::microseconds(500);
+    config.m_RetireIdle = std::chrono::milliseconds(50);
+    g_Pool = dispatch::CreateDispatchPool(Name, config);
+    assert(g_Pool->IsElastic());
+    assert(g_Pool->GetWorkerCount() == 1);
+    assert(g_Pool->GetMaxWorkerCount() == 4);
+    assert(g_Pool->GetRunningWorkerCount() == 1);
+
+    g_Armed = false;
+    g_Replied = false;
+    g_Got = 0;
+
+    auto most = Burst();
+    assert(most > 1);
+    std::cout << Name << " grew to " << most << " workers" << std::endl;
+
+    //
+    // The reply arrives at a retired worker, which must be
+    // started again to run it and then retire once more
+    //
+    if (g_Armed)
+    {
+        bool replied = WaitFor([]{ return g_Replied.load(); });
+        assert(replied);
+        assert(g_Receiver == g_Sender);
+        std::cout << g_Sender << " was started again for its reply" << std::endl;
+        bool resolved = WaitFor([]{ return g_Got.load() != 0; });
+        assert(resolved && g_Got == 42);
+        std::cout << g_Sender << " was started again for its future" << std::endl;
+    }
+
+    bool shrunk = WaitFor([]{
+        return g_Pool->GetWorkerCount() == 1 && g_Pool->GetRunningWorkerCount() == 1;
+    });
+    assert(shrunk);
+    std::cout << Name << " shrank back to 1 worker" << std::endl;
+
+#ifndef DISPATCH_NO_METRICS
+    //
+    // Back at its minimum and idle the pool stops
+    // balancing, and the next burst starts it again
+    //
+    bool quiet = WaitFor(&Quiet);
+    assert(quiet);
+    std::cout << Name << " stopped balancing while idle" << std::endl;
+    most = Burst();
+    assert(most > 1);
+    shrunk = WaitFor([]{
+        return g_Pool->GetWorkerCount() == 1 && g_Pool->GetRunningWorkerCount() == 1;
+    });
+    assert(shrunk);
+#endif
+
+    g_Pool->Stop();
+    g_Pool->Wait();
+    assert(g_Pool->GetRunningWorkerCount() == 0);
+    g_Pool = nullptr;
+}
+
+int main()
+{
+    g_Slow = dispatch::CreateDispatcher("slow");
+
+    GrowAndShrink("elastic", dispatch::PoolMode::ROUND_ROBIN);
+    GrowAndShrink("elastic stealing", dispatch::PoolMode::WORK_STEALING);
+
+    //
+    // Fixed pools are left as they were
+    //
+    auto pool = dispatch::CreateDispatchPool("fixed", 2);
+    assert(!pool->IsElastic());
+    assert(pool->GetWorkerCount() == 2);
+    assert(pool->GetRunningWorkerCount() == 2);
+    pool->Stop();
+    pool->Wait();
+    assert(pool->GetRunningWorkerCount() == 0);
+
+    g_Slow->Stop();
+    dispatch::GlobalDispatcherWait();
+    std::cout << "End of Main Thread" << std::endl;
+}
@@ -0,0 +1,158 @@
+#include <assert.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+
+#define PRIMARY "primary"
+#define SECONDARY "secondary"
+#define POOL "pool"
+
+dispatch::DispatcherBasePtr g_Secondary;
+dispatch::DispatcherPoolPtr g_Pool;
+dispatch::Future<std::string> g_Held;
+dispatch::Future<std::unique_ptr<int>> g_Unique;
+std::vector<dispatch::Future<int>> g_Moved;
+size_t g_Outstanding;
+
+void
+Finished(
+    void
+)
+{
+    assert(dispatch::OnDispatcher(PRIMARY));
+    if (--g_Outstanding == 0)
+    {
+        g_Moved.clear();
+        g_Secondary->Stop();
+        g_Pool->Stop();
+        std::cout << "End" << std::endl;
+        dispatch::End();
+    }
+}
+
+void
+CheckHeld(
+    void
+)
+/*++
+  By now the reply for g_Held has run, so Then takes
+  the fast path and runs inline
+--*/
+{
+    assert(g_Held.Ready());
+    assert(!g_Held.Pending());
+    assert(g_Held.Get() == "held on " SECONDARY);
+    bool ran = false;
+    g_Held.Then(
+        [&ran](std::string Value) {
+            assert(Value == "held on " SECONDARY);
+            ran = true;
+        }
+    );
+    assert(ran);
+    std::cout << "Ready future ran its continuation inline" << std::endl;
+    Finished();
+}
+
+void
+Start(
+    void
+)
+{
+    g_Outstanding = 6;
+
+    //
+    // Reply with the result
+    //
+    dispatch::PostTaskWithResult(
+        g_Secondary.get(),
+        []{ assert(dispatch::OnDispatcher(SECONDARY)); return 6 * 7; },
+        [](int Value) {
+            assert(dispatch::OnDispatcher(PRIMARY));
+            assert(Value == 42);
+            std::cout << "Reply got " << Value << std::endl;
+            Finished();
+        }
+    );
+
+    //
+    // Future with the continuation set before it completes,
+    // carrying a move-only result
+    //
+    g_Unique = dispatch::PostTaskWithResult(
+        g_Secondary.get(),
+        []{ return std::make_unique<int>(7); }
+    );
+    assert(g_Unique.Pending());
+    g_Unique.Then(
+        [](std::unique_ptr<int> Value) {
+            assert(dispatch::OnDispatcher(PRIMARY));
+            assert(*Value == 7);
+            std::cout << "Future continuation got " << *Value << std::endl;
+            Finished();
+        }
+    );
+
+    //
+    // Futures that move while their tasks are in flight,
+    // on pool workers
+    //
+    for (int i = 0; i < 16; i++)
+    {
+        g_Moved.push_back(dispatch::PostTaskWithResult(g_Pool.get(), [i]{ return i; }));
+    }
+    g_Moved.front().Then(
+        [](int Value) {
+            assert(Value == 0);
+            Finished();
+        }
+    );
+    g_Moved.back().Then(
+        [](int Value) {
+            assert(Value == 15);
+            std::cout << "Moved futures completed" << std::endl;
+            Finished();
+        }
+    );
+
+    //
+    // A future dropped before its task runs just discards
+    // the result
+    //
+    {
+        auto dropped = dispatch::PostTaskWithResult(g_Secondary.get(), []{ return 1; });
+    }
+    dispatch::PostTaskWithResult(
+        g_Secondary.get(),
+        []{ return 2; },
+        [](int Value) {
+            assert(Value == 2);
+            std::cout << "Dropped future was ignored" << std::endl;
+            Finished();
+        }
+    );
+
+    //
+    // Let the reply land without a continuation, then
+    // check the fast path from a later task on this
+    // dispatcher
+    //
+    g_Held = dispatch::PostTaskWithResult(g_Secondary.get(), []{ return std::string("held on " SECONDARY); });
+    g_Secondary->PostTaskAndReply(
+        dispatch::bind(&dispatch::DoNothing),
+        []{ dispatch::PostTask(dispatch::bind(&CheckHeld)); }
+    );
+}
+
+int main()
+{
+    g_Secondary = dispatch::CreateDispatcher(SECONDARY);
+    g_Pool = dispatch::CreateDispatchPool(POOL, 4);
+    dispatch::CreateAndEnterDispatcher(PRIMARY, dispatch::bind(&Start));
+    dispatch::GlobalDispatcherWait();
+    std::cout << "End of Main Thread" << std::endl;
+}
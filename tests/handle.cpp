@@ -0,0 +1,155 @@
+#include <assert.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+
+#define TARGET "target"
+#define RACED "raced"
+#define REUSED "reused"
+
+const size_t POSTERS = 4;
+const size_t POSTS = 1000;
+
+std::atomic<size_t> g_Run = 0;
+
+void
+Count(
+    void
+)
+{
+    g_Run++;
+}
+
+void
+WaitForRun(
+    const size_t Expected
+)
+{
+    while (g_Run < Expected)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void
+PostByNameAndHandle(
+    void
+)
+{
+    auto target = dispatch::CreateDispatcher(TARGET);
+    auto handle = dispatch::GetDispatcherHandle(TARGET);
+    assert(handle.Valid());
+    assert(handle == target->GetHandle());
+    assert(dispatch::GetDispatcher(TARGET) == target);
+    assert(!dispatch::GetDispatcherHandle("missing"));
+
+    g_Run = 0;
+    for (size_t i = 0; i < POSTS; i++)
+    {
+        dispatch::PostTaskToDispatcher(TARGET, dispatch::bind(&Count));
+        assert(dispatch::PostTaskToDispatcher(handle, dispatch::bind(&Count)));
+    }
+    dispatch::TaskBatch batch;
+    batch.push_back(dispatch::bind(&Count));
+    batch.push_back(dispatch::bind(&Count));
+    assert(handle.PostTasks(std::move(batch)));
+    assert(handle.PostDelayedTask(dispatch::bind(&Count), std::chrono::milliseconds(1)));
+    WaitForRun(2 * POSTS + 3);
+
+    target->Stop();
+    target->Wait();
+    dispatch::RemoveDispatcher(target.get());
+    assert(!handle.Valid());
+    assert(!dispatch::GetDispatcherHandle(TARGET));
+    assert(dispatch::GetDispatcher(TARGET) == nullptr);
+    assert(!dispatch::PostTaskToDispatcher(handle, dispatch::bind(&Count)));
+    assert(handle.Lock() == nullptr);
+}
+
+void
+RemoveWhilePosting(
+    void
+)
+/*++
+  Threads keep posting through a handle while the
+  dispatcher is stopped and removed under them. Every
+  post either lands or fails cleanly
+--*/
+{
+    auto target = dispatch::CreateDispatcher(RACED);
+    auto handle = dispatch::GetDispatcherHandle(RACED);
+
+    std::atomic<size_t> accepted = 0;
+    std::vector<std::thread> posters;
+    for (size_t i = 0; i < POSTERS; i++)
+    {
+        posters.emplace_back([&]{
+            while (handle.PostTask(dispatch::bind(&Count)))
+            {
+                accepted++;
+            }
+        });
+    }
+    while (accepted < POSTS)
+    {
+        std::this_thread::yield();
+    }
+
+    target->Stop();
+    target->Wait();
+    dispatch::RemoveDispatcher(target.get());
+    for (auto& poster : posters)
+    {
+        poster.join();
+    }
+    assert(!handle.Valid());
+    std::cout << "Accepted " << std::dec << accepted << " posts before removal" << std::endl;
+}
+
+void
+ReuseName(
+    void
+)
+/*++
+  Creating a dispatcher under a name that is in use
+  takes the name over, old handles to it go stale
+--*/
+{
+    auto first = dispatch::CreateDispatcher(REUSED);
+    auto stale = dispatch::GetDispatcherHandle(REUSED);
+    auto second = dispatch::CreateDispatcher(REUSED);
+    auto fresh = dispatch::GetDispatcherHandle(REUSED);
+
+    assert(!stale.Valid());
+    assert(fresh.Valid());
+    assert(!(stale == fresh));
+    assert(fresh == second->GetHandle());
+    assert(!stale.PostTask(dispatch::bind(&Count)));
+
+    g_Run = 0;
+    assert(fresh.PostTask(dispatch::bind(&Count)));
+    WaitForRun(1);
+
+    first->Stop();
+    second->Stop();
+    first->Wait();
+    second->Wait();
+    dispatch::RemoveDispatcher(first.get());
+    assert(fresh.Valid());
+    dispatch::RemoveDispatcher(second.get());
+    assert(!fresh.Valid());
+}
+
+int main()
+{
+    PostByNameAndHandle();
+    RemoveWhilePosting();
+    ReuseName();
+    dispatch::GlobalDispatcherWait();
+    std::cout << "End of Main Thread" << std::endl;
+}
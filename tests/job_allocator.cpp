@@ -0,0 +1,147 @@
+#include <assert.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "DispatchQueue.hpp"
+
+const size_t SLAB = dispatch::JobAllocator::SLAB_NODES;
+const size_t NODES = SLAB * 2;
+
+dispatch::DispatcherBasePtr g_Consumer;
+std::atomic<bool> g_Hold = false;
+std::atomic<bool> g_Blocked = false;
+std::atomic<bool> g_Posted = false;
+std::atomic<size_t> g_Ran = 0;
+
+void
+Wait(
+    std::atomic<bool>& Flag,
+    const bool Value
+)
+{
+    while (Flag != Value)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void
+Consume(
+    void
+)
+{
+    g_Ran++;
+}
+
+void
+Block(
+    void
+)
+/*++
+  Keeps the consumer from taking anything out of its
+  inbox, and so from freeing it, until the owner has
+  posted all it will
+--*/
+{
+    g_Blocked = true;
+    Wait(g_Hold, false);
+}
+
+void
+Produce(
+    const size_t Count
+)
+/*++
+  On the owner: every post to the consumer takes a node
+  from the owner's allocator, which the consumer frees
+--*/
+{
+    for (size_t i = 0; i < Count; i++)
+    {
+        g_Consumer->PostTask(dispatch::bind(&Consume));
+    }
+    g_Posted = true;
+}
+
+void
+ProduceHeld(
+    dispatch::DispatcherBase* Owner,
+    const size_t Count
+)
+{
+    g_Ran = 0;
+    g_Hold = true;
+    g_Posted = false;
+    g_Blocked = false;
+    g_Consumer->PostTask(dispatch::bind(&Block));
+    Wait(g_Blocked, true);
+    Owner->PostTask(dispatch::bind(&Produce, Count));
+    Wait(g_Posted, true);
+}
+
+void
+WaitForRan(
+    const size_t Count
+)
+{
+    while (g_Ran < Count)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+int main()
+{
+    g_Consumer = dispatch::CreateDispatcher("consumer");
+    auto owner = dispatch::CreateDispatcher("owner");
+
+    //
+    // Nothing is freed while the owner posts, so it carves
+    // one slab per SLAB nodes and takes the rest from them
+    //
+    ProduceHeld(owner.get(), NODES);
+    auto stats = owner->GetAllocatorStatistics();
+    assert(stats.m_Misses == NODES / SLAB);
+    assert(stats.m_Hits == NODES - NODES / SLAB);
+    assert(stats.m_Nodes == NODES);
+    assert(stats.m_RemoteFrees == 0);
+
+    g_Hold = false;
+    WaitForRan(NODES);
+    stats = owner->GetAllocatorStatistics();
+    assert(stats.m_RemoteFrees == NODES);
+    std::cout << "Consumer freed " << stats.m_RemoteFrees << " nodes remotely" << std::endl;
+
+    //
+    // The owner reclaims the remote frees in place of new
+    // slabs
+    //
+    ProduceHeld(owner.get(), NODES);
+    stats = owner->GetAllocatorStatistics();
+    assert(stats.m_Misses == NODES / SLAB);
+    assert(stats.m_Hits == 2 * NODES - NODES / SLAB);
+    assert(stats.m_Nodes == NODES);
+    g_Hold = false;
+    WaitForRan(NODES);
+
+    //
+    // The owner goes away with nodes still queued on the
+    // consumer. Its allocator is kept until they are freed
+    //
+    ProduceHeld(owner.get(), NODES);
+    owner->Stop();
+    owner->Wait();
+    dispatch::RemoveDispatcher(owner.get());
+    owner = nullptr;
+    g_Hold = false;
+    WaitForRan(NODES);
+    std::cout << "Consumer freed " << NODES << " nodes of a destroyed owner" << std::endl;
+
+    g_Consumer->Stop();
+    dispatch::GlobalDispatcherWait();
+    g_Consumer = nullptr;
+    std::cout << "End of Main Thread" << std::endl;
+}
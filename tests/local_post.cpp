@@ -0,0 +1,123 @@
+#include <assert.h>
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+#include "DispatchQueue.hpp"
+
+const size_t CHILDREN = 8;
+
+std::thread::id g_Parent;
+std::thread::id g_Children[CHILDREN];
+std::atomic<size_t> g_Finished = 0;
+
+void
+Child(
+    const size_t Index
+)
+{
+    g_Children[Index] = std::this_thread::get_id();
+    g_Finished++;
+}
+
+void
+Parent(
+    void
+)
+/*++
+  Runs on a pool worker and posts its children back to
+  the pool
+--*/
+{
+    g_Parent = std::this_thread::get_id();
+    for (size_t i = 0; i < CHILDREN; i++)
+    {
+        dispatch::PostTask(dispatch::bind(&Child, i));
+    }
+}
+
+void
+RunFamily(
+    dispatch::DispatchPoolPtr Pool
+)
+{
+    g_Finished = 0;
+    Pool->PostTask(dispatch::bind(&Parent));
+    while (g_Finished < CHILDREN)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void
+WaitIdle(
+    dispatch::DispatchPoolPtr Pool
+)
+/*++
+  Every routed task, local or not, is counted off once
+  it returns
+--*/
+{
+    while (true)
+    {
+        size_t total = 0;
+        for (auto load : Pool->GetWorkerLoad())
+        {
+            total += load;
+        }
+        if (total == 0)
+        {
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+int main()
+{
+    //
+    // The parent's queue is empty, so its first children
+    // stay on its own thread
+    //
+    auto pool = dispatch::CreateDispatchPool("local", 2);
+    assert(pool->GetLocalDepth() == dispatch::POOL_LOCAL_DEPTH);
+    RunFamily(pool);
+    for (size_t i = 0; i < dispatch::POOL_LOCAL_DEPTH; i++)
+    {
+        assert(g_Children[i] == g_Parent);
+    }
+    std::cout << "Children posted from a worker stayed local" << std::endl;
+    pool->Stop();
+    pool->Wait();
+
+    //
+    // The same with load routing, the local posts must
+    // count towards the worker's load
+    //
+    dispatch::PoolConfig config;
+    config.m_Size = 2;
+    config.m_Routing = dispatch::PoolRouting::LEAST_LOADED;
+    pool = dispatch::CreateDispatchPool("local routed", config);
+    RunFamily(pool);
+    assert(g_Children[0] == g_Parent);
+    WaitIdle(pool);
+    pool->Stop();
+    pool->Wait();
+
+    //
+    // With a depth of 0 every post is routed. The parent
+    // is still running, so its own worker is the busier
+    // one and the first child goes to the other
+    //
+    config.m_LocalDepth = 0;
+    pool = dispatch::CreateDispatchPool("routed", config);
+    RunFamily(pool);
+    assert(g_Children[0] != g_Parent);
+    WaitIdle(pool);
+    std::cout << "Children were routed with a depth of 0" << std::endl;
+    pool->Stop();
+
+    dispatch::GlobalDispatcherWait();
+    std::cout << "End of Main Thread" << std::endl;
+}
@@ -0,0 +1,239 @@
+#include <assert.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "DispatchQueue.hpp"
+
+const size_t TASK_COUNT = 1000;
+const size_t BURST_SIZE = 100;
+const size_t NORMAL_LANE = 1;
+
+std::atomic<size_t> g_Count = 0;
+
+void
+Count(
+    void
+)
+{
+    g_Count++;
+}
+
+void
+Burst(
+    void
+)
+/*++
+  Queue a burst on our own dispatcher while it is busy
+  running us, so its queue depth has to reach it
+--*/
+{
+    for (size_t i = 0; i < BURST_SIZE; i++)
+    {
+        dispatch::PostTask(dispatch::bind(&Count));
+    }
+}
+
+dispatch::DispatcherMetrics
+WaitForRun(
+    dispatch::DispatcherBase* Dispatcher,
+    const uint64_t Run
+)
+/*++
+  Counters are bumped after a task returns, so poll until
+  the dispatcher has caught up
+--*/
+{
+    auto metrics = Dispatcher->GetMetrics();
+    while (metrics.m_Run < Run)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        metrics = Dispatcher->GetMetrics();
+    }
+    return metrics;
+}
+
+void
+CheckHistogram(
+    void
+)
+{
+    using Histogram = dispatch::LatencyHistogram;
+    for (uint64_t value = 0; value < Histogram::LINEAR; value++)
+    {
+        assert(Histogram::Bucket(value) == value);
+        assert(Histogram::LowerBound(value) == value);
+    }
+    for (uint64_t value = Histogram::LINEAR; value < (2ull << Histogram::MAX_EXPONENT); value = value * 3 / 2 + 1)
+    {
+        auto bucket = Histogram::Bucket(value);
+        assert(bucket < Histogram::BUCKETS);
+        assert(Histogram::LowerBound(bucket) <= value);
+        assert(value - Histogram::LowerBound(bucket) <= value / 8);
+        assert(bucket + 1 == Histogram::BUCKETS || Histogram::LowerBound(bucket + 1) > value);
+    }
+    assert(Histogram::Bucket(UINT64_MAX) == Histogram::BUCKETS - 1);
+
+    Histogram histogram;
+    for (uint64_t value = 1; value <= 100; value++)
+    {
+        histogram.m_Counts[Histogram::Bucket(value * 1000)]++;
+    }
+    assert(histogram.Count() == 100);
+    auto median = histogram.Percentile(0.5);
+    assert(median > 50000 && median <= 50000 * 9 / 8);
+    assert(histogram.Percentile(1.0) > 100000);
+
+    Histogram other;
+    other.Merge(histogram);
+    other.Merge(histogram);
+    assert(other.Count() == 200);
+}
+
+void
+CheckRestarts(
+    void
+)
+/*++
+  A block that is started again, as a retired pool worker
+  is, adds up its busy time over every run
+--*/
+{
+    const auto idle = std::chrono::milliseconds(20);
+    const auto busy = std::chrono::milliseconds(10);
+
+    dispatch::MetricsBlock block;
+    block.Started();
+    std::this_thread::sleep_for(idle);
+    block.Idled(std::chrono::nanoseconds(idle).count());
+    block.Stopped();
+
+    block.Started();
+    std::this_thread::sleep_for(busy);
+    dispatch::DispatcherMetrics metrics;
+    block.Fill(metrics);
+    assert(metrics.m_IdleTime == idle);
+    assert(metrics.m_BusyTime >= busy);
+
+    block.Stopped();
+    auto stopped = metrics.m_BusyTime;
+    std::this_thread::sleep_for(busy);
+    block.Fill(metrics);
+    assert(metrics.m_BusyTime >= stopped);
+    assert(metrics.m_BusyTime < stopped + busy);
+}
+
+void
+CheckElastic(
+    void
+)
+/*++
+  Workers that retire and start again must not lose the
+  time they were busy for, nor count it more than once
+--*/
+{
+    const size_t burst = 200;
+    const auto task = std::chrono::milliseconds(1);
+
+    dispatch::PoolConfig config;
+    config.m_Size = 1;
+    config.m_MaxSize = 2;
+    config.m_GrowWait = std::chrono::microseconds(500);
+    config.m_RetireIdle = std::chrono::milliseconds(20);
+    auto start = std::chrono::steady_clock::now();
+    auto pool = dispatch::CreateDispatchPool("metrics elastic", config);
+
+    g_Count = 0;
+    for (size_t round = 1; round <= 2; round++)
+    {
+        for (size_t i = 0; i < burst; i++)
+        {
+            pool->PostTask(dispatch::bind([task]{
+                std::this_thread::sleep_for(task);
+                g_Count++;
+            }));
+            std::this_thread::sleep_for(task / 4);
+        }
+        while (g_Count < burst * round || pool->GetRunningWorkerCount() > 1)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    auto metrics = pool->GetMetrics();
+    auto wall = std::chrono::steady_clock::now() - start;
+    assert(metrics.m_Dispatchers == 2);
+    assert(metrics.m_Run >= burst * 2);
+    assert(metrics.m_BusyTime >= task * burst * 2);
+    assert(metrics.m_BusyTime + metrics.m_IdleTime <= wall * metrics.m_Dispatchers);
+    std::cout << "Elastic pool busy " << std::chrono::duration_cast<std::chrono::milliseconds>(metrics.m_BusyTime).count()
+              << "ms, idle " << std::chrono::duration_cast<std::chrono::milliseconds>(metrics.m_IdleTime).count()
+              << "ms" << std::endl;
+
+    pool->Stop();
+    pool->Wait();
+}
+
+int main()
+{
+    CheckHistogram();
+#ifndef DISPATCH_NO_METRICS
+    CheckRestarts();
+#endif
+
+#ifndef DISPATCH_NO_METRICS
+    auto dispatcher = dispatch::CreateDispatcher("metrics");
+    for (size_t i = 0; i < TASK_COUNT; i++)
+    {
+        dispatcher->PostTask(dispatch::bind(&Count));
+    }
+    auto metrics = WaitForRun(dispatcher.get(), TASK_COUNT);
+    assert(metrics.m_Name == "metrics");
+    assert(metrics.m_Dispatchers == 1);
+    assert(metrics.m_Posted >= TASK_COUNT);
+    assert(metrics.m_CrossThread >= TASK_COUNT);
+    assert(metrics.m_RunTime.Count() > 0);
+    assert(metrics.m_QueueWait.Count() > 0);
+
+    dispatcher->PostTask(dispatch::bind(&Burst));
+    metrics = WaitForRun(dispatcher.get(), TASK_COUNT + 1 + BURST_SIZE);
+    assert(metrics.m_HighWater[NORMAL_LANE] >= BURST_SIZE);
+    assert(metrics.m_Posted - metrics.m_CrossThread >= BURST_SIZE);
+
+    dispatcher->PostDelayedTask(dispatch::bind(&Count), std::chrono::seconds(60));
+    while (dispatcher->GetMetrics().m_Delayed == 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::cout << "Dispatcher ran " << metrics.m_Run << " tasks, p50 wait "
+              << metrics.m_QueueWait.Percentile(0.5) << "ns, p50 run "
+              << metrics.m_RunTime.Percentile(0.5) << "ns" << std::endl;
+
+    auto pool = dispatch::CreateDispatchPool("metrics pool", 2, dispatch::PoolMode::WORK_STEALING);
+    for (size_t i = 0; i < TASK_COUNT; i++)
+    {
+        pool->PostTask(dispatch::bind(&Count));
+    }
+    auto poolMetrics = WaitForRun(pool.get(), TASK_COUNT);
+    assert(poolMetrics.m_Dispatchers == 2);
+    assert(poolMetrics.m_Run == TASK_COUNT);
+    assert(poolMetrics.m_Unclaimed == 0);
+
+    auto snapshot = dispatch::SnapshotMetrics();
+    assert(snapshot.size() == 2);
+    assert(snapshot[0].m_Name == "metrics");
+    assert(snapshot[1].m_Name == "metrics pool");
+    assert(snapshot[1].m_Dispatchers == 2);
+
+    dispatcher->Stop();
+    pool->Stop();
+    pool->Wait();
+
+    CheckElastic();
+    dispatch::GlobalDispatcherWait();
+#endif
+
+    std::cout << "End of Main Thread" << std::endl;
+}
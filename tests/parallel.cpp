@@ -0,0 +1,110 @@
+#include <assert.h>
+
+#include <atomic>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+
+#define PRIMARY "primary"
+#define POOL "pool"
+#define STEALINGPOOL "stealing pool"
+
+const size_t COUNT = 100000;
+
+dispatch::DispatchPoolPtr g_Pool;
+dispatch::DispatchPoolPtr g_StealingPool;
+
+void
+Check(
+    dispatch::DispatchPool* Pool
+)
+{
+    //
+    // Every index visited exactly once, for a few grains
+    // including the automatic one
+    //
+    for (size_t grain : { (size_t)0, (size_t)1, (size_t)7, (size_t)1000, COUNT })
+    {
+        std::vector<std::atomic<int>> visits(COUNT);
+        dispatch::ParallelFor(Pool, 0, COUNT, grain, [&visits](size_t i) { visits[i]++; });
+        for (auto& visit : visits)
+        {
+            assert(visit == 1);
+        }
+    }
+
+    //
+    // An empty range and an offset one
+    //
+    dispatch::ParallelFor(Pool, 10, 10, 0, [](size_t i) { assert(false); });
+    std::atomic<size_t> offsetSum = 0;
+    dispatch::ParallelFor(Pool, 100, 200, 3, [&offsetSum](size_t i) { assert(i >= 100 && i < 200); offsetSum += i; });
+    assert(offsetSum == 14950);
+
+    auto sum = dispatch::ParallelReduce(
+        Pool, 0, COUNT, 0, (uint64_t)0,
+        [](size_t i) { return (uint64_t)i; },
+        [](uint64_t Lhs, uint64_t Rhs) { return Lhs + Rhs; }
+    );
+    assert(sum == (uint64_t)COUNT * (COUNT - 1) / 2);
+
+    std::vector<int> input(COUNT);
+    std::iota(input.begin(), input.end(), 0);
+    std::vector<int> output(COUNT);
+    auto end = dispatch::ParallelTransform(Pool, input.begin(), input.end(), output.begin(), 0, [](int Value) { return Value * 2; });
+    assert(end == output.end());
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        assert(output[i] == (int)i * 2);
+    }
+    std::cout << "Parallel loops correct on " << Pool->GetName() << std::endl;
+}
+
+void
+Nested(
+    void
+)
+/*++
+  Loops started from pool workers, with every worker
+  busy in the outer loop, still complete
+--*/
+{
+    std::atomic<size_t> total = 0;
+    dispatch::ParallelFor(
+        g_StealingPool.get(), 0, 8, 1,
+        [&total](size_t Outer) {
+            total += dispatch::ParallelReduce(
+                g_StealingPool.get(), 0, 1000, 10, (size_t)0,
+                [](size_t i) { return i; },
+                [](size_t Lhs, size_t Rhs) { return Lhs + Rhs; }
+            );
+        }
+    );
+    assert(total == 8 * 499500);
+    std::cout << "Nested parallel loops complete" << std::endl;
+}
+
+void
+Start(
+    void
+)
+{
+    assert(dispatch::OnDispatcher(PRIMARY));
+    Check(g_Pool.get());
+    Check(g_StealingPool.get());
+    Nested();
+    dispatch::End();
+}
+
+int main()
+{
+    g_Pool = dispatch::CreateDispatchPool(POOL, 4);
+    g_StealingPool = dispatch::CreateDispatchPool(STEALINGPOOL, 4, dispatch::PoolMode::WORK_STEALING);
+    dispatch::CreateAndEnterDispatcher(PRIMARY, dispatch::bind(&Start));
+    g_Pool->Stop();
+    g_StealingPool->Stop();
+    dispatch::GlobalDispatcherWait();
+    std::cout << "End of Main Thread" << std::endl;
+}
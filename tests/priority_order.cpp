@@ -0,0 +1,209 @@
+#include <assert.h>
+
+#include <deque>
+#include <iostream>
+#include <vector>
+
+#include "DispatchQueue.hpp"
+#include "RingBuffer.hpp"
+#include "RunQueue.hpp"
+
+#define ORDERING "ordering"
+
+//
+// More than a lane's first allocation of 16, so every
+// lane grows while it holds jobs
+//
+const size_t PER_LANE = 40;
+const size_t PUSHED_FRONT = 5;
+
+const dispatch::TaskPriority POSTED[] = {
+    dispatch::TaskPriority::PRIORITY_LOW,
+    dispatch::TaskPriority::PRIORITY_NORMAL,
+    dispatch::TaskPriority::PRIORITY_HIGH
+};
+
+const dispatch::TaskPriority EXPECTED[] = {
+    dispatch::TaskPriority::PRIORITY_HIGH,
+    dispatch::TaskPriority::PRIORITY_NORMAL,
+    dispatch::TaskPriority::PRIORITY_LOW
+};
+
+struct Ran
+{
+    dispatch::TaskPriority m_Priority;
+    size_t m_Index;
+};
+
+std::vector<Ran> g_Ran;
+
+void
+Record(
+    const dispatch::TaskPriority Priority,
+    const size_t Index
+)
+{
+    g_Ran.push_back(Ran{ Priority, Index });
+}
+
+void
+CheckOrder(
+    const size_t First
+)
+/*++
+  Every lane ran in full before the next, each in
+  ascending index from First
+--*/
+{
+    assert(g_Ran.size() == 3 * (PER_LANE + First));
+    size_t position = 0;
+    for (auto priority : EXPECTED)
+    {
+        for (size_t index = 0; index < PER_LANE + First; index++, position++)
+        {
+            assert(g_Ran[position].m_Priority == priority);
+            assert(g_Ran[position].m_Index == index);
+        }
+    }
+}
+
+void
+Check(
+    void
+)
+{
+    //
+    // Posted last at the lowest priority, so we are the
+    // only task not yet recorded
+    //
+    CheckOrder(0);
+    std::cout << "Posts ran by priority, then in post order" << std::endl;
+    dispatch::End();
+}
+
+void
+Post(
+    void
+)
+/*++
+  Runs on the dispatcher, so nothing we post starts
+  until we return. Posted lowest priority first, the
+  reverse of the order they must run in
+--*/
+{
+    auto queue = dispatch::CurrentQueue();
+    for (size_t index = 0; index < PER_LANE; index++)
+    {
+        for (auto priority : POSTED)
+        {
+            queue->PostTask(dispatch::bind(&Record, priority, index), priority);
+        }
+    }
+    queue->PostTask(dispatch::bind(&Check), dispatch::TaskPriority::PRIORITY_LOW);
+}
+
+void
+CheckRunQueue(
+    void
+)
+/*++
+  The same interleaving pushed straight into a run
+  queue, with the first few of each lane pushed to the
+  front afterwards, as expired delayed tasks are, which
+  wraps each lane's head
+--*/
+{
+    g_Ran.clear();
+    dispatch::RunQueue queue;
+    for (size_t index = PUSHED_FRONT; index < PER_LANE + PUSHED_FRONT; index++)
+    {
+        for (auto priority : POSTED)
+        {
+            queue.Push(dispatch::Job(dispatch::bind(&Record, priority, index), priority, nullptr));
+        }
+    }
+    for (size_t index = PUSHED_FRONT; index-- > 0; )
+    {
+        for (auto priority : POSTED)
+        {
+            queue.PushFront(dispatch::Job(dispatch::bind(&Record, priority, index), priority, nullptr));
+        }
+    }
+    assert(queue.Size() == 3 * (PER_LANE + PUSHED_FRONT));
+    while (!queue.Empty())
+    {
+        auto job = queue.Pop();
+        job();
+    }
+    CheckOrder(PUSHED_FRONT);
+    std::cout << "Run queue kept its lanes in order across front pushes" << std::endl;
+}
+
+void
+CheckRingBuffer(
+    void
+)
+/*++
+  Grow a ring buffer whose head has wrapped, at several
+  sizes, against a std::deque doing the same
+--*/
+{
+    dispatch::RingBuffer<size_t> ring;
+    std::deque<size_t> expected;
+    size_t next = 0;
+    size_t grown = 0;
+    for (size_t round = 0; round < 4; round++)
+    {
+        //
+        // Front first so the head wraps to the end of the
+        // storage, then fill past capacity from both ends
+        //
+        auto capacity = ring.Capacity();
+        while (ring.Capacity() == capacity)
+        {
+            if (next % 3 == 0)
+            {
+                ring.PushFront(size_t(next));
+                expected.push_front(next);
+            }
+            else
+            {
+                ring.PushBack(size_t(next));
+                expected.push_back(next);
+            }
+            next++;
+        }
+        grown++;
+        assert(ring.Size() == expected.size());
+        assert(ring.Front() == expected.front());
+
+        //
+        // Pop some so the next round starts from a head
+        // that is neither zero nor where growth left it
+        //
+        auto popped = ring.Size() / 3;
+        for (size_t i = 0; i < popped; i++)
+        {
+            assert(ring.PopFront() == expected.front());
+            expected.pop_front();
+        }
+    }
+    assert(ring.Capacity() == (size_t)16 << (grown - 1));
+    while (!ring.Empty())
+    {
+        assert(ring.PopFront() == expected.front());
+        expected.pop_front();
+    }
+    assert(expected.empty());
+    std::cout << "Ring buffer grew " << grown << " times with a wrapped head" << std::endl;
+}
+
+int main()
+{
+    dispatch::CreateAndEnterDispatcher(ORDERING, dispatch::bind(&Post));
+    CheckRunQueue();
+    CheckRingBuffer();
+
+    dispatch::GlobalDispatcherWait();
+    std::cout << "End of Main Thread" << std::endl;
+}
@@ -0,0 +1,189 @@
+#include <assert.h>
+#include <ctype.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "DispatchQueue.hpp"
+
+#define REACTOR "reactor"
+
+std::atomic<size_t> g_PipeReads = 0;
+std::atomic<bool> g_HangupSeen = false;
+std::atomic<bool> g_DelayedRan = false;
+std::atomic<bool> g_SlowRan = false;
+std::string g_PipeData;
+
+void
+WaitFor(
+    const std::atomic<bool>& Flag
+)
+{
+    while (!Flag)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void
+OnPipeReadable(
+    const int Fd,
+    const uint32_t Events
+)
+{
+    assert(dispatch::OnDispatcher(REACTOR));
+    char buffer[16];
+    auto count = read(Fd, buffer, sizeof(buffer));
+    assert(count > 0);
+    g_PipeData.append(buffer, count);
+    std::cout << "Pipe read \"" << std::string(buffer, count) << "\"" << std::endl;
+    g_PipeReads++;
+}
+
+void
+OnSocketReadable(
+    const int Fd,
+    const uint32_t Events
+)
+/*++
+  Echo whatever arrives back in upper case
+--*/
+{
+    char buffer[64];
+    auto count = read(Fd, buffer, sizeof(buffer));
+    assert(count > 0);
+    for (ssize_t i = 0; i < count; i++)
+    {
+        buffer[i] = toupper(buffer[i]);
+    }
+    auto written = write(Fd, buffer, count);
+    assert(written == count);
+    (void)written;
+}
+
+int main()
+{
+    auto reactor = dispatch::CreateReactorDispatcher(REACTOR);
+
+    //
+    // Pipe: each write should be seen by the handler
+    //
+    int pipeFds[2];
+    auto result = pipe(pipeFds);
+    assert(result == 0);
+    reactor->WatchFd(pipeFds[0], EPOLLIN, &OnPipeReadable);
+    for (auto message : { "one", "two", "three" })
+    {
+        auto expected = g_PipeReads + 1;
+        auto written = write(pipeFds[1], message, strlen(message));
+        assert(written == (ssize_t)strlen(message));
+        (void)written;
+        while (g_PipeReads < expected)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    reactor->UnwatchFd(pipeFds[0]);
+
+    //
+    // Socketpair: round trip through an echo handler
+    //
+    int socketFds[2];
+    result = socketpair(AF_UNIX, SOCK_STREAM, 0, socketFds);
+    assert(result == 0);
+    reactor->WatchFd(socketFds[0], EPOLLIN, &OnSocketReadable);
+    auto written = write(socketFds[1], "ping", 4);
+    assert(written == 4);
+    char reply[5] = {};
+    auto count = read(socketFds[1], reply, 4);
+    assert(count == 4);
+    std::cout << "Socket echoed \"" << reply << "\"" << std::endl;
+    assert(std::string(reply) == "PING");
+
+    //
+    // Hang-up: closing the write end of a pipe is
+    // reported, and the handler can unwatch itself
+    //
+    int hangupFds[2];
+    result = pipe(hangupFds);
+    assert(result == 0);
+    reactor->WatchFd(hangupFds[0], EPOLLIN, [reactor](int Fd, uint32_t Events){
+        if (Events & EPOLLHUP)
+        {
+            std::cout << "Pipe hung up" << std::endl;
+            reactor->UnwatchFd(Fd);
+            g_HangupSeen = true;
+        }
+    });
+    close(hangupFds[1]);
+    WaitFor(g_HangupSeen);
+
+    //
+    // Delayed tasks wake the reactor through its timer
+    //
+    auto start = std::chrono::steady_clock::now();
+    reactor->PostDelayedTask(
+        []{
+            std::cout << "Delayed task" << std::endl;
+            g_DelayedRan = true;
+        },
+        std::chrono::milliseconds(50)
+    );
+    WaitFor(g_DelayedRan);
+    assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+
+    assert(g_PipeData == "onetwothree");
+
+#ifndef DISPATCH_NO_METRICS
+    //
+    // Handlers run while the reactor is parked count as
+    // work, not as idle time
+    //
+    const auto slow = std::chrono::milliseconds(100);
+    int slowFds[2];
+    result = pipe(slowFds);
+    assert(result == 0);
+    reactor->WatchFd(slowFds[0], EPOLLIN, [reactor, slow](int Fd, uint32_t Events){
+        char byte;
+        auto count = read(Fd, &byte, 1);
+        assert(count == 1);
+        (void)count;
+        std::this_thread::sleep_for(slow);
+        reactor->UnwatchFd(Fd);
+        g_SlowRan = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    auto before = reactor->GetMetrics();
+    start = std::chrono::steady_clock::now();
+    written = write(slowFds[1], "x", 1);
+    assert(written == 1);
+    WaitFor(g_SlowRan);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    auto after = reactor->GetMetrics();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    assert(after.m_Run > before.m_Run);
+    assert(after.m_Posted > before.m_Posted);
+    assert(after.m_BusyTime - before.m_BusyTime >= slow);
+    assert(after.m_IdleTime - before.m_IdleTime <= elapsed - slow);
+    assert(after.m_Posted == after.m_Run);
+    close(slowFds[0]);
+    close(slowFds[1]);
+    std::cout << "Slow handler counted as busy" << std::endl;
+#endif
+
+    reactor->Stop();
+    dispatch::GlobalDispatcherWait();
+
+    for (auto fd : { pipeFds[0], pipeFds[1], socketFds[0], socketFds[1], hangupFds[0] })
+    {
+        close(fd);
+    }
+
+    std::cout << "End of Main Thread" << std::endl;
+}
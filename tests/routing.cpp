@@ -0,0 +1,141 @@
+#include <assert.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "DispatchQueue.hpp"
+
+const size_t QUICK_TASKS = 100;
+
+std::atomic<bool> g_Release = false;
+std::atomic<bool> g_Blocked = false;
+std::atomic<size_t> g_Quick = 0;
+
+void
+Block(
+    void
+)
+/*++
+  Holds its worker until released, like a task stuck
+  on a slow call
+--*/
+{
+    g_Blocked = true;
+    while (!g_Release)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void
+Quick(
+    void
+)
+{
+    g_Quick++;
+}
+
+void
+WaitLoad(
+    dispatch::DispatchPoolPtr Pool,
+    const size_t Load
+)
+/*++
+  A task is counted off only after it returns, so wait
+  for the pool's total load to settle
+--*/
+{
+    while (true)
+    {
+        size_t total = 0;
+        for (auto load : Pool->GetWorkerLoad())
+        {
+            total += load;
+        }
+        if (total == Load)
+        {
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void
+CheckAvoidsStuckWorker(
+    const char* Name,
+    const dispatch::PoolRouting Routing
+)
+/*++
+  With one worker of two stuck, tasks posted one after
+  another must all go to the other one
+--*/
+{
+    dispatch::PoolConfig config;
+    config.m_Size = 2;
+    config.m_Routing = Routing;
+    auto pool = dispatch::CreateDispatchPool(Name, config);
+    assert(pool->GetRouting() == Routing);
+
+    g_Release = false;
+    g_Blocked = false;
+    g_Quick = 0;
+    pool->PostTask(dispatch::bind(&Block));
+    while (!g_Blocked)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    for (size_t i = 0; i < QUICK_TASKS; i++)
+    {
+        pool->PostTask(dispatch::bind(&Quick));
+        WaitLoad(pool, 1);
+    }
+    assert(g_Quick == QUICK_TASKS);
+
+    //
+    // Batches are routed by load too, and every task
+    // routed is counted off again when it finishes
+    //
+    g_Release = true;
+    dispatch::TaskBatch batch;
+    for (size_t i = 0; i < QUICK_TASKS; i++)
+    {
+        batch.push_back(dispatch::bind(&Quick));
+    }
+    pool->PostTasks(std::move(batch));
+    WaitLoad(pool, 0);
+    assert(g_Quick == 2 * QUICK_TASKS);
+
+    std::cout << Name << " routed around a stuck worker" << std::endl;
+    pool->Stop();
+    pool->Wait();
+}
+
+int main()
+{
+    CheckAvoidsStuckWorker("two choices", dispatch::PoolRouting::TWO_CHOICES);
+    CheckAvoidsStuckWorker("least loaded", dispatch::PoolRouting::LEAST_LOADED);
+
+    //
+    // Round-robin does no accounting at all
+    //
+    auto pool = dispatch::CreateDispatchPool("round robin", 2);
+    assert(pool->GetRouting() == dispatch::PoolRouting::ROUND_ROBIN);
+    g_Quick = 0;
+    for (size_t i = 0; i < QUICK_TASKS; i++)
+    {
+        pool->PostTask(dispatch::bind(&Quick));
+    }
+    auto load = pool->GetWorkerLoad();
+    assert(load[0] == 0 && load[1] == 0);
+    while (g_Quick < QUICK_TASKS)
+    {
+        std::this_thread::yield();
+    }
+    pool->Stop();
+    dispatch::GlobalDispatcherWait();
+
+    std::cout << "End of Main Thread" << std::endl;
+}
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <memory>
 #include <string>
 
 #include "DispatchQueue.hpp"
@@ -35,6 +36,48 @@ DoBound(
     );
 }
 
+size_t g_Allocated = 0;
+size_t g_Destroyed = 0;
+
+template <typename T>
+struct CountingAllocator
+{
+    using value_type = T;
+
+    CountingAllocator(void) = default;
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>&) {};
+
+    T*
+    allocate(
+        size_t Count
+    )
+    {
+        g_Allocated++;
+        return std::allocator<T>().allocate(Count);
+    }
+
+    void
+    deallocate(
+        T* Allocation,
+        size_t Count
+    )
+    {
+        g_Allocated--;
+        std::allocator<T>().deallocate(Allocation, Count);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>&) const { return true; };
+};
+
+struct Tracked
+{
+    Tracked(int Value) : m_Value(Value) {};
+    ~Tracked(void) { g_Destroyed++; };
+    int m_Value;
+};
+
 void
 MainLoop()
 {
@@ -112,6 +155,42 @@ int main()
     assert(ptr_copy_2.get() == nullptr);
     assert(ptr_copy_2.refs() == 0);
 
+    //
+    // MakeSharedRefPtr puts the object in the same
+    // allocation as its count
+    //
+    auto manager = (char*)ptr.get_manager();
+    auto object = (char*)ptr.get();
+    assert(object > manager && object < manager + 64);
+    assert(*ptr == "TestPtr");
+
+    //
+    // The raw pointer path still owns a separate object
+    //
+    {
+        dispatch::SharedRefPtr<Tracked> raw(new Tracked(1));
+        auto rawCopy = raw;
+        assert(raw == rawCopy && raw.refs() == 2);
+        assert(raw->m_Value == 1);
+    }
+    assert(g_Destroyed == 1);
+
+    //
+    // Blocks come from a supplied allocator, and go back
+    // to it along with the object
+    //
+    {
+        auto counted = dispatch::AllocateSharedRefPtr<Tracked>(CountingAllocator<Tracked>(), 2);
+        assert(g_Allocated == 1);
+        assert(counted->m_Value == 2);
+        auto copy = counted;
+        counted = nullptr;
+        assert(g_Allocated == 1 && g_Destroyed == 1);
+        assert(copy != nullptr && counted == nullptr);
+    }
+    assert(g_Allocated == 0);
+    assert(g_Destroyed == 2);
+
     //
     // Create the dispatchers
     //
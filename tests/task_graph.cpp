@@ -0,0 +1,130 @@
+#include <assert.h>
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "DispatchQueue.hpp"
+
+#define PRIMARY "primary"
+#define POOL "pool"
+#define STEALINGPOOL "stealing pool"
+
+const size_t RUNS = 50;
+
+dispatch::DispatchPoolPtr g_Pool;
+dispatch::DispatchPoolPtr g_StealingPool;
+
+//
+// parse -> {index, compress} -> publish, each stage
+// checking that the ones before it have finished
+//
+std::atomic<int> g_Parsed;
+std::atomic<int> g_Indexed;
+std::atomic<int> g_Compressed;
+std::atomic<int> g_Published;
+
+dispatch::TaskGraph g_Graph;
+size_t g_Runs;
+
+void
+BuildGraph(
+    void
+)
+{
+    auto parse = g_Graph.AddNode([]{ g_Parsed++; });
+    auto index = g_Graph.AddNode([]{ assert(g_Parsed == g_Indexed + 1); g_Indexed++; });
+    auto compress = g_Graph.AddNode([]{ assert(g_Parsed == g_Compressed + 1); g_Compressed++; });
+    auto publish = g_Graph.AddNode(
+        []{
+            assert(g_Indexed == g_Published + 1);
+            assert(g_Compressed == g_Published + 1);
+            g_Published++;
+        }
+    );
+    g_Graph.AddEdge(parse, index);
+    g_Graph.AddEdge(parse, compress);
+    g_Graph.AddEdge(index, publish);
+    g_Graph.AddEdge(compress, publish);
+}
+
+void
+RunOnPool(
+    dispatch::DispatchPool* Pool
+)
+/*++
+  Run the graph from outside any dispatcher, waiting
+  for each run
+--*/
+{
+    for (size_t run = 0; run < RUNS; run++)
+    {
+        g_Graph.Run(Pool);
+        g_Graph.Wait();
+    }
+    std::cout << "Ran graph " << RUNS << " times on " << Pool->GetName() << std::endl;
+}
+
+void
+RunFromDispatcher(
+    void
+)
+/*++
+  Rerun the graph from its completion callback, which
+  comes back to this dispatcher
+--*/
+{
+    assert(dispatch::OnDispatcher(PRIMARY));
+    assert(!g_Graph.Running());
+    if (g_Runs++ == RUNS)
+    {
+        std::cout << "Ran graph " << RUNS << " times from " PRIMARY << std::endl;
+        dispatch::End();
+        return;
+    }
+    g_Graph.Run(g_StealingPool.get(), &RunFromDispatcher);
+}
+
+void
+RunAndDestroy(
+    dispatch::DispatchPool* Pool
+)
+/*++
+  Destroy each graph as soon as its run is seen to
+  finish, while the last worker may still be returning
+  from it
+--*/
+{
+    std::atomic<size_t> ran = 0;
+    for (size_t run = 0; run < RUNS; run++)
+    {
+        auto graph = std::make_unique<dispatch::TaskGraph>();
+        auto first = graph->AddNode([&ran]{ ran++; });
+        auto second = graph->AddNode([&ran]{ ran++; });
+        graph->AddEdge(first, second);
+        graph->Run(Pool);
+        graph = nullptr;
+    }
+    assert(ran == 2 * RUNS);
+    std::cout << "Destroyed " << RUNS << " graphs as they finished on " << Pool->GetName() << std::endl;
+}
+
+int main()
+{
+    g_Pool = dispatch::CreateDispatchPool(POOL, 4);
+    g_StealingPool = dispatch::CreateDispatchPool(STEALINGPOOL, 4, dispatch::PoolMode::WORK_STEALING);
+    BuildGraph();
+
+    RunOnPool(g_Pool.get());
+    RunOnPool(g_StealingPool.get());
+    RunAndDestroy(g_Pool.get());
+    RunAndDestroy(g_StealingPool.get());
+    dispatch::CreateAndEnterDispatcher(PRIMARY, dispatch::bind(&RunFromDispatcher));
+    assert(g_Published == 3 * RUNS);
+
+    g_Pool->Stop();
+    g_StealingPool->Stop();
+    dispatch::GlobalDispatcherWait();
+    std::cout << "End of Main Thread" << std::endl;
+}
@@ -0,0 +1,255 @@
+#include <assert.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "DispatchQueue.hpp"
+
+const size_t REQUEST_COUNT = 10;
+const size_t THREAD_COUNT = 8;
+const char* TRACE_PATH = "trace_test.json";
+
+std::atomic<size_t> g_Replies = 0;
+
+void
+Work(
+    void
+)
+{
+}
+
+void
+Reply(
+    void
+)
+{
+    g_Replies++;
+}
+
+size_t
+CountOf(
+    const std::string& Haystack,
+    const std::string& Needle
+)
+{
+    size_t count = 0;
+    for (auto position = Haystack.find(Needle); position != std::string::npos; position = Haystack.find(Needle, position + 1))
+    {
+        count++;
+    }
+    return count;
+}
+
+std::set<std::string>
+BindIds(
+    const std::string& Trace,
+    const std::string& Direction
+)
+/*++
+  The bind ids of every event flowing in or out
+--*/
+{
+    std::set<std::string> ids;
+    std::istringstream lines(Trace);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        if (line.find("\"flow_" + Direction + "\":true") == std::string::npos)
+        {
+            continue;
+        }
+        auto start = line.find("\"bind_id\":\"") + 11;
+        ids.insert(line.substr(start, line.find('"', start) - start));
+    }
+    return ids;
+}
+
+void
+Requester(
+    dispatch::DispatcherBasePtr Responder
+)
+{
+    for (size_t i = 0; i < REQUEST_COUNT; i++)
+    {
+        Responder->PostTaskAndReply(dispatch::bind(&Work), dispatch::bind(&Reply));
+    }
+}
+
+std::string
+ReadTrace(
+    void
+)
+{
+    auto written = dispatch::DumpTrace(TRACE_PATH);
+    assert(written);
+    std::ifstream file(TRACE_PATH);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    remove(TRACE_PATH);
+    (void)written;
+    return contents.str();
+}
+
+std::string
+ThreadId(
+    const std::string& Trace,
+    const std::string& Name
+)
+/*++
+  The tid the thread called Name is written under, empty
+  if it is not in the trace
+--*/
+{
+    auto name = Trace.find("\"args\":{\"name\":\"" + Name + "\"}");
+    if (name == std::string::npos)
+    {
+        return "";
+    }
+    auto start = Trace.rfind("\"tid\":", name) + 6;
+    return Trace.substr(start, Trace.find(',', start) - start);
+}
+
+size_t
+TasksOn(
+    const std::string& Trace,
+    const std::string& ThreadId
+)
+{
+    return CountOf(Trace, "\"ph\":\"B\",\"pid\":1,\"tid\":" + ThreadId + ",");
+}
+
+bool
+Flowed(
+    const std::string& Trace
+)
+/*++
+  Every task slice has the post or reply it came from.
+  Posts may have none, Stop drops what is left unrun
+--*/
+{
+    auto in = BindIds(Trace, "in");
+    auto out = BindIds(Trace, "out");
+    return std::includes(out.begin(), out.end(), in.begin(), in.end());
+}
+
+void
+ShortLived(
+    const std::string& Name
+)
+/*++
+  A dispatcher whose thread traces one task and exits
+--*/
+{
+    auto dispatcher = dispatch::CreateDispatcher(Name);
+    dispatcher->PostTask(dispatch::bind(&Work));
+    dispatcher->Stop();
+    dispatcher->Wait();
+    dispatch::RemoveDispatcher(dispatcher.get());
+}
+
+int main()
+{
+    auto requester = dispatch::CreateDispatcher("requester");
+    auto responder = dispatch::CreateDispatcher("responder");
+
+    dispatch::StartTracing();
+    requester->PostTask(dispatch::bind(&Requester, responder));
+    while (g_Replies < REQUEST_COUNT)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    dispatch::StopTracing();
+
+    //
+    // Posted with tracing off, so never recorded
+    //
+    requester->PostTask(dispatch::bind(&Work));
+
+    requester->Stop();
+    responder->Stop();
+    dispatch::GlobalDispatcherWait();
+
+    auto trace = ReadTrace();
+
+    assert(trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[") == 0);
+
+#ifndef DISPATCH_NO_TRACE
+    assert(trace.find("\"name\":\"requester\"") != std::string::npos);
+    assert(trace.find("\"name\":\"responder\"") != std::string::npos);
+
+    //
+    // The first task, its requests and their replies
+    //
+    assert(CountOf(trace, "\"name\":\"post\"") == 1 + REQUEST_COUNT);
+    assert(CountOf(trace, "\"name\":\"reply\"") == REQUEST_COUNT);
+    assert(CountOf(trace, "\"ph\":\"B\"") == 1 + 2 * REQUEST_COUNT);
+    assert(CountOf(trace, "\"ph\":\"E\"") == 1 + 2 * REQUEST_COUNT);
+
+    //
+    // Every task slice is the end of a flow that started
+    // at a post or a reply
+    //
+    auto out = BindIds(trace, "out");
+    auto in = BindIds(trace, "in");
+    assert(out.size() == 1 + 2 * REQUEST_COUNT);
+    assert(in == out);
+
+    //
+    // Threads that come and go keep their events until
+    // they have been dumped
+    //
+    dispatch::StartTracing();
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+    {
+        ShortLived("short lived " + std::to_string(i));
+    }
+    dispatch::StopTracing();
+    trace = ReadTrace();
+    std::set<std::string> threadIds;
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+    {
+        auto threadId = ThreadId(trace, "short lived " + std::to_string(i));
+        assert(!threadId.empty());
+        assert(TasksOn(trace, threadId) >= 1);
+        threadIds.insert(threadId);
+    }
+    assert(threadIds.size() == THREAD_COUNT);
+    assert(Flowed(trace));
+
+    //
+    // Once dumped their buffers are handed on, each under
+    // a thread id of its own
+    //
+    auto threads = CountOf(trace, "\"thread_name\"");
+    dispatch::StartTracing();
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+    {
+        ShortLived("handed on " + std::to_string(i));
+    }
+    dispatch::StopTracing();
+    trace = ReadTrace();
+    assert(CountOf(trace, "\"thread_name\"") == threads);
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+    {
+        auto threadId = ThreadId(trace, "handed on " + std::to_string(i));
+        assert(!threadId.empty());
+        assert(TasksOn(trace, threadId) >= 1);
+        auto added = threadIds.insert(threadId).second;
+        assert(added);
+        (void)added;
+    }
+    assert(Flowed(trace));
+    std::cout << THREAD_COUNT << " exited threads handed their buffers on" << std::endl;
+#endif
+
+    std::cout << "Wrote " << trace.size() << " bytes of trace" << std::endl;
+    std::cout << "End of Main Thread" << std::endl;
+}